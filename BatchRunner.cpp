@@ -0,0 +1,509 @@
+#include "BatchRunner.h"
+#include "worker.h"
+#include "ConfigManager.h"
+#include "NetworkTransport.h"
+#include "LocalApiServer.h"
+#include "WatchController.h"
+#include "ModManifest.h"
+#include "KeyIndex.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <csignal>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+namespace {
+    // Set by Ctrl+C; a signal handler may not touch Qt, so BatchRunner polls it on the main thread
+    std::atomic<bool> interruptRequested{ false };
+
+    void handleInterrupt(int)
+    {
+        interruptRequested = true;
+        // A second Ctrl+C ends the process the usual way
+        std::signal(SIGINT, SIG_DFL);
+    }
+}
+
+BatchRunner::BatchRunner(const BatchOptions& options, QObject* parent)
+    : QObject(parent), options(options)
+{
+    // Same threading model as the GUI: the worker owns its own thread and event loop
+    worker = new Worker();
+    worker->moveToThread(&workerThread);
+    connect(&workerThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &Worker::taskFinished, this, &BatchRunner::handleTaskFinished);
+    connect(worker, &Worker::statusMessage, this, &BatchRunner::handleStatusMessage);
+    connect(worker, &Worker::progressUpdated, this, &BatchRunner::handleProgressUpdate);
+    connect(worker, &Worker::metricsUpdated, this, [this](const WorkerMetrics& metrics) { lastMetrics = metrics; });
+    connect(worker, &Worker::logMessage, this, &BatchRunner::writeToLog);
+    workerThread.start();
+}
+
+BatchRunner::~BatchRunner()
+{
+    workerThread.quit();
+    workerThread.wait();
+    if (logFile.isOpen()) logFile.close();
+}
+
+bool BatchRunner::isHeadlessRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cli") == 0 || std::strcmp(argv[i], "--headless") == 0) return true;
+    }
+    return false;
+}
+
+int BatchRunner::runFromCommandLine(int argc, char* argv[])
+{
+#ifdef Q_OS_WIN
+    // The executable uses the Windows subsystem; borrow the parent console for stderr output
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stderr);
+    }
+#endif
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless localisation create + cleanup run (same pipeline as the GUI).");
+    parser.addHelpOption();
+    QCommandLineOption cliOption(QStringList() << "cli" << "headless", "Run without a GUI.");
+    QCommandLineOption outputOption("output", "Output directory (with several mods, each gets a subfolder named after its id). Defaults to the saved Paths/OutputPath.", "dir");
+    QCommandLineOption modsOption("mods", "Comma-separated mod ids from the mod manifest, or 'all'. Defaults to the saved Mods/Active or the first mod.", "ids");
+    QCommandLineOption vanillaOption("vanilla", "Stellaris localisation directory. Defaults to the saved Paths/VanillaPath.", "dir");
+    QCommandLineOption selectionsOption("selections", "Selections JSON (category -> [sheetIds]; with several mods: modId -> selections) or a path to a file containing it. Defaults to each mod's saved selections.", "json|file");
+    QCommandLineOption logOption("log", "Log file path. Defaults to logs/log_<timestamp>.txt.", "file");
+    QCommandLineOption noLogOption("no-log", "Do not write a log file.");
+    QCommandLineOption verboseOption("verbose", "Echo every log line to stderr.");
+    QCommandLineOption watchOption("watch", "Keep running and rebuild incrementally when sheets, vanilla files or static_localisation change.");
+    QCommandLineOption pollIntervalOption("poll-interval", "Watch mode: seconds between sheet checks (0 disables polling). Defaults to the saved Watch/PollIntervalSec or 60.", "sec");
+    QCommandLineOption fullExportOption("full-export", "Fetch every selected sheet instead of only those whose revision changed.");
+    QCommandLineOption sheetCacheOption("sheet-cache", "Directory of the per-sheet cache used by the delta export. Defaults to cache/sheets.", "dir");
+    QCommandLineOption validateUtf8Option("validate-utf8", "Cleanup: check every vanilla file for invalid UTF-8 and log the ones that fail.");
+    QCommandLineOption includeOption("include", "Cleanup: glob of vanilla files to clean, searched in subfolders too (repeatable). Defaults to the saved Cleanup/IncludeGlobs or *.yml.", "glob");
+    QCommandLineOption excludeOption("exclude", "Cleanup: glob of vanilla files or folders to skip (repeatable). Defaults to the saved Cleanup/ExcludeGlobs or the name list files and folders.", "glob");
+    QCommandLineOption noKeyDiffOption("no-key-diff", "Do not write the key diff against the previous run next to the log.");
+    QCommandLineOption planOption("plan", "Compute what the run would change in Output without writing it; the change set goes to the report directory. Defaults to the saved Create/PlanMode or off.");
+    QCommandLineOption findOption("find", "Search the key index of the last create + cleanup run instead of running the pipeline: prints the matching keys with their sheets, lines and vanilla files.", "query");
+    QCommandLineOption findPrefixOption("find-prefix", "--find: match the start of key names instead of any part.");
+    QCommandLineOption reportDirOption("report-dir", "Directory for the coverage report (a subfolder per mod). Defaults to the saved Reports/Directory or reports; an empty value turns it off.", "dir");
+    QCommandLineOption maxRequestsOption("max-requests", "Most export requests running at once (the scheduler adapts below it). Defaults to the saved Network/MaxConcurrentRequests or 6.", "n");
+    QCommandLineOption requestTimeoutOption("request-timeout", "Seconds before an export request attempt is aborted and retried. Defaults to the saved Network/RequestTimeoutSec or 120.", "sec");
+    QCommandLineOption hedgeBudgetOption("hedge-budget", "Send a duplicate of an export request running past its usual p90 latency, for at most this percentage of requests (0 disables). Defaults to the saved Network/HedgeBudgetPercent or 0.", "percent");
+    QCommandLineOption jsonExportOption("json-export", "Request the row-object JSON export instead of the compact columnar layout.");
+    // Transport: record/replay and the local Apps Script stand-in
+    QCommandLineOption netModeOption("net-mode", "Network mode: live, record or replay.", "mode");
+    QCommandLineOption netDirOption("net-dir", "Directory for recorded responses.", "dir");
+    QCommandLineOption apiUrlOption("api-url", "Send Apps Script requests to this URL instead (e.g. the local stand-in).", "url");
+    QCommandLineOption netLatencyOption("net-latency", "Replay: latency per response in ms.", "ms");
+    QCommandLineOption netJitterOption("net-jitter", "Replay: extra random latency up to this many ms.", "ms");
+    QCommandLineOption netBandwidthOption("net-bandwidth", "Replay: bandwidth limit in KB/s.", "kbps");
+    QCommandLineOption netFailRateOption("net-fail-rate", "Replay: probability (0..1) of an injected failure.", "rate");
+    QCommandLineOption netFailStatusOption("net-fail-status", "Replay: HTTP status for injected failures (0 = connection error).", "status");
+    QCommandLineOption netSeedOption("net-seed", "Replay: random seed for latency and failure injection.", "seed");
+    QCommandLineOption serveOption("serve", "Run the local Apps Script stand-in on the given fixtures directory instead of a pipeline run.", "dir");
+    QCommandLineOption portOption("port", "Port for --serve (default 8765).", "port", "8765");
+    QCommandLineOption serveDelayOption("serve-delay", "Processing delay per request for --serve, in ms.", "ms");
+    parser.addOption(cliOption);
+    parser.addOption(outputOption);
+    parser.addOption(modsOption);
+    parser.addOption(vanillaOption);
+    parser.addOption(selectionsOption);
+    parser.addOption(logOption);
+    parser.addOption(noLogOption);
+    parser.addOption(verboseOption);
+    parser.addOption(watchOption);
+    parser.addOption(pollIntervalOption);
+    parser.addOption(fullExportOption);
+    parser.addOption(sheetCacheOption);
+    parser.addOption(reportDirOption);
+    parser.addOption(planOption);
+    parser.addOption(noKeyDiffOption);
+    parser.addOption(findOption);
+    parser.addOption(findPrefixOption);
+    parser.addOption(validateUtf8Option);
+    parser.addOption(includeOption);
+    parser.addOption(excludeOption);
+    parser.addOption(maxRequestsOption);
+    parser.addOption(requestTimeoutOption);
+    parser.addOption(hedgeBudgetOption);
+    parser.addOption(jsonExportOption);
+    parser.addOptions({ netModeOption, netDirOption, apiUrlOption, netLatencyOption, netJitterOption, netBandwidthOption,
+        netFailRateOption, netFailStatusOption, netSeedOption, serveOption, portOption, serveDelayOption });
+    parser.process(app);
+
+    if (parser.isSet(serveOption)) {
+        LocalApiServer server(parser.value(serveOption));
+        server.setResponseDelayMs(parser.value(serveDelayOption).toInt());
+        if (!server.listen(static_cast<quint16>(parser.value(portOption).toUInt()))) {
+            std::fprintf(stderr, "ERROR: Could not listen on port %s\n", qUtf8Printable(parser.value(portOption)));
+            return ExitUsage;
+        }
+        std::fprintf(stderr, "Serving %s at %s\n", qUtf8Printable(parser.value(serveOption)), qUtf8Printable(server.endpointUrl()));
+        return app.exec();
+    }
+
+    // Command-line transport settings override the PDG_NET_* environment
+    TransportOptions transport = TransportOptions::fromEnvironment();
+    if (parser.isSet(netModeOption)) transport.mode = TransportOptions::modeFromString(parser.value(netModeOption));
+    if (parser.isSet(netDirOption)) transport.directory = parser.value(netDirOption);
+    if (parser.isSet(apiUrlOption)) transport.endpointOverride = parser.value(apiUrlOption);
+    if (parser.isSet(netLatencyOption)) transport.latencyMs = parser.value(netLatencyOption).toInt();
+    if (parser.isSet(netJitterOption)) transport.jitterMs = parser.value(netJitterOption).toInt();
+    if (parser.isSet(netBandwidthOption)) transport.bandwidthBytesPerSec = parser.value(netBandwidthOption).toLongLong() * 1024;
+    if (parser.isSet(netFailRateOption)) transport.failureRate = parser.value(netFailRateOption).toDouble();
+    if (parser.isSet(netFailStatusOption)) transport.failureStatus = parser.value(netFailStatusOption).toInt();
+    if (parser.isSet(netSeedOption)) transport.seed = parser.value(netSeedOption).toUInt();
+    NetworkTransport::setDefaultOptions(transport);
+
+    // Fall back to the GUI's saved configuration for anything not given explicitly
+    ConfigManager config;
+    BatchOptions options;
+    const QString outputPath = parser.isSet(outputOption) ? parser.value(outputOption) : config.loadSetting("Paths/OutputPath", "").toString();
+    options.vanillaPath = parser.isSet(vanillaOption) ? parser.value(vanillaOption) : config.loadSetting("Paths/VanillaPath", "").toString();
+    options.verbose = parser.isSet(verboseOption);
+    options.watch = parser.isSet(watchOption);
+    options.pollIntervalSec = parser.isSet(pollIntervalOption) ? parser.value(pollIntervalOption).toInt()
+        : config.loadSetting("Watch/PollIntervalSec", options.pollIntervalSec).toInt();
+    options.deltaExport = !parser.isSet(fullExportOption) && config.loadSetting("Create/DeltaExport", true).toBool();
+    options.sheetCacheDir = parser.isSet(sheetCacheOption) ? parser.value(sheetCacheOption)
+        : config.loadSetting("Create/SheetCacheDir", options.sheetCacheDir).toString();
+    options.validateUtf8 = parser.isSet(validateUtf8Option) || config.loadSetting("Cleanup/ValidateUtf8", false).toBool();
+    options.vanillaInclude = parser.isSet(includeOption) ? parser.values(includeOption)
+        : config.loadSetting("Cleanup/IncludeGlobs", options.vanillaInclude).toStringList();
+    options.vanillaExclude = parser.isSet(excludeOption) ? parser.values(excludeOption)
+        : config.loadSetting("Cleanup/ExcludeGlobs", options.vanillaExclude).toStringList();
+    options.reportDir = parser.isSet(reportDirOption) ? parser.value(reportDirOption)
+        : config.loadSetting("Reports/Directory", options.reportDir).toString();
+    options.maxRequests = parser.isSet(maxRequestsOption) ? parser.value(maxRequestsOption).toInt()
+        : config.loadSetting("Network/MaxConcurrentRequests", options.maxRequests).toInt();
+    options.requestTimeoutSec = parser.isSet(requestTimeoutOption) ? parser.value(requestTimeoutOption).toInt()
+        : config.loadSetting("Network/RequestTimeoutSec", options.requestTimeoutSec).toInt();
+    options.hedgeBudgetPercent = parser.isSet(hedgeBudgetOption) ? parser.value(hedgeBudgetOption).toInt()
+        : config.loadSetting("Network/HedgeBudgetPercent", options.hedgeBudgetPercent).toInt();
+    options.compactExport = !parser.isSet(jsonExportOption) && config.loadSetting("Network/CompactExport", true).toBool();
+    options.planMode = parser.isSet(planOption) || config.loadSetting("Create/PlanMode", false).toBool();
+
+    // Which mods to build
+    const ModManifest& manifest = ModManifest::instance();
+    if (!manifest.loadError().isEmpty()) std::fprintf(stderr, "WARNING: %s (using the built-in mod list)\n", qUtf8Printable(manifest.loadError()));
+    QList<const ModDefinition*> mods;
+    const QString modsValue = parser.isSet(modsOption) ? parser.value(modsOption) : config.loadSetting("Mods/Active", "").toString();
+    if (modsValue.compare("all", Qt::CaseInsensitive) == 0) {
+        for (const ModDefinition& mod : manifest.mods()) mods << &mod;
+    }
+    else if (!modsValue.isEmpty()) {
+        for (const QString& id : modsValue.split(',', Qt::SkipEmptyParts)) {
+            const ModDefinition* mod = manifest.findById(id.trimmed());
+            if (!mod) {
+                std::fprintf(stderr, "ERROR: Unknown mod '%s' (known: %s)\n", qUtf8Printable(id.trimmed()), qUtf8Printable(manifest.ids().join(", ")));
+                return ExitUsage;
+            }
+            if (!mods.contains(mod)) mods << mod;
+        }
+    }
+    if (mods.isEmpty() && manifest.defaultMod()) mods << manifest.defaultMod();
+    if (mods.isEmpty()) {
+        std::fprintf(stderr, "ERROR: The mod manifest defines no mods.\n");
+        return ExitUsage;
+    }
+    if (parser.isSet(findOption)) {
+        return findKeys(mods, options.sheetCacheDir, parser.value(findOption), parser.isSet(findPrefixOption));
+    }
+    if (options.watch && options.planMode) {
+        std::fprintf(stderr, "ERROR: --plan and --watch cannot be combined.\n");
+        return ExitUsage;
+    }
+    if (options.watch && mods.size() > 1) {
+        std::fprintf(stderr, "ERROR: --watch builds a single mod; pass one id to --mods.\n");
+        return ExitUsage;
+    }
+
+    QString selectionsArg;
+    if (parser.isSet(selectionsOption)) {
+        const QString value = parser.value(selectionsOption);
+        QFileInfo info(value);
+        if (info.isFile()) {
+            QFile file(value);
+            if (!file.open(QIODevice::ReadOnly)) {
+                std::fprintf(stderr, "ERROR: Could not read selections file: %s\n", qUtf8Printable(value));
+                return ExitUsage;
+            }
+            selectionsArg = QString::fromUtf8(file.readAll());
+        }
+        else {
+            selectionsArg = value;
+        }
+    }
+    const QJsonObject selectionsByMod = QJsonDocument::fromJson(selectionsArg.toUtf8()).object();
+
+    if (outputPath.isEmpty() || options.vanillaPath.isEmpty()) {
+        std::fprintf(stderr, "ERROR: Output and vanilla paths are required (--output, --vanilla).\n");
+        return ExitUsage;
+    }
+    for (const ModDefinition* mod : mods) {
+        BatchModRun run;
+        run.modType = mod->modType;
+        run.modId = mod->id;
+        run.staticPath = mod->staticPath;
+        run.outputPath = mods.size() > 1 ? QDir(outputPath).filePath(mod->id) : outputPath;
+        if (selectionsArg.isEmpty()) {
+            run.selectionsJson = config.loadSetting(mod->selectionsKey(), "{}").toString();
+        }
+        else if (mods.size() > 1) {
+            run.selectionsJson = QString::fromUtf8(QJsonDocument(selectionsByMod.value(mod->id).toObject()).toJson(QJsonDocument::Compact));
+        }
+        else {
+            run.selectionsJson = selectionsArg;
+        }
+        if (!QJsonDocument::fromJson(run.selectionsJson.toUtf8()).isObject()) {
+            std::fprintf(stderr, "ERROR: Selections for %s are not a JSON object.\n", qUtf8Printable(mod->id));
+            return ExitUsage;
+        }
+        options.mods << run;
+    }
+
+    if (!parser.isSet(noLogOption)) {
+        if (parser.isSet(logOption)) {
+            options.logFilePath = parser.value(logOption);
+        }
+        else {
+            QDir("logs").mkpath(".");
+            options.logFilePath = "logs/log_" + QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + ".txt";
+        }
+    }
+    // Next to the log, or in logs/ without one
+    if (!parser.isSet(noKeyDiffOption) && config.loadSetting("Reports/KeyDiff", true).toBool()) {
+        options.keyDiffDir = options.logFilePath.isEmpty() ? QString("logs") : QFileInfo(options.logFilePath).path();
+    }
+
+    BatchRunner runner(options);
+    std::signal(SIGINT, handleInterrupt);
+    connect(&runner, &BatchRunner::finished, &app, [](int exitCode) { QCoreApplication::exit(exitCode); });
+    QTimer::singleShot(0, &runner, &BatchRunner::start);
+    return app.exec();
+}
+
+int BatchRunner::findKeys(const QList<const ModDefinition*>& mods, const QString& sheetCacheDir, const QString& query, bool prefix)
+{
+    // Enough for a terminal; the count says when there are more
+    const size_t maxResults = 50;
+    bool found = false;
+    for (const ModDefinition* mod : mods) {
+        KeyIndex index;
+        QString error;
+        if (!index.load(KeyIndex::pathFor(sheetCacheDir, mod->id), &error)) {
+            std::fprintf(stderr, "ERROR: %s: %s\n", qUtf8Printable(mod->id), qUtf8Printable(error));
+            continue;
+        }
+        QElapsedTimer timer; timer.start();
+        size_t total = 0;
+        const std::vector<uint32_t> ids = index.search(query, prefix ? KeyIndex::Prefix : KeyIndex::Substring, maxResults, &total);
+        std::fprintf(stderr, "%s: %zu of %zu keys match (%lld ms)\n", qUtf8Printable(mod->id), total, index.keyCount(),
+            static_cast<long long>(timer.elapsed()));
+        for (uint32_t id : ids) std::printf("%s\n\n", qUtf8Printable(index.describe(id)));
+        if (total > ids.size()) std::printf("... %zu more; narrow the query.\n", total - ids.size());
+        found = found || total > 0;
+    }
+    std::fflush(stdout);
+    return found ? ExitSuccess : ExitNoMatch;
+}
+
+void BatchRunner::start()
+{
+    runTimer.start();
+    if (!options.logFilePath.isEmpty()) {
+        logFile.setFileName(options.logFilePath);
+        if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            printLine("WARNING: Could not open log file " + options.logFilePath);
+        }
+    }
+    writeToLog("--- Headless Session Started: " + QDateTime::currentDateTime().toString(Qt::ISODate) + " ---");
+    writeToLog("Vanilla Path: " + options.vanillaPath);
+
+    QMetaObject::invokeMethod(worker, "setDeltaExport", Qt::QueuedConnection, Q_ARG(bool, options.deltaExport));
+    QMetaObject::invokeMethod(worker, "setSheetCacheDirectory", Qt::QueuedConnection, Q_ARG(QString, options.sheetCacheDir));
+    QMetaObject::invokeMethod(worker, "setReportDirectory", Qt::QueuedConnection, Q_ARG(QString, options.reportDir));
+    QMetaObject::invokeMethod(worker, "setKeyDiffDirectory", Qt::QueuedConnection, Q_ARG(QString, options.keyDiffDir));
+    QMetaObject::invokeMethod(worker, "setValidateUtf8", Qt::QueuedConnection, Q_ARG(bool, options.validateUtf8));
+    QMetaObject::invokeMethod(worker, "setVanillaFilter", Qt::QueuedConnection,
+        Q_ARG(QStringList, options.vanillaInclude), Q_ARG(QStringList, options.vanillaExclude));
+    QMetaObject::invokeMethod(worker, "setRequestLimits", Qt::QueuedConnection, Q_ARG(int, options.maxRequests), Q_ARG(int, options.requestTimeoutSec));
+    QMetaObject::invokeMethod(worker, "setHedgeBudget", Qt::QueuedConnection, Q_ARG(int, options.hedgeBudgetPercent));
+    QMetaObject::invokeMethod(worker, "setCompactExport", Qt::QueuedConnection, Q_ARG(bool, options.compactExport));
+    QMetaObject::invokeMethod(worker, "setPlanMode", Qt::QueuedConnection, Q_ARG(bool, options.planMode));
+    // Ctrl+C cancels the run; the signal handler only sets a flag, which is picked up here
+    connect(&interruptTimer, &QTimer::timeout, this, [this]() {
+        if (!interruptRequested.exchange(false) || interrupted) return;
+        interrupted = true;
+        printLine("Interrupted — cancelling (Ctrl+C again quits at once)...");
+        writeToLog("Cancel requested by Ctrl+C.");
+        if (watchController) {
+            // A running cycle ends through cycleFinished
+            const bool cycleRunning = watchController->isCycleRunning();
+            watchController->stop();
+            if (!cycleRunning) emit finished(ExitCancelled);
+            return;
+        }
+        worker->requestCancel();
+    });
+    interruptTimer.start(200);
+
+    // Handshakes overlap with clearing the output folder instead of delaying the first request
+    for (const BatchModRun& run : options.mods) {
+        QMetaObject::invokeMethod(worker, "warmUp", Qt::QueuedConnection, Q_ARG(int, run.modType));
+    }
+
+    if (options.watch) {
+        // Runs until the process is interrupted; every cycle reports its own summary
+        const BatchModRun& run = options.mods.first();
+        writeToLog("Output Path: " + run.outputPath);
+        QMetaObject::invokeMethod(worker, "setSelectionsJson", Qt::QueuedConnection, Q_ARG(QString, run.selectionsJson));
+        watchController = new WatchController(worker, this);
+        connect(watchController, &WatchController::logMessage, this, &BatchRunner::writeToLog);
+        connect(watchController, &WatchController::cycleStarted, this, [this](const QString& reason) {
+            printLine("[watch] Cycle started: " + reason);
+        });
+        connect(watchController, &WatchController::cycleFinished, this, [this](bool success, const QString& summary) {
+            printLine(QString("[watch] %1%2").arg(success ? "" : "ERRORS — ").arg(summary));
+            if (interrupted) emit finished(ExitCancelled);
+        });
+        WatchOptions watchOptions;
+        watchOptions.modType = run.modType;
+        watchOptions.outputPath = run.outputPath;
+        watchOptions.vanillaPath = options.vanillaPath;
+        watchOptions.staticPath = run.staticPath;
+        watchOptions.pollIntervalSec = options.pollIntervalSec;
+        watchController->start(watchOptions);
+        return;
+    }
+
+    startNextMod();
+}
+
+void BatchRunner::startNextMod()
+{
+    currentMod++;
+    if (currentMod >= options.mods.size()) {
+        // Every mod is done: the first failure decides the exit code
+        if (options.mods.size() > 1) {
+            for (const QString& summary : modSummaries) printLine(summary);
+        }
+        printLine(QString("Finished in %1 ms").arg(runTimer.elapsed()));
+        int exitCode = ExitSuccess;
+        for (int code : modExitCodes) {
+            if (code != ExitSuccess) { exitCode = code; break; }
+        }
+        emit finished(exitCode);
+        return;
+    }
+
+    const BatchModRun& run = options.mods.at(currentMod);
+    isCleanupStep = false;
+    lastProgress = -1;
+    lastStatus.clear();
+    if (options.mods.size() > 1) printLine(QString("=== %1 (%2/%3) ===").arg(run.modId).arg(currentMod + 1).arg(options.mods.size()));
+    writeToLog("Mod: " + run.modId);
+    writeToLog("Output Path: " + run.outputPath);
+    QMetaObject::invokeMethod(worker, "setSelectionsJson", Qt::QueuedConnection, Q_ARG(QString, run.selectionsJson));
+    QMetaObject::invokeMethod(worker, "doCreateTask", Qt::QueuedConnection,
+        Q_ARG(int, run.modType),
+        Q_ARG(QString, ""),
+        Q_ARG(QString, run.outputPath),
+        Q_ARG(QString, options.vanillaPath));
+}
+
+void BatchRunner::finishMod(int exitCode)
+{
+    const BatchModRun& run = options.mods.at(currentMod);
+    modExitCodes << exitCode;
+    modSummaries << QString("%1: %2").arg(run.modId).arg(exitCode == ExitSuccess ? "ok" : exitCode == ExitCancelled ? "cancelled"
+        : exitCode == ExitCreateFailed ? "create failed" : "cleanup failed");
+    if (exitCode == ExitCancelled) {
+        // Nothing after a cancellation is started
+        currentMod = static_cast<int>(options.mods.size()) - 1;
+    }
+    startNextMod();
+}
+
+// Mirrors PDG_LocalisationCreator_GUI::handleTaskFinished: cleanup runs only after a successful create
+void BatchRunner::handleTaskFinished(bool success, const QString& message, bool cancelled)
+{
+    writeToLog("Success: " + QString(success ? "True" : "False"));
+    writeToLog("Final Message: " + message);
+    printLine(message);
+    // A Ctrl+C after the task's last cancellation point stops the batch here; the next task would reset the token
+    cancelled = cancelled || interrupted;
+
+    if (!isCleanupStep) {
+        if (!success || cancelled) {
+            finishMod(cancelled ? ExitCancelled : ExitCreateFailed);
+            return;
+        }
+        isCleanupStep = true;
+        lastProgress = -1;
+        const BatchModRun& run = options.mods.at(currentMod);
+        QMetaObject::invokeMethod(worker, "doCleanupTask", Qt::QueuedConnection,
+            Q_ARG(int, run.modType),
+            Q_ARG(QString, ""),
+            Q_ARG(QString, run.outputPath),
+            Q_ARG(QString, options.vanillaPath));
+        return;
+    }
+
+    if (cancelled) finishMod(ExitCancelled);
+    else finishMod(success ? ExitSuccess : ExitCleanupFailed);
+}
+
+void BatchRunner::handleStatusMessage(const QString& message)
+{
+    if (message == lastStatus) return;
+    lastStatus = message;
+    printLine(QString("[%1] %2").arg(phaseName()).arg(message));
+}
+
+void BatchRunner::handleProgressUpdate(int value)
+{
+    // Only print when the percentage moves to keep stderr readable
+    if (value == lastProgress) return;
+    lastProgress = value;
+    QString rates;
+    if (lastMetrics.downloadBytesPerSec > 0) rates += QString(" | %1 KB/s down").arg(lastMetrics.downloadBytesPerSec / 1024.0, 0, 'f', 0);
+    if (lastMetrics.vanillaBytesPerSec > 0) rates += QString(" | %1 MB/s vanilla").arg(lastMetrics.vanillaBytesPerSec / (1024.0 * 1024.0), 0, 'f', 1);
+    if (lastMetrics.filesWritten > 0) rates += QString(" | %1 files").arg(lastMetrics.filesWritten);
+    if (lastMetrics.remainingMs >= 0 && value < 100) rates += " | ~" + WorkerMetrics::formatDuration(lastMetrics.remainingMs) + " left";
+    printLine(QString("[%1] %2%%3").arg(phaseName()).arg(value, 3).arg(rates));
+}
+
+void BatchRunner::writeToLog(const QString& message)
+{
+    if (options.verbose) printLine(message);
+    if (!logFile.isOpen()) return;
+    QTextStream out(&logFile);
+    out.setEncoding(QStringConverter::Utf8);
+    out << "[" << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss") << "] " << message << "\n";
+}
+
+QString BatchRunner::phaseName() const
+{
+    if (options.watch) return "watch";
+    return isCleanupStep ? "cleanup" : "create";
+}
+
+void BatchRunner::printLine(const QString& line)
+{
+    std::fprintf(stderr, "%s\n", qUtf8Printable(line));
+    std::fflush(stderr);
+}
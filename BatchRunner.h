@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QString>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QStringList>
+#include "WorkerMetrics.h"
+#include "VanillaIndex.h"
+
+class Worker;
+struct ModDefinition;
+class WatchController;
+
+// One mod of a headless run
+struct BatchModRun {
+    int modType = 1;
+    QString modId;
+    QString outputPath;
+    QString selectionsJson;   // category -> [sheetIds]
+    QString staticPath = "static_localisation";
+};
+
+// Options for a headless create -> cleanup run
+struct BatchOptions {
+    QList<BatchModRun> mods;  // built one after another on the same worker, sharing its connections and vanilla index
+    QString vanillaPath;
+    QString logFilePath;      // empty disables the log file
+    bool verbose = false;     // echo every worker log line to stderr
+    bool watch = false;       // keep running and rebuild incrementally on changes
+    int pollIntervalSec = 60; // sheet polling interval in watch mode
+    bool deltaExport = true;  // fetch only sheets whose revision changed since the last run
+    QString sheetCacheDir = "cache/sheets";
+    QString reportDir = "reports";     // coverage report root, empty disables it
+    QString keyDiffDir;                // key diff against the previous run, empty disables it
+    bool validateUtf8 = false;         // cleanup checks vanilla files for invalid UTF-8
+    QStringList vanillaInclude = VanillaIndex::Filter::defaultInclude(); // vanilla files the cleanup works on (globs)
+    QStringList vanillaExclude = VanillaIndex::Filter::defaultExclude();
+    int maxRequests = 6;               // concurrent export requests at most
+    int requestTimeoutSec = 120;       // per-attempt timeout of export requests
+    int hedgeBudgetPercent = 0;        // hedged export requests per 100 attempts, 0 disables hedging
+    bool compactExport = true;         // request the columnar export layout
+    bool planMode = false;             // write a change set instead of Output
+};
+
+// Runs the same Worker create -> cleanup pipeline as the GUI, without any widgets.
+// Progress goes to stderr; finished() carries the process exit code.
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Process exit codes reported by the headless mode
+    enum ExitCode {
+        ExitSuccess = 0,
+        ExitCreateFailed = 1,
+        ExitCleanupFailed = 2,
+        ExitCancelled = 3,
+        ExitNoMatch = 4,        // --find: no key index, or no key matched
+        ExitUsage = 64
+    };
+
+    explicit BatchRunner(const BatchOptions& options, QObject* parent = nullptr);
+    ~BatchRunner() override;
+
+    // Parses the command line, runs the pipeline on a QCoreApplication and returns the exit code
+    static int runFromCommandLine(int argc, char* argv[]);
+    // True if argv requests headless mode (checked before any QApplication is created)
+    static bool isHeadlessRequested(int argc, char* argv[]);
+    // --find: prints the keys of each mod's key index matching query, with their details, to stdout
+    static int findKeys(const QList<const ModDefinition*>& mods, const QString& sheetCacheDir, const QString& query, bool prefix);
+
+public slots:
+    // Hands the selections to the worker and starts the create task
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void handleTaskFinished(bool success, const QString& message, bool cancelled);
+    void handleStatusMessage(const QString& message);
+    void handleProgressUpdate(int value);
+    void writeToLog(const QString& message);
+
+private:
+    void printLine(const QString& line);
+    QString phaseName() const;
+    // Starts the create task of the next mod, or reports the batch once every mod is done
+    void startNextMod();
+    void finishMod(int exitCode);
+
+    BatchOptions options;
+    QThread workerThread;
+    Worker* worker = nullptr;
+    WatchController* watchController = nullptr;
+    bool isCleanupStep = false;
+    int currentMod = -1;
+    QList<int> modExitCodes;    // per finished mod
+    QStringList modSummaries;
+    int lastProgress = -1;
+    WorkerMetrics lastMetrics; // appended to the progress lines
+    QString lastStatus;
+    QElapsedTimer runTimer;
+    QFile logFile;
+    QTimer interruptTimer;      // picks up Ctrl+C on the main thread
+    bool interrupted = false;
+};
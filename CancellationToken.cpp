@@ -0,0 +1,29 @@
+#include "CancellationToken.h"
+#include <chrono>
+
+namespace {
+    qint64 steadyNowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+void CancellationToken::cancel()
+{
+    // The first request counts; repeated clicks do not move the start of the measured latency
+    qint64 expected = 0;
+    cancelledAtMs.compare_exchange_strong(expected, steadyNowMs());
+    cancelled.store(true);
+}
+
+void CancellationToken::reset()
+{
+    cancelled.store(false);
+    cancelledAtMs.store(0);
+}
+
+qint64 CancellationToken::sinceCancelMs() const
+{
+    if (!isCancelled()) return -1;
+    return steadyNowMs() - cancelledAtMs.load();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+
+// Cancellation of the running task. cancel() may be called from any thread (the GUI calls it directly while
+// the worker thread is busy); network callbacks and every long CPU loop — parsing, sorting, writing, cleaning —
+// poll isCancelled(), tight loops every POLL_INTERVAL items, so a cancel takes effect within milliseconds.
+class CancellationToken
+{
+public:
+    // Items a tight loop handles between two checks
+    static const int POLL_INTERVAL = 512;
+
+    void cancel();
+    // Clears the flag when a new task starts
+    void reset();
+
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+    // For loops: true every POLL_INTERVAL-th item if cancelled
+    bool isCancelledAt(qsizetype item) const { return item % POLL_INTERVAL == 0 && isCancelled(); }
+    // Milliseconds since the first cancel() of this task, -1 if not cancelled
+    qint64 sinceCancelMs() const;
+
+private:
+    std::atomic<bool> cancelled { false };
+    std::atomic<qint64> cancelledAtMs { 0 };   // steady clock
+};
@@ -0,0 +1,195 @@
+#include "ChangeSet.h"
+#include "ReportFiles.h"
+#include "VanillaIndex.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+
+ChangeSet::ChangeSet(const QString& outputPath)
+    : root(QDir::cleanPath(QFileInfo(outputPath).absoluteFilePath()))
+{
+}
+
+QString ChangeSet::relativePath(const QString& path) const
+{
+    return QDir(root).relativeFilePath(QDir::cleanPath(QFileInfo(path).absoluteFilePath()));
+}
+
+void ChangeSet::setFile(const QString& path, const QByteArray& data, bool textMode, bool keepContent)
+{
+    QByteArray after = data;
+#ifdef Q_OS_WIN
+    // What QIODevice::Text turns the line breaks into
+    if (textMode) after.replace("\n", "\r\n");
+#else
+    Q_UNUSED(textMode);
+#endif
+    const QString relative = relativePath(path);
+    QFile current(path);
+    const bool existed = current.open(QIODevice::ReadOnly);
+    compare(relative, existed ? current.readAll() : QByteArray(), existed, after);
+    if (keepContent) kept.insert(relative, data);
+}
+
+void ChangeSet::copyFile(const QString& path, const QString& sourcePath)
+{
+    QFile source(sourcePath);
+    const QByteArray after = source.open(QIODevice::ReadOnly) ? source.readAll() : QByteArray();
+    QFile current(path);
+    const bool existed = current.open(QIODevice::ReadOnly);
+    compare(relativePath(path), existed ? current.readAll() : QByteArray(), existed, after);
+}
+
+bool ChangeSet::plannedContent(const QString& path, QByteArray& data) const
+{
+    auto it = kept.constFind(relativePath(path));
+    if (it == kept.constEnd()) return false;
+    data = it.value();
+    return true;
+}
+
+std::unordered_map<std::string, size_t> ChangeSet::keyLines(const QByteArray& data)
+{
+    VanillaIndex::File file;
+    VanillaIndex::parseData(data, file);
+    std::unordered_map<std::string, size_t> result;
+    result.reserve(file.keys.size());
+    for (size_t i = 0; i < file.keys.size(); ++i) {
+        if (!file.keys[i].empty()) result[file.keys[i]] = std::hash<std::string_view>()(file.view(i));
+    }
+    return result;
+}
+
+void ChangeSet::compare(const QString& relative, const QByteArray& before, bool existed, const QByteArray& after)
+{
+    FileChange change;
+    change.bytesBefore = existed ? before.size() : -1;
+    change.bytesAfter = after.size();
+    if (existed && before == after) {
+        change.status = Unchanged;
+        files.insert(relative, change);
+        return;
+    }
+    change.status = existed ? Modified : Added;
+    if (relative.endsWith(".yml", Qt::CaseInsensitive)) {
+        const std::unordered_map<std::string, size_t> oldKeys = existed ? keyLines(before) : std::unordered_map<std::string, size_t>();
+        const std::unordered_map<std::string, size_t> newKeys = keyLines(after);
+        for (const auto& entry : newKeys) {
+            auto it = oldKeys.find(entry.first);
+            if (it == oldKeys.end()) change.keysAdded++;
+            else if (it->second != entry.second) change.keysChanged++;
+        }
+        for (const auto& entry : oldKeys) {
+            if (!newKeys.count(entry.first)) change.keysRemoved++;
+        }
+    }
+    files.insert(relative, change);
+}
+
+void ChangeSet::removeFile(const QString& path)
+{
+    QFile current(path);
+    if (!current.open(QIODevice::ReadOnly)) return;
+    const QString relative = relativePath(path);
+    FileChange change;
+    change.status = Removed;
+    change.bytesBefore = current.size();
+    if (relative.endsWith(".yml", Qt::CaseInsensitive)) change.keysRemoved = static_cast<qint64>(keyLines(current.readAll()).size());
+    files.insert(relative, change);
+    kept.remove(relative);
+}
+
+void ChangeSet::finish()
+{
+    QDirIterator it(root, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (!files.contains(relativePath(path))) removeFile(path);
+    }
+}
+
+qint64 ChangeSet::count(Status status) const
+{
+    qint64 n = 0;
+    for (const FileChange& change : files) {
+        if (change.status == status) n++;
+    }
+    return n;
+}
+
+QString ChangeSet::statusName(Status status)
+{
+    switch (status) {
+    case Added: return "added";
+    case Modified: return "modified";
+    case Unchanged: return "unchanged";
+    case Removed: return "removed";
+    }
+    return QString();
+}
+
+QString ChangeSet::summary() const
+{
+    qint64 keysAdded = 0, keysRemoved = 0, keysChanged = 0;
+    for (const FileChange& change : files) {
+        keysAdded += change.keysAdded;
+        keysRemoved += change.keysRemoved;
+        keysChanged += change.keysChanged;
+    }
+    return QString("%1 added, %2 modified, %3 removed, %4 unchanged; keys +%5 -%6 ~%7")
+        .arg(count(Added)).arg(count(Modified)).arg(count(Removed)).arg(count(Unchanged))
+        .arg(keysAdded).arg(keysRemoved).arg(keysChanged);
+}
+
+bool ChangeSet::write(const QString& dir, QString* error) const
+{
+    if (!ReportFiles::ensureDirectory(dir, error)) return false;
+
+    QStringList paths = files.keys();
+    std::sort(paths.begin(), paths.end());
+    QByteArray csv = "path,status,keys_added,keys_removed,keys_changed,bytes_before,bytes_after\n";
+    QJsonArray fileArray;
+    qint64 keysAdded = 0, keysRemoved = 0, keysChanged = 0;
+    for (const QString& path : paths) {
+        const FileChange& change = files.value(path);
+        if (change.status == Unchanged) continue;
+        keysAdded += change.keysAdded;
+        keysRemoved += change.keysRemoved;
+        keysChanged += change.keysChanged;
+        csv += ReportFiles::csvField(path) + ',' + statusName(change.status).toUtf8() + ',' + QByteArray::number(change.keysAdded)
+            + ',' + QByteArray::number(change.keysRemoved) + ',' + QByteArray::number(change.keysChanged)
+            + ',' + QByteArray::number(change.bytesBefore) + ',' + QByteArray::number(change.bytesAfter) + '\n';
+        QJsonObject fileObj;
+        fileObj.insert("path", path);
+        fileObj.insert("status", statusName(change.status));
+        fileObj.insert("keysAdded", change.keysAdded);
+        fileObj.insert("keysRemoved", change.keysRemoved);
+        fileObj.insert("keysChanged", change.keysChanged);
+        fileObj.insert("bytesBefore", change.bytesBefore);
+        fileObj.insert("bytesAfter", change.bytesAfter);
+        fileArray.append(fileObj);
+    }
+
+    QJsonObject totals;
+    totals.insert("added", count(Added));
+    totals.insert("modified", count(Modified));
+    totals.insert("removed", count(Removed));
+    totals.insert("unchanged", count(Unchanged));
+    totals.insert("keysAdded", keysAdded);
+    totals.insert("keysRemoved", keysRemoved);
+    totals.insert("keysChanged", keysChanged);
+    QJsonObject rootObj;
+    rootObj.insert("output", root);
+    rootObj.insert("totals", totals);
+    rootObj.insert("files", fileArray);
+
+    return ReportFiles::writeFile(QDir(dir).filePath("change_set.json"), QJsonDocument(rootObj).toJson(QJsonDocument::Indented), error)
+        && ReportFiles::writeFile(QDir(dir).filePath("change_set.csv"), csv, error);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <string>
+#include <unordered_map>
+
+// What a create + cleanup run would change in Output, for plan mode. The run hands over the bytes it would
+// write (or the files it would copy); each one is compared with the current Output file straight away, so only
+// the counts stay in memory. Output files the run would not produce count as removed, as a real run clears
+// Output first. Nothing under Output is written.
+class ChangeSet
+{
+public:
+    enum Status { Added, Modified, Unchanged, Removed };
+
+    struct FileChange {
+        Status status = Unchanged;
+        qint64 keysAdded = 0;
+        qint64 keysRemoved = 0;
+        qint64 keysChanged = 0;   // same key, different line
+        qint64 bytesBefore = -1;  // -1 if the file does not exist yet
+        qint64 bytesAfter = -1;   // -1 if the file would be removed
+    };
+
+    explicit ChangeSet(const QString& outputPath);
+
+    QString outputPath() const { return root; }
+
+    // The run would write data to path (under Output). textMode: written with QIODevice::Text, as the .yml files are.
+    // keepContent: the bytes stay available to plannedContent(), for files a later step reads back.
+    void setFile(const QString& path, const QByteArray& data, bool textMode, bool keepContent = false);
+    // The run would copy sourcePath to path
+    void copyFile(const QString& path, const QString& sourcePath);
+    // The run would delete path
+    void removeFile(const QString& path);
+    // Bytes kept by setFile for path; false if there are none
+    bool plannedContent(const QString& path, QByteArray& data) const;
+
+    // Marks every current Output file the run would not produce as removed; call once the run is done
+    void finish();
+
+    qint64 count(Status status) const;
+    // "12 added, 30 modified, 2 removed, 410 unchanged; keys +120 -45 ~300"
+    QString summary() const;
+
+    // Writes change_set.json ({"output", "totals", "files": [{path, status, keysAdded, ...}]}, unchanged files
+    // left out) and change_set.csv (path,status,keys_added,keys_removed,keys_changed,bytes_before,bytes_after)
+    // into dir; false with error set if a file could not be written
+    bool write(const QString& dir, QString* error = nullptr) const;
+
+    static QString statusName(Status status);
+
+private:
+    QString relativePath(const QString& path) const;
+    void compare(const QString& relative, const QByteArray& before, bool existed, const QByteArray& after);
+    // key -> hash of its line, for .yml contents
+    static std::unordered_map<std::string, size_t> keyLines(const QByteArray& data);
+
+    QString root;
+    QHash<QString, FileChange> files;     // relative path -> change
+    QHash<QString, QByteArray> kept;      // relative path -> planned bytes (keepContent)
+};
@@ -2,26 +2,100 @@
 #include <QCoreApplication> // For QCoreApplication::applicationDirPath()
 #include <QDir>             // For QDir::separator()
 #include <QDebug>           // For qDebug()
+#include <QFile>
+#include <QSaveFile>
 
 ConfigManager::ConfigManager(QObject* parent)
     : QObject(parent),
-    // Initialize QSettings. You can choose QSettings::IniFormat for plain text.
-    // The file will be in the application's directory.
-    settings(QCoreApplication::applicationDirPath() + QDir::separator() + "config.ini", QSettings::IniFormat)
+    // The file will be in the application's directory (plain text INI).
+    configFilePath(QCoreApplication::applicationDirPath() + QDir::separator() + "config.ini")
 {
-    qDebug() << "Config file path: " << settings.fileName();
+    // Tracing can be switched on without a rebuild for debugging config issues
+    traceEnabled = qEnvironmentVariableIntValue("PDG_CONFIG_TRACE") != 0;
+
+    // Read everything once; later loads are served from memory
+    QSettings settings(configFilePath, QSettings::IniFormat);
+    const QStringList keys = settings.allKeys();
+    cache.reserve(keys.size());
+    for (const QString& key : keys) {
+        cache.insert(key, settings.value(key));
+    }
+    if (traceEnabled) qDebug() << "Config file path: " << configFilePath << " (" << keys.size() << " keys)";
+}
+
+ConfigManager::~ConfigManager()
+{
+    // Never lose changes made inside an unbalanced transaction
+    if (isDirty()) flush();
 }
 
 void ConfigManager::saveSetting(const QString& key, const QVariant& value)
 {
-    settings.setValue(key, value);
-    settings.sync(); // Ensure the changes are written to disk immediately
-    qDebug() << "Saved setting: " << key << " = " << value;
+    auto it = cache.find(key);
+    if (it != cache.end() && it.value() == value) {
+        return; // Unchanged; nothing to write
+    }
+    cache.insert(key, value);
+    dirtyKeys.insert(key);
+    if (traceEnabled) qDebug() << "Saved setting: " << key << " = " << value;
+    if (transactionDepth == 0) {
+        flush();
+    }
 }
 
 QVariant ConfigManager::loadSetting(const QString& key, const QVariant& defaultValue) const
 {
-    QVariant value = settings.value(key, defaultValue);
-    qDebug() << "Loaded setting: " << key << " = " << value << " (Default: " << defaultValue << ")";
+    QVariant value = cache.value(key, defaultValue);
+    if (traceEnabled) qDebug() << "Loaded setting: " << key << " = " << value << " (Default: " << defaultValue << ")";
     return value;
-}
\ No newline at end of file
+}
+
+void ConfigManager::beginTransaction()
+{
+    ++transactionDepth;
+}
+
+bool ConfigManager::commitTransaction()
+{
+    if (transactionDepth > 0) --transactionDepth;
+    if (transactionDepth > 0 || !isDirty()) return true;
+    return flush();
+}
+
+bool ConfigManager::flush()
+{
+    // Let QSettings serialize the INI into a scratch file, then swap the bytes in with QSaveFile
+    // so config.ini is replaced in a single atomic rename and is never seen half-written.
+    const QString tempPath = configFilePath + ".tmp";
+    QFile::remove(tempPath);
+    {
+        QSettings temp(tempPath, QSettings::IniFormat);
+        for (auto it = cache.constBegin(); it != cache.constEnd(); ++it) {
+            temp.setValue(it.key(), it.value());
+        }
+        temp.sync();
+        if (temp.status() != QSettings::NoError) {
+            qDebug() << "ERROR: Failed to serialize config to " << tempPath;
+            QFile::remove(tempPath);
+            return false;
+        }
+    }
+
+    QFile tempFile(tempPath);
+    if (!tempFile.open(QIODevice::ReadOnly)) {
+        qDebug() << "ERROR: Failed to read back " << tempPath;
+        return false;
+    }
+    const QByteArray bytes = tempFile.readAll();
+    tempFile.close();
+    QFile::remove(tempPath);
+
+    QSaveFile out(configFilePath);
+    if (!out.open(QIODevice::WriteOnly) || out.write(bytes) != bytes.size() || !out.commit()) {
+        qDebug() << "ERROR: Failed to write config file " << configFilePath << ": " << out.errorString();
+        return false;
+    }
+    if (traceEnabled) qDebug() << "Committed " << dirtyKeys.size() << " changed setting(s) to " << configFilePath;
+    dirtyKeys.clear();
+    return true;
+}
@@ -3,6 +3,8 @@
 #include <QObject>
 #include <QSettings>
 #include <QVariant>
+#include <QHash>
+#include <QSet>
 
 class ConfigManager : public QObject
 {
@@ -10,13 +12,48 @@ class ConfigManager : public QObject
 
 public:
     explicit ConfigManager(QObject* parent = nullptr);
+    // Flushes any uncommitted changes
+    ~ConfigManager() override;
 
-    // Saves a setting to the config file
+    // Saves a setting. Written to disk immediately unless a transaction is open.
     void saveSetting(const QString& key, const QVariant& value);
 
-    // Loads a setting from the config file. Returns defaultValue if not found.
+    // Loads a setting from the in-memory cache. Returns defaultValue if not found.
     QVariant loadSetting(const QString& key, const QVariant& defaultValue = QVariant()) const;
 
+    // Batches subsequent saveSetting calls until the matching commitTransaction (calls may nest)
+    void beginTransaction();
+    // Closes a transaction; the outermost commit writes all dirty keys in one atomic write
+    bool commitTransaction();
+    // True if there are changes not yet written to disk
+    bool isDirty() const { return !dirtyKeys.isEmpty(); }
+
+    // Enables qDebug tracing of every load/save (off by default)
+    void setTraceEnabled(bool enabled) { traceEnabled = enabled; }
+
+    // Returns the full path of the config file
+    QString fileName() const { return configFilePath; }
+
+private:
+    // Writes the whole cache to a temp file and atomically replaces the config file
+    bool flush();
+
+    QString configFilePath;
+    QHash<QString, QVariant> cache;    // All settings, loaded once at startup
+    QSet<QString> dirtyKeys;           // Keys changed since the last flush
+    int transactionDepth = 0;
+    bool traceEnabled = false;
+};
+
+// RAII helper: opens a transaction for the lifetime of the scope
+class ConfigTransaction
+{
+public:
+    explicit ConfigTransaction(ConfigManager* config) : config(config) { if (config) config->beginTransaction(); }
+    ~ConfigTransaction() { if (config) config->commitTransaction(); }
+    ConfigTransaction(const ConfigTransaction&) = delete;
+    ConfigTransaction& operator=(const ConfigTransaction&) = delete;
+
 private:
-    QSettings settings;
-};
\ No newline at end of file
+    ConfigManager* config;
+};
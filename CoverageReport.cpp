@@ -0,0 +1,183 @@
+#include "CoverageReport.h"
+#include "LocalisationKernels.h"
+#include "ReportFiles.h"
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
+namespace {
+    QString percent(qint64 part, qint64 whole)
+    {
+        return whole > 0 ? QString::number(100.0 * static_cast<double>(part) / static_cast<double>(whole), 'f', 1) : QString("100.0");
+    }
+}
+
+CoverageReport::CoverageReport(const QStringList& languages, const QString& referenceLanguage)
+    : referenceName(referenceLanguage.toLower())
+{
+    for (const QString& lang : languages) languageIndex(lang);
+    languageIndex(referenceName);
+}
+
+int CoverageReport::languageIndex(const QString& lang)
+{
+    const QString name = lang.toLower();
+    auto it = languageIndexes.constFind(name);
+    if (it != languageIndexes.constEnd()) return it.value();
+    if (languageNames.size() >= 64) {
+        if (!droppedLanguages.contains(name)) droppedLanguages << name;
+        return -1;
+    }
+    const int index = static_cast<int>(languageNames.size());
+    languageNames << name;
+    languageIndexes.insert(name, index);
+    if (name == referenceName) referenceIndex = index;
+    return index;
+}
+
+void CoverageReport::addEntries(const QString& category, const QString& lang, const std::vector<std::string>& entries)
+{
+    const int index = languageIndex(lang);
+    if (index < 0) return;
+    const uint64_t bit = uint64_t(1) << index;
+    auto catIt = categories.find(category.toStdString());
+    if (catIt == categories.end()) {
+        catIt = categories.emplace(category.toStdString(), std::unordered_map<std::string, uint64_t>()).first;
+        categoryOrder << category;
+    }
+    std::unordered_map<std::string, uint64_t>& keys = catIt->second;
+    if (keys.empty()) keys.reserve(entries.size());
+    for (const std::string& entry : entries) {
+        const std::string_view key = LocalisationKernels::entryKey(entry);
+        if (key.empty()) continue;
+        keys[std::string(key)] |= bit;
+    }
+}
+
+void CoverageReport::clearCategory(const QString& category)
+{
+    categories.erase(category.toStdString());
+    categoryOrder.removeAll(category);
+}
+
+std::vector<CoverageReport::LanguageCounts> CoverageReport::countCategory(const std::unordered_map<std::string, uint64_t>& keys) const
+{
+    std::vector<LanguageCounts> counts(languageNames.size());
+    const uint64_t refBit = referenceIndex >= 0 ? uint64_t(1) << referenceIndex : 0;
+    for (const auto& key : keys) {
+        const bool inReference = (key.second & refBit) != 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            const bool present = (key.second >> i) & 1;
+            if (present) counts[i].present++;
+            if (inReference && !present) counts[i].missing++;
+            if (!inReference && present) counts[i].extra++;
+        }
+    }
+    return counts;
+}
+
+QStringList CoverageReport::languagesOf(uint64_t mask) const
+{
+    QStringList result;
+    for (int i = 0; i < languageNames.size(); ++i) {
+        if ((mask >> i) & 1) result << languageNames[i];
+    }
+    return result;
+}
+
+bool CoverageReport::write(const QString& dir, QString* error) const
+{
+    if (!ReportFiles::ensureDirectory(dir, error)) return false;
+
+    const uint64_t refBit = referenceIndex >= 0 ? uint64_t(1) << referenceIndex : 0;
+    uint64_t usedMask = 0;
+    for (const auto& category : categories) {
+        for (const auto& key : category.second) usedMask |= key.second;
+    }
+
+    QByteArray summaryCsv = "category,language,keys,present,missing,extra,coverage\n";
+    QByteArray keysCsv = "category,key,status,languages\n";
+    QJsonArray categoryArray;
+    for (const QString& categoryName : categoryOrder) {
+        const auto& keys = categories.at(categoryName.toStdString());
+        const std::vector<LanguageCounts> counts = countCategory(keys);
+        qint64 referenceKeys = 0;
+        for (const auto& key : keys) {
+            if (key.second & refBit) referenceKeys++;
+        }
+
+        QJsonObject languagesObj;
+        for (int i = 0; i < languageNames.size(); ++i) {
+            if (!((usedMask >> i) & 1)) continue; // never seen in this run
+            const LanguageCounts& c = counts[static_cast<size_t>(i)];
+            const QString coverage = percent(referenceKeys - c.missing, referenceKeys);
+            summaryCsv += ReportFiles::csvField(categoryName) + ',' + languageNames[i].toUtf8() + ',' + QByteArray::number(static_cast<qint64>(keys.size()))
+                + ',' + QByteArray::number(c.present) + ',' + QByteArray::number(c.missing) + ',' + QByteArray::number(c.extra)
+                + ',' + coverage.toUtf8() + '\n';
+            languagesObj.insert(languageNames[i], QJsonArray{ c.present, c.missing, c.extra });
+        }
+
+        // Keys sorted so the report diffs cleanly between runs
+        std::vector<const std::pair<const std::string, uint64_t>*> sorted;
+        sorted.reserve(keys.size());
+        for (const auto& key : keys) {
+            if ((key.second & usedMask) != usedMask) sorted.push_back(&key);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+        QJsonObject missingObj;   // key -> languages without it (English has it)
+        QJsonObject noEnglishObj; // key -> languages that have it (English does not)
+        for (const auto* key : sorted) {
+            const bool inReference = (key->second & refBit) != 0;
+            const QStringList langs = languagesOf(inReference ? (usedMask & ~key->second) : key->second);
+            const QString keyName = QString::fromStdString(key->first);
+            keysCsv += ReportFiles::csvField(categoryName) + ',' + ReportFiles::csvField(keyName) + (inReference ? ",missing," : ",no_english,")
+                + langs.join(' ').toUtf8() + '\n';
+            (inReference ? missingObj : noEnglishObj).insert(keyName, QJsonArray::fromStringList(langs));
+        }
+
+        QJsonObject categoryObj;
+        categoryObj.insert("category", categoryName);
+        categoryObj.insert("keys", static_cast<qint64>(keys.size()));
+        categoryObj.insert("referenceKeys", referenceKeys);
+        categoryObj.insert("languages", languagesObj);
+        categoryObj.insert("missing", missingObj);
+        categoryObj.insert("noEnglish", noEnglishObj);
+        categoryArray.append(categoryObj);
+    }
+
+    QJsonObject root;
+    root.insert("reference", referenceName);
+    root.insert("languageColumns", QJsonArray{ "present", "missing", "extra" });
+    root.insert("categories", categoryArray);
+    if (!droppedLanguages.isEmpty()) root.insert("droppedLanguages", QJsonArray::fromStringList(droppedLanguages));
+
+    const QDir out(dir);
+    return ReportFiles::writeFile(out.filePath("coverage_summary.csv"), summaryCsv, error)
+        && ReportFiles::writeFile(out.filePath("coverage_keys.csv"), keysCsv, error)
+        && ReportFiles::writeFile(out.filePath("coverage.json"), QJsonDocument(root).toJson(QJsonDocument::Compact), error);
+}
+
+QStringList CoverageReport::summaryLines() const
+{
+    const uint64_t refBit = referenceIndex >= 0 ? uint64_t(1) << referenceIndex : 0;
+    QStringList lines;
+    for (const QString& categoryName : categoryOrder) {
+        const auto& keys = categories.at(categoryName.toStdString());
+        const std::vector<LanguageCounts> counts = countCategory(keys);
+        qint64 referenceKeys = 0;
+        for (const auto& key : keys) {
+            if (key.second & refBit) referenceKeys++;
+        }
+        QStringList parts;
+        for (int i = 0; i < languageNames.size(); ++i) {
+            const LanguageCounts& c = counts[static_cast<size_t>(i)];
+            if (i == referenceIndex || c.present == 0) continue;
+            parts << QString("%1 %2% (%3 missing)").arg(languageNames[i]).arg(percent(referenceKeys - c.missing, referenceKeys)).arg(c.missing);
+        }
+        lines << QString("%1: %2 keys%3").arg(categoryName).arg(static_cast<qint64>(keys.size())).arg(parts.isEmpty() ? QString() : ", " + parts.join(", "));
+    }
+    return lines;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Key x language presence per category, filled from the entries the create task writes anyway.
+// Every key holds one bit per language, so a category costs one 64-bit word per key and the
+// missing/extra sets fall out of a single pass over the keys.
+class CoverageReport
+{
+public:
+    // Languages are indexed in the order given; English is the reference column
+    explicit CoverageReport(const QStringList& languages = QStringList(), const QString& referenceLanguage = "english");
+
+    // Marks every entry's key as present in lang for the category
+    void addEntries(const QString& category, const QString& lang, const std::vector<std::string>& entries);
+    // Drops what was recorded for a category (e.g. before its entries are recorded again)
+    void clearCategory(const QString& category);
+
+    bool isEmpty() const { return categories.empty(); }
+
+    // Writes coverage_summary.csv (category,language,keys,present,missing,extra,coverage),
+    // coverage_keys.csv (category,key,status,languages) and coverage.json into dir.
+    // Returns false with error set if a file could not be written.
+    bool write(const QString& dir, QString* error = nullptr) const;
+
+    // One line per category: "Main Localisation: 1234 keys, german 98.5% (19 missing), ..."
+    QStringList summaryLines() const;
+
+private:
+    struct LanguageCounts {
+        qint64 present = 0;
+        qint64 missing = 0;   // keys in the reference language but not in this one
+        qint64 extra = 0;     // keys in this language but not in the reference one
+    };
+
+    int languageIndex(const QString& lang);
+    std::vector<LanguageCounts> countCategory(const std::unordered_map<std::string, uint64_t>& keys) const;
+    QStringList languagesOf(uint64_t mask) const;
+
+    QStringList languageNames;
+    QHash<QString, int> languageIndexes;
+    int referenceIndex = -1;
+    QString referenceName;
+    std::unordered_map<std::string, std::unordered_map<std::string, uint64_t>> categories; // category -> key -> language bits
+    QStringList categoryOrder;
+    QStringList droppedLanguages; // beyond the 64 a mask can hold
+};
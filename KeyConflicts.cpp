@@ -0,0 +1,142 @@
+#include "KeyConflicts.h"
+#include "LocalisationKernels.h"
+#include "ReportFiles.h"
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <algorithm>
+#include <functional>
+
+namespace {
+    const char* KIND_NAMES[] = { "duplicate", "conflict", "vanilla_same", "vanilla_override" };
+
+    uint64_t valueHash(std::string_view value)
+    {
+        return static_cast<uint64_t>(std::hash<std::string_view>()(value));
+    }
+
+    // Lookup key of a definition whose value is read back from its category file
+    QString valueId(const QString& path, std::string_view key, uint64_t hash)
+    {
+        return QString("%1|%2|%3").arg(path, QString::fromUtf8(key.data(), static_cast<qsizetype>(key.size()))).arg(hash);
+    }
+}
+
+std::string_view KeyConflicts::entryValue(std::string_view line, size_t keyEnd)
+{
+    const size_t open = line.find('"', keyEnd);
+    const size_t close = line.rfind('"');
+    if (open == std::string_view::npos || close <= open) return line.substr(std::min(keyEnd, line.size()));
+    return line.substr(open, close - open + 1);
+}
+
+uint32_t KeyConflicts::addSource(const QString& category, const QString& sheet, const QString& filePattern)
+{
+    sources.push_back(Source{ category, sheet, filePattern });
+    return static_cast<uint32_t>(sources.size() - 1);
+}
+
+void KeyConflicts::addEntries(uint32_t source, const QString& lang, const std::vector<std::string>& entries)
+{
+    std::unordered_map<std::string, Occurrence>& keys = languageKeys[lang];
+    if (keys.empty()) keys.reserve(entries.size());
+    for (const std::string& entry : entries) {
+        const std::string_view key = LocalisationKernels::entryKey(entry);
+        if (key.empty()) continue;
+        const std::string_view value = entryValue(entry, static_cast<size_t>(key.data() - entry.data()) + key.size());
+        const uint64_t hash = valueHash(value);
+        auto inserted = keys.emplace(std::string(key), Occurrence{ source, hash });
+        if (inserted.second) continue;
+        const Occurrence& first = inserted.first->second;
+        const Kind kind = first.valueHash == hash ? Duplicate : Conflict;
+        findings.push_back(Finding{ kind, lang, inserted.first->first, first.source, first.valueHash, source, std::string(value), QString() });
+        kindCounts[kind]++;
+    }
+}
+
+void KeyConflicts::checkVanilla(const QString& lang, const std::vector<VanillaIndex::File>& files)
+{
+    auto langIt = languageKeys.constFind(lang);
+    if (langIt == languageKeys.constEnd()) return;
+    const std::unordered_map<std::string, Occurrence>& keys = langIt.value();
+    for (const VanillaIndex::File& file : files) {
+        for (size_t i = 0; i < file.keys.size(); ++i) {
+            if (file.keys[i].empty()) continue;
+            auto it = keys.find(file.keys[i]);
+            if (it == keys.end()) continue;
+            const std::string_view line = file.view(i);
+            const size_t keyEnd = line.find(':');
+            const std::string_view value = entryValue(line, keyEnd == std::string_view::npos ? line.size() : keyEnd);
+            const Kind kind = valueHash(value) == it->second.valueHash ? VanillaSame : VanillaOverride;
+            findings.push_back(Finding{ kind, lang, it->first, it->second.source, it->second.valueHash, 0, std::string(value), file.fileName });
+            kindCounts[kind]++;
+        }
+    }
+}
+
+QString KeyConflicts::firstFile(const Finding& finding) const
+{
+    QString path = sources[finding.first].filePattern;
+    return path.replace("<lang>", finding.lang);
+}
+
+QHash<QString, std::string> KeyConflicts::resolveFirstValues() const
+{
+    // Which definitions to look for in which file
+    QHash<QString, QSet<QString>> wanted; // file path -> value ids
+    for (const Finding& finding : findings) {
+        const QString path = firstFile(finding);
+        wanted[path].insert(valueId(path, finding.key, finding.firstHash));
+    }
+
+    QHash<QString, std::string> values;
+    for (auto it = wanted.constBegin(); it != wanted.constEnd(); ++it) {
+        QFile file(it.key());
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        while (!file.atEnd()) {
+            std::string line = file.readLine().toStdString();
+            while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+            const std::string_view key = LocalisationKernels::entryKey(line);
+            if (key.empty()) continue;
+            const std::string_view value = entryValue(line, static_cast<size_t>(key.data() - line.data()) + key.size());
+            const QString id = valueId(it.key(), key, valueHash(value));
+            if (it.value().contains(id)) values.insert(id, std::string(value));
+        }
+    }
+    return values;
+}
+
+bool KeyConflicts::write(const QString& dir, QString* error) const
+{
+    if (!ReportFiles::ensureDirectory(dir, error)) return false;
+
+    const QHash<QString, std::string> firstValues = resolveFirstValues();
+    auto sourceName = [this](uint32_t source) { return sources[source].category + "/" + sources[source].sheet; };
+
+    QByteArray csv = "kind,language,key,source,value,other_source,other_value\n";
+    QJsonArray rows;
+    for (const Finding& finding : findings) {
+        const QString firstValue = QString::fromStdString(firstValues.value(valueId(firstFile(finding), finding.key, finding.firstHash)));
+        const bool vanilla = finding.kind == VanillaSame || finding.kind == VanillaOverride;
+        const QString otherSource = vanilla ? "vanilla/" + finding.vanillaFile : sourceName(finding.second);
+        const QString otherValue = QString::fromStdString(finding.secondValue);
+        const QString key = QString::fromStdString(finding.key);
+        csv += QByteArray(KIND_NAMES[finding.kind]) + ',' + finding.lang.toUtf8() + ',' + ReportFiles::csvField(key) + ',' + ReportFiles::csvField(sourceName(finding.first))
+            + ',' + ReportFiles::csvField(firstValue) + ',' + ReportFiles::csvField(otherSource) + ',' + ReportFiles::csvField(otherValue) + '\n';
+        rows.append(QJsonArray{ KIND_NAMES[finding.kind], finding.lang, key, sourceName(finding.first), firstValue, otherSource, otherValue });
+    }
+
+    QJsonObject counts;
+    for (int kind = Duplicate; kind <= VanillaOverride; ++kind) counts.insert(KIND_NAMES[kind], kindCounts[kind]);
+    QJsonObject root;
+    root.insert("counts", counts);
+    root.insert("columns", QJsonArray{ "kind", "language", "key", "source", "value", "other_source", "other_value" });
+    root.insert("findings", rows);
+
+    const QDir out(dir);
+    return ReportFiles::writeFile(out.filePath("key_conflicts.csv"), csv, error)
+        && ReportFiles::writeFile(out.filePath("key_conflicts.json"), QJsonDocument(root).toJson(QJsonDocument::Compact), error);
+}
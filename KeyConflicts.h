@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "VanillaIndex.h"
+
+// Finds keys defined more than once across the sheets and categories of a create run, and mod keys that
+// vanilla also defines. Every key costs one hash map slot per language holding its first source and the
+// hash of its value; values themselves are only read back (from the written files) for keys that clash.
+class KeyConflicts
+{
+public:
+    enum Kind {
+        Duplicate,       // same key and value in two sources
+        Conflict,        // same key, different values: whichever file the game loads last wins
+        VanillaSame,     // mod key identical to vanilla (redundant)
+        VanillaOverride  // mod key replaces a vanilla value
+    };
+
+    // Registers a sheet of a category; filePattern is the category's output file with <lang> left in
+    uint32_t addSource(const QString& category, const QString& sheet, const QString& filePattern);
+    // Records the entries ("KEY:0 \"text\"") one source contributes to a language
+    void addEntries(uint32_t source, const QString& lang, const std::vector<std::string>& entries);
+    // Compares the recorded keys of a language with the parsed vanilla files
+    void checkVanilla(const QString& lang, const std::vector<VanillaIndex::File>& files);
+
+    QStringList languages() const { return languageKeys.keys(); }
+    bool isEmpty() const { return findings.empty(); }
+    qint64 count(Kind kind) const { return kindCounts[kind]; }
+
+    // Writes key_conflicts.csv (kind,language,key,source,value,other_source,other_value) and
+    // key_conflicts.json into dir; false with error set if a file could not be written
+    bool write(const QString& dir, QString* error = nullptr) const;
+
+    // Value part of an entry or vanilla line, from the first to the last quote
+    static std::string_view entryValue(std::string_view line, size_t keyEnd);
+
+private:
+    struct Source {
+        QString category;
+        QString sheet;
+        QString filePattern;
+    };
+    struct Occurrence {
+        uint32_t source;
+        uint64_t valueHash;
+    };
+    struct Finding {
+        Kind kind;
+        QString lang;
+        std::string key;
+        uint32_t first;          // source of the definition seen first
+        uint64_t firstHash;
+        uint32_t second;         // later source; unused for vanilla findings
+        std::string secondValue; // later value, or the vanilla value
+        QString vanillaFile;
+    };
+
+    // Output file holding a finding's first definition
+    QString firstFile(const Finding& finding) const;
+    // Reads back the first definitions' values from the written category files
+    QHash<QString, std::string> resolveFirstValues() const;
+
+    std::vector<Source> sources;
+    QHash<QString, std::unordered_map<std::string, Occurrence>> languageKeys; // lang -> key -> first definition
+    std::vector<Finding> findings;
+    qint64 kindCounts[4] = { 0, 0, 0, 0 };
+};
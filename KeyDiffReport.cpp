@@ -0,0 +1,242 @@
+#include "KeyDiffReport.h"
+#include "LocalisationKernels.h"
+#include "ReportFiles.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <string_view>
+
+namespace {
+    // An entry up to and including the colon after its key; lines sharing it belong to one key and, in
+    // sortLines() order, sit next to each other. Empty for lines without a key.
+    std::string_view keyPrefix(std::string_view entry)
+    {
+        const size_t colon = entry.find(':');
+        return colon == std::string_view::npos ? std::string_view() : entry.substr(0, colon + 1);
+    }
+
+    // The entry buildYmlFile() wrote as line: without the one space of indent and the line break.
+    // False for the BOM + header line and anything else not indented.
+    bool entryOfLine(const QByteArray& line, std::string& entry)
+    {
+        qsizetype end = line.size();
+        while (end > 0 && (line[end - 1] == '\n' || line[end - 1] == '\r')) end--;
+        if (end < 2 || line[0] != ' ') return false;
+        entry.assign(line.constData() + 1, static_cast<size_t>(end - 1));
+        return true;
+    }
+
+    void appendRow(QByteArray& rows, const QString& lang, const QString& file, std::string_view prefix, const char* change,
+        std::string_view oldEntry, std::string_view newEntry)
+    {
+        auto field = [](std::string_view text) {
+            return ReportFiles::csvField(QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size())));
+        };
+        // The line after the key's colon ("0 \"text\"")
+        auto value = [&](std::string_view entry) { return entry.empty() ? QByteArray() : field(entry.substr(prefix.size())); };
+        rows += ReportFiles::csvField(lang) + ',' + ReportFiles::csvField(file) + ',' + field(prefix.substr(0, prefix.size() - 1))
+            + ',' + change + ',' + value(oldEntry) + ',' + value(newEntry) + '\n';
+    }
+
+    QJsonObject totalsObject(const KeyDiffReport::Totals& totals)
+    {
+        QJsonObject obj;
+        obj.insert("added", totals.added);
+        obj.insert("removed", totals.removed);
+        obj.insert("changed", totals.changed);
+        obj.insert("unchanged", totals.unchanged);
+        return obj;
+    }
+
+    void addTotals(KeyDiffReport::Totals& sum, const KeyDiffReport::Totals& totals)
+    {
+        sum.added += totals.added;
+        sum.removed += totals.removed;
+        sum.changed += totals.changed;
+        sum.unchanged += totals.unchanged;
+    }
+}
+
+bool KeyDiffReport::merge(const std::function<bool(std::string&)>& nextPrevious, const std::vector<std::string>& entries,
+    const QString& file, const QString& lang, Totals& totals, QByteArray* rows) const
+{
+    std::string previous;
+    auto advance = [&]() {
+        while (nextPrevious(previous)) {
+            if (!keyPrefix(previous).empty()) return true;
+        }
+        return false;
+        };
+    size_t next = 0;
+    auto skipEntries = [&]() {
+        while (next < entries.size() && keyPrefix(entries[next]).empty()) next++;
+        };
+
+    bool hasPrevious = advance();
+    skipEntries();
+    std::vector<std::string> oldBlock;
+    std::vector<const std::string*> newBlock;
+    std::string prefix;
+    while (hasPrevious || next < entries.size()) {
+        if (!hasPrevious) prefix = keyPrefix(entries[next]);
+        else if (next >= entries.size()) prefix = keyPrefix(previous);
+        else prefix = std::min(keyPrefix(previous), keyPrefix(entries[next]));
+
+        oldBlock.clear();
+        while (hasPrevious && keyPrefix(previous) == prefix) {
+            oldBlock.push_back(std::move(previous));
+            hasPrevious = advance();
+        }
+        if (hasPrevious && keyPrefix(previous) < std::string_view(prefix)) return false;
+        newBlock.clear();
+        while (next < entries.size() && keyPrefix(entries[next]) == prefix) {
+            newBlock.push_back(&entries[next++]);
+            skipEntries();
+        }
+
+        if (oldBlock.empty()) {
+            totals.added++;
+            if (rows) appendRow(*rows, lang, file, prefix, "added", std::string_view(), *newBlock.front());
+        }
+        else if (newBlock.empty()) {
+            totals.removed++;
+            if (rows) appendRow(*rows, lang, file, prefix, "removed", oldBlock.front(), std::string_view());
+        }
+        else {
+            bool same = oldBlock.size() == newBlock.size();
+            for (size_t i = 0; same && i < oldBlock.size(); ++i) same = oldBlock[i] == *newBlock[i];
+            if (same) {
+                totals.unchanged++;
+            }
+            else {
+                totals.changed++;
+                if (rows) appendRow(*rows, lang, file, prefix, "changed", oldBlock.front(), *newBlock.front());
+            }
+        }
+    }
+    return true;
+}
+
+bool KeyDiffReport::compare(const QString& file, const QString& lang, const QString& previousPath,
+    const std::vector<std::string>& entries, QString* error)
+{
+    FileDiff diff;
+    diff.lang = lang;
+    QFile previousFile(previousPath);
+    if (!previousFile.exists()) {
+        merge([](std::string&) { return false; }, entries, file, lang, diff.totals, nullptr);
+        files.insert(file, diff);
+        return true;
+    }
+    if (!previousFile.open(QIODevice::ReadOnly)) {
+        if (error) *error = "Could not read the previous version of " + file + ": " + previousFile.errorString();
+        return false;
+    }
+    diff.previous = true;
+
+    auto nextLine = [&](std::string& entry) {
+        while (!previousFile.atEnd()) {
+            if (entryOfLine(previousFile.readLine(), entry)) return true;
+        }
+        return false;
+        };
+    QByteArray rows;
+    if (!merge(nextLine, entries, file, lang, diff.totals, &rows)) {
+        // Not in sortLines() order: read it whole and sort it
+        previousFile.seek(0);
+        std::vector<std::string> previous;
+        std::string entry;
+        while (nextLine(entry)) previous.push_back(std::move(entry));
+        LocalisationKernels::sortLines(previous);
+        size_t index = 0;
+        auto nextSorted = [&](std::string& out) {
+            if (index >= previous.size()) return false;
+            out = std::move(previous[index++]);
+            return true;
+            };
+        diff.totals = Totals();
+        rows.clear();
+        merge(nextSorted, entries, file, lang, diff.totals, &rows);
+    }
+    csvRows += rows;
+    files.insert(file, diff);
+    return true;
+}
+
+void KeyDiffReport::keep(const QString& file, const QString& lang, const std::vector<std::string>& entries)
+{
+    FileDiff diff;
+    diff.lang = lang;
+    diff.previous = true;
+    diff.kept = true;
+    std::string_view last;
+    for (const std::string& entry : entries) {
+        const std::string_view prefix = keyPrefix(entry);
+        if (prefix.empty() || prefix == last) continue;
+        diff.totals.unchanged++;
+        last = prefix;
+    }
+    files.insert(file, diff);
+}
+
+bool KeyDiffReport::keepFile(const QString& file, const QString& lang, const QString& path, QString* error)
+{
+    QFile in(path);
+    if (!in.open(QIODevice::ReadOnly)) {
+        if (error) *error = "Could not read " + path + " for the key diff: " + in.errorString();
+        return false;
+    }
+    FileDiff diff;
+    diff.lang = lang;
+    diff.previous = true;
+    diff.kept = true;
+    std::string entry;
+    std::string last;
+    while (!in.atEnd()) {
+        if (!entryOfLine(in.readLine(), entry)) continue;
+        const std::string_view prefix = keyPrefix(entry);
+        if (prefix.empty() || prefix == last) continue;
+        diff.totals.unchanged++;
+        last = prefix;
+    }
+    files.insert(file, diff);
+    return true;
+}
+
+KeyDiffReport::Totals KeyDiffReport::totals() const
+{
+    Totals sum;
+    for (const FileDiff& diff : files) addTotals(sum, diff.totals);
+    return sum;
+}
+
+bool KeyDiffReport::write(const QString& basePath, QString* error) const
+{
+    if (!ReportFiles::ensureDirectory(QFileInfo(basePath).absolutePath(), error)) return false;
+
+    const QByteArray csv = "language,file,key,change,old,new\n" + csvRows;
+
+    QMap<QString, Totals> byLanguage;
+    QJsonArray fileArray;
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        addTotals(byLanguage[it->lang], it->totals);
+        QJsonObject fileObj = totalsObject(it->totals);
+        fileObj.insert("file", it.key());
+        fileObj.insert("language", it->lang);
+        fileObj.insert("previous", it->previous);
+        fileObj.insert("kept", it->kept);
+        fileArray.append(fileObj);
+    }
+    QJsonObject languagesObj;
+    for (auto it = byLanguage.constBegin(); it != byLanguage.constEnd(); ++it) languagesObj.insert(it.key(), totalsObject(it.value()));
+    QJsonObject root;
+    root.insert("totals", totalsObject(totals()));
+    root.insert("languages", languagesObj);
+    root.insert("files", fileArray);
+
+    return ReportFiles::writeFile(basePath + ".csv", csv, error)
+        && ReportFiles::writeFile(basePath + ".json", QJsonDocument(root).toJson(QJsonDocument::Indented), error);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Keys added, removed and changed between the category files of the previous create run and the entries this
+// run writes, per file and language. Both sides are in sortLines() order, so a key's lines sit next to each other
+// and one streaming merge finds the differences: the previous file is read line by line, never held whole.
+// A previous file that is not in that order (written by hand or an old version) is read and sorted first.
+class KeyDiffReport
+{
+public:
+    struct Totals {
+        qint64 added = 0;
+        qint64 removed = 0;
+        qint64 changed = 0;     // same key, different line
+        qint64 unchanged = 0;
+    };
+
+    // Compares the previous version of a category file with the entries ("KEY:0 \"text\"", sorted) about to
+    // replace it. A missing previousPath is a new file: its keys are counted as added but not listed.
+    // file is the name the report shows; false with error set if the previous file could not be read.
+    bool compare(const QString& file, const QString& lang, const QString& previousPath,
+        const std::vector<std::string>& entries, QString* error = nullptr);
+    // A file the run kept as it was (delta export): its keys count as unchanged without being compared.
+    // keepFile() counts them in the kept file itself; false with error set if it could not be read.
+    void keep(const QString& file, const QString& lang, const std::vector<std::string>& entries);
+    bool keepFile(const QString& file, const QString& lang, const QString& path, QString* error = nullptr);
+
+    bool isEmpty() const { return files.isEmpty(); }
+    Totals totals() const;
+
+    // Writes <basePath>.csv (language,file,key,change,old,new; one row per added, removed or changed key) and
+    // <basePath>.json (totals per language and per file); false with error set if a file could not be written
+    bool write(const QString& basePath, QString* error = nullptr) const;
+
+private:
+    struct FileDiff {
+        QString lang;
+        bool previous = false;  // a previous version existed
+        bool kept = false;      // kept as it was, not compared
+        Totals totals;
+    };
+
+    // Merges the previous entries (nextPrevious fills one, false at the end) with the new ones into totals and,
+    // if given, CSV rows. Returns false as soon as the previous entries turn out not to be sorted.
+    bool merge(const std::function<bool(std::string&)>& nextPrevious, const std::vector<std::string>& entries,
+        const QString& file, const QString& lang, Totals& totals, QByteArray* rows) const;
+
+    QMap<QString, FileDiff> files;   // file -> diff, sorted for the report
+    QByteArray csvRows;
+};
@@ -0,0 +1,104 @@
+#include "KeyExplorerDialog.h"
+#include "ModManifest.h"
+#include <QElapsedTimer>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QSplitter>
+#include <QVBoxLayout>
+
+namespace {
+    // More would only slow the list down; the status line tells how many matched
+    const size_t MAX_RESULTS = 200;
+}
+
+KeyExplorerDialog::KeyExplorerDialog(const ModDefinition& mod, const QString& indexPath, QWidget* parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Key Explorer — " + mod.name);
+    resize(900, 560);
+    buildUi();
+
+    QString error;
+    loaded = index.load(indexPath, &error);
+    if (!loaded) {
+        statusLabel->setText(error);
+        searchEdit->setEnabled(false);
+        modeCombo->setEnabled(false);
+        return;
+    }
+    statusLabel->setText(QString("%1 keys indexed.").arg(index.keyCount()));
+    searchEdit->setFocus();
+}
+
+void KeyExplorerDialog::buildUi()
+{
+    QVBoxLayout* root = new QVBoxLayout(this);
+    QHBoxLayout* tools = new QHBoxLayout();
+    searchEdit = new QLineEdit(this);
+    searchEdit->setPlaceholderText("Search keys...");
+    searchEdit->setClearButtonEnabled(true);
+    modeCombo = new QComboBox(this);
+    modeCombo->addItem("Substring", KeyIndex::Substring);
+    modeCombo->addItem("Prefix", KeyIndex::Prefix);
+    tools->addWidget(searchEdit, 1);
+    tools->addWidget(modeCombo);
+
+    QSplitter* splitter = new QSplitter(Qt::Horizontal, this);
+    resultList = new QListWidget(splitter);
+    details = new QPlainTextEdit(splitter);
+    details->setReadOnly(true);
+    details->setLineWrapMode(QPlainTextEdit::NoWrap);
+    details->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    splitter->addWidget(resultList);
+    splitter->addWidget(details);
+    splitter->setStretchFactor(1, 2);
+
+    statusLabel = new QLabel(this);
+    QHBoxLayout* buttons = new QHBoxLayout();
+    buttons->addWidget(statusLabel, 1);
+    QPushButton* closeBtn = new QPushButton("Close", this);
+    buttons->addWidget(closeBtn);
+
+    root->addLayout(tools);
+    root->addWidget(splitter, 1);
+    root->addLayout(buttons);
+    connect(searchEdit, &QLineEdit::textChanged, this, &KeyExplorerDialog::onSearch);
+    connect(modeCombo, &QComboBox::currentIndexChanged, this, &KeyExplorerDialog::onSearch);
+    connect(resultList, &QListWidget::currentRowChanged, this, &KeyExplorerDialog::onKeySelected);
+    connect(closeBtn, &QPushButton::clicked, this, &QDialog::accept);
+}
+
+void KeyExplorerDialog::onSearch()
+{
+    if (!loaded) return;
+    // Searches take milliseconds, so every keystroke searches
+    QElapsedTimer timer; timer.start();
+    size_t total = 0;
+    const std::vector<uint32_t> ids = index.search(searchEdit->text(),
+        static_cast<KeyIndex::Mode>(modeCombo->currentData().toInt()), MAX_RESULTS, &total);
+    const qint64 elapsedMs = timer.elapsed();
+
+    resultList->clear();
+    details->clear();
+    for (uint32_t id : ids) {
+        QListWidgetItem* item = new QListWidgetItem(QString::fromStdString(index.key(id).name), resultList);
+        item->setData(Qt::UserRole, id);
+    }
+    if (searchEdit->text().trimmed().isEmpty()) {
+        statusLabel->setText(QString("%1 keys indexed.").arg(index.keyCount()));
+    }
+    else {
+        statusLabel->setText(QString("%1 of %2 matches shown (%3 ms).").arg(ids.size()).arg(total).arg(elapsedMs));
+    }
+}
+
+void KeyExplorerDialog::onKeySelected()
+{
+    QListWidgetItem* item = resultList->currentItem();
+    if (!item) {
+        details->clear();
+        return;
+    }
+    details->setPlainText(index.describe(item->data(Qt::UserRole).toUInt()));
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QDialog>
+#include <QComboBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPlainTextEdit>
+#include <QString>
+#include "KeyIndex.h"
+
+struct ModDefinition;
+
+class KeyExplorerDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    // Searches the key index the mod's last create + cleanup saved at indexPath
+    KeyExplorerDialog(const ModDefinition& mod, const QString& indexPath, QWidget* parent = nullptr);
+
+private slots:
+    void onSearch();
+    void onKeySelected();
+
+private:
+    void buildUi();
+
+    KeyIndex index;
+    bool loaded{false};
+    QLineEdit* searchEdit{nullptr};
+    QComboBox* modeCombo{nullptr};
+    QListWidget* resultList{nullptr};
+    QPlainTextEdit* details{nullptr};
+    QLabel* statusLabel{nullptr};
+};
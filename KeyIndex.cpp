@@ -0,0 +1,305 @@
+#include "KeyIndex.h"
+#include "LocalisationKernels.h"
+#include "ReportFiles.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace {
+    // Binary, as the index holds a few hundred thousand keys and is loaded whenever the explorer opens
+    const quint32 INDEX_MAGIC = 0x4B494458; // "KIDX"
+    const quint32 INDEX_VERSION = 1;
+
+    std::string lowerAscii(std::string_view text)
+    {
+        std::string lower(text);
+        for (char& c : lower) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return lower;
+    }
+
+    uint32_t trigramAt(const std::string& text, size_t i)
+    {
+        return static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16
+            | static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8
+            | static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2]));
+    }
+}
+
+QString KeyIndex::pathFor(const QString& sheetCacheDir, const QString& modId)
+{
+    return QDir(QFileInfo(sheetCacheDir).path()).filePath("keys/" + modId + ".idx");
+}
+
+uint32_t KeyIndex::keyId(std::string_view name)
+{
+    auto it = ids.find(std::string(name));
+    if (it != ids.end()) return it->second;
+    const uint32_t id = static_cast<uint32_t>(keys.size());
+    keys.push_back(Key{ std::string(name), {}, {} });
+    ids.emplace(keys.back().name, id);
+    return id;
+}
+
+uint32_t KeyIndex::addSource(const QString& category, const QString& sheet)
+{
+    sources.push_back(Source{ category, sheet });
+    return static_cast<uint32_t>(sources.size() - 1);
+}
+
+void KeyIndex::addSourceKey(uint32_t source, std::string_view key)
+{
+    std::vector<uint32_t>& keySources = keys[keyId(key)].sources;
+    if (std::find(keySources.begin(), keySources.end(), source) == keySources.end()) keySources.push_back(source);
+}
+
+size_t KeyIndex::copySources(const KeyIndex& previous, const QString& category, const QString& sheet)
+{
+    size_t copied = 0;
+    for (uint32_t id = 0; id < previous.sourceKeys.size(); ++id) {
+        const Source& old = previous.sources[id];
+        if (old.category != category || (!sheet.isEmpty() && old.sheet != sheet)) continue;
+        const uint32_t source = addSource(old.category, old.sheet);
+        for (uint32_t key : previous.sourceKeys[id]) addSourceKey(source, previous.keys[key].name);
+        copied += previous.sourceKeys[id].size();
+    }
+    return copied;
+}
+
+void KeyIndex::addFile(const QString& path, const QString& lang, FileKind kind, const VanillaIndex::File& file,
+    const std::vector<bool>* removed)
+{
+    const uint32_t fileId = static_cast<uint32_t>(files.size());
+    files.push_back(File{ path, lang, kind });
+    for (size_t i = 0; i < file.keys.size(); ++i) {
+        if (file.keys[i].empty()) continue;
+        Location location;
+        location.file = fileId;
+        location.offset = static_cast<uint32_t>(file.lines[i].first);
+        location.removed = removed && i < removed->size() && (*removed)[i];
+        keys[keyId(file.keys[i])].locations.push_back(location);
+    }
+}
+
+bool KeyIndex::save(const QString& path, QString* error) const
+{
+    if (!ReportFiles::ensureDirectory(QFileInfo(path).absolutePath(), error)) return false;
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (error) *error = "Could not write " + path + ": " + out.errorString();
+        return false;
+    }
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << INDEX_MAGIC << INDEX_VERSION;
+    stream << static_cast<quint32>(sources.size());
+    for (const Source& source : sources) stream << source.category << source.sheet;
+    stream << static_cast<quint32>(files.size());
+    for (const File& file : files) stream << file.path << file.lang << static_cast<quint8>(file.kind);
+    stream << static_cast<quint32>(keys.size());
+    for (const Key& key : keys) {
+        stream << QByteArray(key.name.data(), static_cast<qsizetype>(key.name.size()));
+        stream << static_cast<quint32>(key.sources.size());
+        for (uint32_t source : key.sources) stream << static_cast<quint32>(source);
+        stream << static_cast<quint32>(key.locations.size());
+        for (const Location& location : key.locations) {
+            stream << static_cast<quint32>(location.file) << static_cast<quint32>(location.offset) << static_cast<quint8>(location.removed);
+        }
+    }
+    if (stream.status() != QDataStream::Ok || !out.commit()) {
+        if (error) *error = "Could not write " + path + ": " + out.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool KeyIndex::load(const QString& path, QString* error)
+{
+    QFile in(path);
+    if (!in.open(QIODevice::ReadOnly)) {
+        if (error) *error = "No key index at " + path + "; run a create + cleanup first.";
+        return false;
+    }
+    QDataStream stream(&in);
+    stream.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        if (error) *error = "The key index at " + path + " is from another version; run a create + cleanup to rebuild it.";
+        return false;
+    }
+
+    KeyIndex loaded;
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Source source;
+        stream >> source.category >> source.sheet;
+        loaded.sources.push_back(source);
+    }
+    loaded.sourceKeys.resize(loaded.sources.size());
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        File file;
+        quint8 kind = 0;
+        stream >> file.path >> file.lang >> kind;
+        file.kind = kind == VanillaFile ? VanillaFile : ModFile;
+        loaded.files.push_back(file);
+    }
+    stream >> count;
+    loaded.keys.reserve(count);
+    bool valid = true;
+    for (quint32 i = 0; i < count && valid && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray name;
+        quint32 n = 0;
+        stream >> name >> n;
+        Key key;
+        key.name = name.toStdString();
+        for (quint32 j = 0; j < n && stream.status() == QDataStream::Ok; ++j) {
+            quint32 source = 0;
+            stream >> source;
+            valid = valid && source < loaded.sources.size();
+            if (valid) loaded.sourceKeys[source].push_back(static_cast<uint32_t>(loaded.keys.size()));
+            key.sources.push_back(source);
+        }
+        stream >> n;
+        for (quint32 j = 0; j < n && stream.status() == QDataStream::Ok; ++j) {
+            quint32 file = 0, offset = 0;
+            quint8 removed = 0;
+            stream >> file >> offset >> removed;
+            valid = valid && file < loaded.files.size();
+            key.locations.push_back(Location{ file, offset, removed != 0 });
+        }
+        loaded.ids.emplace(key.name, static_cast<uint32_t>(loaded.keys.size()));
+        loaded.keys.push_back(std::move(key));
+    }
+    if (!valid || stream.status() != QDataStream::Ok) {
+        if (error) *error = "The key index at " + path + " is damaged; run a create + cleanup to rebuild it.";
+        return false;
+    }
+
+    loaded.buildSearch();
+    *this = std::move(loaded);
+    return true;
+}
+
+void KeyIndex::buildSearch()
+{
+    lowerNames.resize(keys.size());
+    trigrams.clear();
+    for (uint32_t id = 0; id < keys.size(); ++id) {
+        lowerNames[id] = lowerAscii(keys[id].name);
+        const std::string& name = lowerNames[id];
+        for (size_t i = 0; i + 3 <= name.size(); ++i) {
+            std::vector<uint32_t>& postings = trigrams[trigramAt(name, i)];
+            if (postings.empty() || postings.back() != id) postings.push_back(id);
+        }
+    }
+    nameOrder.resize(keys.size());
+    std::iota(nameOrder.begin(), nameOrder.end(), 0u);
+    std::sort(nameOrder.begin(), nameOrder.end(), [this](uint32_t a, uint32_t b) {
+        return lowerNames[a] != lowerNames[b] ? lowerNames[a] < lowerNames[b] : keys[a].name < keys[b].name;
+        });
+    nameRank.resize(keys.size());
+    for (uint32_t rank = 0; rank < nameOrder.size(); ++rank) nameRank[nameOrder[rank]] = rank;
+}
+
+std::vector<uint32_t> KeyIndex::search(const QString& query, Mode mode, size_t limit, size_t* total) const
+{
+    const std::string needle = lowerAscii(query.trimmed().toUtf8().toStdString());
+    std::vector<uint32_t> matches;
+    if (needle.empty()) {
+        if (total) *total = 0;
+        return matches;
+    }
+
+    if (mode == Prefix) {
+        // Names with the prefix form one run of the sorted names
+        auto it = std::lower_bound(nameOrder.begin(), nameOrder.end(), needle,
+            [this](uint32_t id, const std::string& value) { return lowerNames[id] < value; });
+        for (; it != nameOrder.end() && lowerNames[*it].compare(0, needle.size(), needle) == 0; ++it) matches.push_back(*it);
+    }
+    else if (needle.size() < 3) {
+        for (uint32_t id : nameOrder) {
+            if (lowerNames[id].find(needle) != std::string::npos) matches.push_back(id);
+        }
+    }
+    else {
+        // Every key containing the needle is in the posting list of each of its trigrams
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (size_t i = 0; i + 3 <= needle.size(); ++i) {
+            auto it = trigrams.find(trigramAt(needle, i));
+            if (it == trigrams.end()) {
+                if (total) *total = 0;
+                return matches;
+            }
+            if (std::find(lists.begin(), lists.end(), &it->second) == lists.end()) lists.push_back(&it->second);
+        }
+        std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) { return a->size() < b->size(); });
+        std::vector<uint32_t> candidates = *lists.front();
+        std::vector<uint32_t> narrowed;
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            narrowed.clear();
+            std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(narrowed));
+            candidates.swap(narrowed);
+        }
+        // The trigrams may sit apart in the name
+        for (uint32_t id : candidates) {
+            if (lowerNames[id].find(needle) != std::string::npos) matches.push_back(id);
+        }
+        // Only the shown matches need to be in name order
+        auto byName = [this](uint32_t a, uint32_t b) { return nameRank[a] < nameRank[b]; };
+        const size_t shown = std::min(limit, matches.size());
+        std::partial_sort(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(shown), matches.end(), byName);
+    }
+    if (total) *total = matches.size();
+    if (matches.size() > limit) matches.resize(limit);
+    return matches;
+}
+
+QString KeyIndex::lineAt(uint32_t keyId, const Location& location) const
+{
+    QFile in(files[location.file].path);
+    if (!in.open(QIODevice::ReadOnly) || !in.seek(location.offset)) return QString();
+    QByteArray line = in.readLine();
+    while (line.endsWith('\n') || line.endsWith('\r')) line.chop(1);
+    std::string_view key;
+    if (!LocalisationKernels::keyOfLine(std::string_view(line.constData(), static_cast<size_t>(line.size())), key)
+        || key != keys[keyId].name) {
+        return QString();
+    }
+    return QString::fromUtf8(line).trimmed();
+}
+
+QString KeyIndex::describe(uint32_t keyId) const
+{
+    const Key& entry = keys[keyId];
+    QStringList out;
+    out << QString::fromStdString(entry.name);
+    out << "Sources:";
+    if (entry.sources.empty()) out << "  (not from a sheet)";
+    for (uint32_t id : entry.sources) out << "  " + sources[id].category + " / " + sources[id].sheet;
+
+    QStringList modLines, vanillaLines;
+    for (const Location& location : entry.locations) {
+        const File& where = files[location.file];
+        if (where.kind == ModFile) {
+            const QString line = lineAt(keyId, location);
+            modLines << "  " + where.lang + ": " + (line.isEmpty() ? QString("(changed since the index was built)") : line);
+        }
+        else {
+            vanillaLines << "  " + where.lang + ": " + where.path + (location.removed ? " (removed by cleanup)" : "");
+        }
+    }
+    out << "Mod output:";
+    out << (modLines.isEmpty() ? QStringList{ "  (none)" } : modLines);
+    out << "Vanilla files:";
+    out << (vanillaLines.isEmpty() ? QStringList{ "  (none)" } : vanillaLines);
+    return out.join('\n');
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "VanillaIndex.h"
+
+// Where every key of a mod comes from: the categories and sheets that define it, the Output files holding its
+// lines (one per language), and the vanilla files that define it too, marked when the cleanup dropped it there.
+// Built by a create + cleanup run and saved next to the sheet cache; the key explorer and --find load it.
+// Lines are stored as file offsets and read back on demand, so the index stays small with every language.
+// Searches go through the lowercase key names: prefixes by binary search over the sorted names, substrings of
+// three or more characters through a trigram index (built on load) whose posting lists are intersected and checked.
+class KeyIndex
+{
+public:
+    enum FileKind { ModFile, VanillaFile };
+    enum Mode { Prefix, Substring };
+
+    struct Source {
+        QString category;
+        QString sheet;
+    };
+    struct File {
+        QString path;
+        QString lang;
+        FileKind kind = ModFile;
+    };
+    struct Location {
+        uint32_t file = 0;
+        uint32_t offset = 0;     // byte offset of the key's line in the file
+        bool removed = false;    // vanilla line dropped by the cleanup
+    };
+    struct Key {
+        std::string name;
+        std::vector<uint32_t> sources;
+        std::vector<Location> locations;
+    };
+
+    // Index file of a mod: <cache root>/keys/<mod id>.idx, the cache root being the sheet cache's parent
+    static QString pathFor(const QString& sheetCacheDir, const QString& modId);
+
+    // Building (create: sources, cleanup: files)
+    uint32_t addSource(const QString& category, const QString& sheet);
+    void addSourceKey(uint32_t source, std::string_view key);
+    // Adds the sources of a loaded index for category (one sheet of it if sheet is given) with their keys, for
+    // sheets that did not change since it was built; returns the number of keys linked, 0 if it had none
+    size_t copySources(const KeyIndex& previous, const QString& category, const QString& sheet = QString());
+    // Records every key line of a parsed file; removed marks the lines the cleanup dropped (vanilla files)
+    void addFile(const QString& path, const QString& lang, FileKind kind, const VanillaIndex::File& file,
+        const std::vector<bool>* removed = nullptr);
+
+    // Replaces path atomically; false with error set on failure
+    bool save(const QString& path, QString* error = nullptr) const;
+    // false with error set if the file is missing, unreadable or of another version
+    bool load(const QString& path, QString* error = nullptr);
+
+    // Ids of the keys matching query (case-insensitive) in name order, at most limit of them; total receives
+    // the number of matches
+    std::vector<uint32_t> search(const QString& query, Mode mode, size_t limit, size_t* total = nullptr) const;
+
+    size_t keyCount() const { return keys.size(); }
+    const Key& key(uint32_t id) const { return keys[id]; }
+    const Source& source(uint32_t id) const { return sources[id]; }
+    const File& file(uint32_t id) const { return files[id]; }
+    // The line at a key's location, read from its file; empty if the file changed since it was indexed
+    QString lineAt(uint32_t keyId, const Location& location) const;
+    // A key's sources, mod lines per language and vanilla files as plain text, for the explorer and --find
+    QString describe(uint32_t keyId) const;
+
+private:
+    uint32_t keyId(std::string_view name);
+    // Lowercase names, name order and trigram posting lists for search()
+    void buildSearch();
+
+    std::vector<Source> sources;
+    std::vector<File> files;
+    std::vector<Key> keys;
+    std::unordered_map<std::string, uint32_t> ids;   // name -> key id
+    std::vector<std::vector<uint32_t>> sourceKeys;   // by source id: its key ids (filled by load)
+
+    std::vector<std::string> lowerNames;             // by key id
+    std::vector<uint32_t> nameOrder;                 // key ids sorted by lowercase name
+    std::vector<uint32_t> nameRank;                  // by key id: position in nameOrder
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams; // 3 lowercase bytes -> ascending key ids
+};
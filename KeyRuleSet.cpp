@@ -0,0 +1,625 @@
+#include "KeyRuleSet.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
+struct KeyRuleSet::PatternNode {
+    enum Kind { Empty, Set, Concat, Alt, Star, Plus, Quest } kind = Empty;
+    std::bitset<256> set;
+    std::vector<PatternNode> children;
+};
+
+namespace {
+    using Node = KeyRuleSet::PatternNode;
+
+    // Longest {m,n} count accepted; larger counts would blow up the NFA
+    const int MAX_REPEAT = 100;
+
+    Node setNode(const std::bitset<256>& set)
+    {
+        Node node;
+        node.kind = Node::Set;
+        node.set = set;
+        return node;
+    }
+
+    Node byteNode(unsigned char c)
+    {
+        std::bitset<256> set;
+        set.set(c);
+        return setNode(set);
+    }
+
+    Node wrap(Node::Kind kind, Node child)
+    {
+        Node node;
+        node.kind = kind;
+        node.children.push_back(std::move(child));
+        return node;
+    }
+
+    std::bitset<256> byteRange(unsigned char lo, unsigned char hi)
+    {
+        std::bitset<256> set;
+        for (int c = lo; c <= hi; ++c) set.set(c);
+        return set;
+    }
+
+    // Parses one glob or regex; both match the whole key
+    class PatternParser
+    {
+    public:
+        PatternParser(const QString& pattern, bool glob) : p(pattern.toUtf8()), glob(glob), end(p.size()) {}
+
+        bool parse(Node& out, QString* error)
+        {
+            bool ok = false;
+            if (glob) {
+                ok = parseGlob(out);
+            }
+            else {
+                // Rules always match whole keys, so leading ^ and trailing $ change nothing
+                if (pos < end && p.at(pos) == '^') pos++;
+                if (end > pos && p.at(end - 1) == '$') {
+                    qsizetype slashes = 0;
+                    while (end - 2 - slashes >= pos && p.at(end - 2 - slashes) == '\\') slashes++;
+                    if (slashes % 2 == 0) end--;
+                }
+                ok = parseAlt(out) && (pos == end || fail("unmatched )"));
+            }
+            if (!ok && error) *error = errorText;
+            return ok;
+        }
+
+    private:
+        bool fail(const QString& message)
+        {
+            if (errorText.isEmpty()) errorText = QString("%1 at position %2").arg(message).arg(pos);
+            return false;
+        }
+        bool atEnd() const { return pos >= end; }
+        char peek() const { return p.at(pos); }
+
+        bool parseGlob(Node& out)
+        {
+            out.kind = Node::Concat;
+            while (!atEnd()) {
+                const char c = p.at(pos++);
+                if (c == '*') {
+                    out.children.push_back(wrap(Node::Star, setNode(byteRange(0, 255))));
+                }
+                else if (c == '?') {
+                    out.children.push_back(setNode(byteRange(0, 255)));
+                }
+                else if (c == '[') {
+                    std::bitset<256> set;
+                    if (!parseClass(set)) return false;
+                    out.children.push_back(setNode(set));
+                }
+                else if (c == '\\') {
+                    if (atEnd()) return fail("trailing backslash");
+                    out.children.push_back(byteNode(static_cast<unsigned char>(p.at(pos++))));
+                }
+                else {
+                    out.children.push_back(byteNode(static_cast<unsigned char>(c)));
+                }
+            }
+            return true;
+        }
+
+        bool parseAlt(Node& out)
+        {
+            Node first;
+            if (!parseSeq(first)) return false;
+            if (atEnd() || peek() != '|') {
+                out = std::move(first);
+                return true;
+            }
+            out.kind = Node::Alt;
+            out.children.push_back(std::move(first));
+            while (!atEnd() && peek() == '|') {
+                pos++;
+                Node next;
+                if (!parseSeq(next)) return false;
+                out.children.push_back(std::move(next));
+            }
+            return true;
+        }
+
+        bool parseSeq(Node& out)
+        {
+            out.kind = Node::Concat;
+            while (!atEnd() && peek() != '|' && peek() != ')') {
+                Node item;
+                if (!parseRepeat(item)) return false;
+                out.children.push_back(std::move(item));
+            }
+            if (out.children.size() == 1) {
+                Node only = std::move(out.children.front());
+                out = std::move(only);
+            }
+            return true;
+        }
+
+        bool parseRepeat(Node& out)
+        {
+            if (!parseAtom(out)) return false;
+            while (!atEnd()) {
+                const char c = peek();
+                if (c == '*' || c == '+' || c == '?') {
+                    pos++;
+                    out = wrap(c == '*' ? Node::Star : c == '+' ? Node::Plus : Node::Quest, std::move(out));
+                }
+                else if (c == '{') {
+                    pos++;
+                    if (!parseCount(out)) return false;
+                }
+                else {
+                    break;
+                }
+                // Lazy quantifiers match the same whole keys
+                if (!atEnd() && peek() == '?') pos++;
+            }
+            return true;
+        }
+
+        int readNumber()
+        {
+            int value = -1;
+            while (!atEnd() && peek() >= '0' && peek() <= '9') {
+                value = std::min(std::max(value, 0) * 10 + (p.at(pos++) - '0'), MAX_REPEAT + 1);
+            }
+            return value;
+        }
+
+        // {m}, {m,} or {m,n}, after the brace; expanded into copies of the atom
+        bool parseCount(Node& atom)
+        {
+            const int min = readNumber();
+            if (min < 0) return fail("expected a repeat count");
+            int max = min;
+            if (!atEnd() && peek() == ',') {
+                pos++;
+                max = readNumber();
+            }
+            if (atEnd() || p.at(pos++) != '}') return fail("expected }");
+            if (min > MAX_REPEAT || max > MAX_REPEAT) return fail(QString("repeat counts above %1 are not supported").arg(MAX_REPEAT));
+            if (max >= 0 && max < min) return fail("repeat count {m,n} with n < m");
+
+            Node repeated;
+            repeated.kind = Node::Concat;
+            for (int i = 0; i < min; ++i) repeated.children.push_back(atom);
+            if (max < 0) repeated.children.push_back(wrap(Node::Star, atom));
+            for (int i = min; i < max; ++i) repeated.children.push_back(wrap(Node::Quest, atom));
+            atom = std::move(repeated);
+            return true;
+        }
+
+        bool parseAtom(Node& out)
+        {
+            const char c = p.at(pos++);
+            switch (c) {
+            case '(': {
+                if (!atEnd() && peek() == '?') {
+                    if (pos + 1 < end && p.at(pos + 1) == ':') pos += 2;
+                    else return fail("lookaround and group flags are not supported");
+                }
+                if (!parseAlt(out)) return false;
+                if (atEnd() || p.at(pos++) != ')') return fail("missing )");
+                return true;
+            }
+            case ')':
+                return fail("unmatched )");
+            case '[': {
+                std::bitset<256> set;
+                if (!parseClass(set)) return false;
+                out = setNode(set);
+                return true;
+            }
+            case '.':
+                out = setNode(byteRange(0, 255));
+                return true;
+            case '\\': {
+                std::bitset<256> set;
+                if (!parseEscape(set, nullptr)) return false;
+                out = setNode(set);
+                return true;
+            }
+            case '*': case '+': case '?': case '{':
+                return fail("nothing to repeat");
+            case '^': case '$':
+                return fail("anchors are only allowed at the start and end");
+            default:
+                out = byteNode(static_cast<unsigned char>(c));
+                return true;
+            }
+        }
+
+        // After a backslash. single receives the byte for a one-byte escape, -1 for \d, \w and \s
+        bool parseEscape(std::bitset<256>& out, int* single)
+        {
+            if (atEnd()) return fail("trailing backslash");
+            const char c = p.at(pos++);
+            if (single) *single = -1;
+            auto word = []() {
+                std::bitset<256> set = byteRange('a', 'z') | byteRange('A', 'Z') | byteRange('0', '9');
+                set.set('_');
+                return set;
+            };
+            auto space = []() {
+                std::bitset<256> set;
+                for (char s : { ' ', '\t', '\n', '\r', '\f', '\v' }) set.set(static_cast<unsigned char>(s));
+                return set;
+            };
+            switch (c) {
+            case 'd': out = byteRange('0', '9'); return true;
+            case 'D': out = ~byteRange('0', '9'); return true;
+            case 'w': out = word(); return true;
+            case 'W': out = ~word(); return true;
+            case 's': out = space(); return true;
+            case 'S': out = ~space(); return true;
+            default: break;
+            }
+            unsigned char literal = static_cast<unsigned char>(c);
+            if (c == 'n') literal = '\n';
+            else if (c == 't') literal = '\t';
+            else if (c == 'r') literal = '\r';
+            else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+                return fail(QString("unsupported escape \\%1").arg(QChar::fromLatin1(c)));
+            }
+            out.reset();
+            out.set(literal);
+            if (single) *single = literal;
+            return true;
+        }
+
+        // After the opening bracket: [abc], [a-z], [^...] (also [!...] in globs), ] first is literal
+        bool parseClass(std::bitset<256>& out)
+        {
+            out.reset();
+            bool negate = false;
+            if (!atEnd() && (peek() == '^' || (glob && peek() == '!'))) {
+                negate = true;
+                pos++;
+            }
+            bool first = true;
+            for (;;) {
+                if (atEnd()) return fail("missing ]");
+                char c = p.at(pos++);
+                if (c == ']' && !first) break;
+                first = false;
+
+                int lo = static_cast<unsigned char>(c);
+                if (c == '\\') {
+                    std::bitset<256> escaped;
+                    if (glob) {
+                        if (atEnd()) return fail("trailing backslash");
+                        lo = static_cast<unsigned char>(p.at(pos++));
+                    }
+                    else {
+                        if (!parseEscape(escaped, &lo)) return false;
+                        if (lo < 0) {
+                            out |= escaped;
+                            continue;
+                        }
+                    }
+                }
+                if (pos + 1 < end && peek() == '-' && p.at(pos + 1) != ']') {
+                    pos++;
+                    int hi = static_cast<unsigned char>(p.at(pos++));
+                    if (hi == '\\') {
+                        std::bitset<256> escaped;
+                        if (glob) {
+                            if (atEnd()) return fail("trailing backslash");
+                            hi = static_cast<unsigned char>(p.at(pos++));
+                        }
+                        else if (!parseEscape(escaped, &hi) || hi < 0) {
+                            return fail("invalid range end");
+                        }
+                    }
+                    if (hi < lo) return fail("range out of order");
+                    out |= byteRange(static_cast<unsigned char>(lo), static_cast<unsigned char>(hi));
+                }
+                else {
+                    out.set(lo);
+                }
+            }
+            if (negate) out.flip();
+            return true;
+        }
+
+        QByteArray p;
+        bool glob;
+        qsizetype pos = 0;
+        qsizetype end;
+        QString errorText;
+    };
+}
+
+QString KeyRuleSet::kindName(Kind kind)
+{
+    switch (kind) {
+    case Exact: return "exact";
+    case Prefix: return "prefix";
+    case Glob: return "glob";
+    case Regex: return "regex";
+    }
+    return QString();
+}
+
+bool KeyRuleSet::addRule(const QString& name, Kind kind, const QStringList& patterns, QString* error)
+{
+    if (patterns.isEmpty()) {
+        if (error) *error = "rule has no patterns";
+        return false;
+    }
+    for (const QString& pattern : patterns) {
+        if (pattern.isEmpty()) {
+            if (error) *error = "empty pattern";
+            return false;
+        }
+    }
+
+    // Patterns are parsed before anything is added, so a bad one leaves the set as it was
+    std::vector<PatternNode> parsed;
+    if (kind == Glob || kind == Regex) {
+        for (const QString& pattern : patterns) {
+            PatternNode node;
+            QString parseError;
+            if (!PatternParser(pattern, kind == Glob).parse(node, &parseError)) {
+                if (error) *error = QString("%1 '%2': %3").arg(kindName(kind)).arg(pattern).arg(parseError);
+                return false;
+            }
+            parsed.push_back(std::move(node));
+        }
+    }
+
+    const int index = static_cast<int>(ruleList.size());
+    Rule rule;
+    rule.name = name.isEmpty() ? kindName(kind) + " " + patterns.join(", ") : name;
+    rule.kind = kind;
+    rule.patterns = patterns;
+    ruleList.push_back(rule);
+
+    switch (kind) {
+    case Exact:
+        // emplace keeps an earlier rule for the same key, so the lowest index wins
+        for (const QString& pattern : patterns) exact.emplace(pattern.toStdString(), index);
+        break;
+    case Prefix:
+        if (trie.empty()) trie.emplace_back();
+        for (const QString& pattern : patterns) {
+            int node = 0;
+            for (unsigned char c : pattern.toUtf8()) {
+                auto it = std::find_if(trie[node].children.begin(), trie[node].children.end(),
+                    [c](const std::pair<unsigned char, int>& child) { return child.first == c; });
+                if (it != trie[node].children.end()) {
+                    node = it->second;
+                    continue;
+                }
+                const int child = static_cast<int>(trie.size());
+                trie[node].children.emplace_back(c, child);
+                trie.emplace_back();
+                node = child;
+            }
+            if (trie[node].rule < 0) trie[node].rule = index;
+        }
+        break;
+    case Glob:
+    case Regex:
+        for (const PatternNode& node : parsed) {
+            NfaState accept;
+            accept.type = NfaState::Accept;
+            accept.rule = index;
+            nfa.push_back(accept);
+            nfaStarts.push_back(compile(node, static_cast<int>(nfa.size()) - 1));
+        }
+        // The DFA is rebuilt from the new NFA as keys come in
+        dfa.clear();
+        dfaIndex.clear();
+        break;
+    }
+    return true;
+}
+
+bool KeyRuleSet::loadFile(const QString& path, QString* error)
+{
+    auto fail = [&](const QString& message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return fail("Could not open key rule file " + path);
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) return fail(QString("Invalid key rule file %1: %2").arg(path).arg(parseError.errorString()));
+
+    const QJsonArray rules = doc.object().value("rules").toArray();
+    static const std::pair<const char*, Kind> kinds[] = { { "exact", Exact }, { "prefix", Prefix }, { "glob", Glob }, { "regex", Regex } };
+    for (qsizetype i = 0; i < rules.size(); ++i) {
+        const QJsonObject ruleObj = rules.at(i).toObject();
+        QJsonValue value;
+        Kind kind = Exact;
+        int kindCount = 0;
+        for (const auto& k : kinds) {
+            if (!ruleObj.contains(k.first)) continue;
+            value = ruleObj.value(k.first);
+            kind = k.second;
+            kindCount++;
+        }
+        if (kindCount != 1) return fail(QString("Key rule file %1, rule %2: needs exactly one of exact, prefix, glob or regex").arg(path).arg(i + 1));
+
+        QStringList patterns;
+        if (value.isArray()) {
+            for (const QJsonValue& pv : value.toArray()) patterns << pv.toString();
+        }
+        else {
+            patterns << value.toString();
+        }
+        QString ruleError;
+        if (!addRule(ruleObj.value("name").toString(), kind, patterns, &ruleError)) {
+            return fail(QString("Key rule file %1, rule %2: %3").arg(path).arg(i + 1).arg(ruleError));
+        }
+    }
+    return true;
+}
+
+void KeyRuleSet::resetMatches()
+{
+    for (Rule& rule : ruleList) rule.matches = 0;
+}
+
+int KeyRuleSet::match(const std::string& key)
+{
+    int best = -1;
+    auto consider = [&best](int rule) {
+        if (rule >= 0 && (best < 0 || rule < best)) best = rule;
+    };
+
+    if (!exact.empty()) {
+        auto it = exact.find(key);
+        if (it != exact.end()) consider(it->second);
+    }
+    if (!trie.empty()) {
+        int node = 0;
+        for (unsigned char c : key) {
+            const std::vector<std::pair<unsigned char, int>>& children = trie[node].children;
+            auto it = std::find_if(children.begin(), children.end(),
+                [c](const std::pair<unsigned char, int>& child) { return child.first == c; });
+            if (it == children.end()) break;
+            node = it->second;
+            consider(trie[node].rule);
+        }
+    }
+    if (!nfaStarts.empty()) {
+        int state = startState();
+        for (unsigned char c : key) {
+            state = dfaStep(state, c);
+            if (dfa[state].nfa.empty()) break;   // dead: no pattern can match any more
+        }
+        consider(dfa[state].rule);
+    }
+
+    if (best >= 0) ruleList[best].matches++;
+    return best;
+}
+
+int KeyRuleSet::compile(const PatternNode& node, int next)
+{
+    auto push = [this](NfaState state) {
+        nfa.push_back(state);
+        return static_cast<int>(nfa.size()) - 1;
+    };
+    auto split = [&push](int out, int out1) {
+        NfaState state;
+        state.type = NfaState::Split;
+        state.out = out;
+        state.out1 = out1;
+        return push(state);
+    };
+
+    switch (node.kind) {
+    case PatternNode::Empty:
+        return next;
+    case PatternNode::Set: {
+        NfaState state;
+        state.chars = node.set;
+        state.out = next;
+        return push(state);
+    }
+    case PatternNode::Concat:
+        // Built back to front so every piece knows where it continues
+        for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) next = compile(*it, next);
+        return next;
+    case PatternNode::Alt: {
+        int result = compile(node.children.back(), next);
+        for (size_t i = node.children.size() - 1; i-- > 0;) {
+            const int branch = compile(node.children[i], next);
+            result = split(branch, result);
+        }
+        return result;
+    }
+    case PatternNode::Quest: {
+        const int body = compile(node.children.front(), next);
+        return split(body, next);
+    }
+    case PatternNode::Star:
+    case PatternNode::Plus: {
+        const int loop = split(-1, next);
+        const int body = compile(node.children.front(), loop);
+        nfa[loop].out = body;
+        return node.kind == PatternNode::Star ? loop : body;
+    }
+    }
+    return next;
+}
+
+void KeyRuleSet::closure(int nfaState, std::vector<int>& out, std::vector<bool>& seen) const
+{
+    std::vector<int> stack { nfaState };
+    while (!stack.empty()) {
+        const int s = stack.back();
+        stack.pop_back();
+        if (s < 0 || seen[s]) continue;
+        seen[s] = true;
+        if (nfa[s].type == NfaState::Split) {
+            stack.push_back(nfa[s].out1);
+            stack.push_back(nfa[s].out);
+        }
+        else {
+            out.push_back(s);
+        }
+    }
+}
+
+int KeyRuleSet::startState()
+{
+    if (!dfa.empty()) return 0;
+    std::vector<int> states;
+    std::vector<bool> seen(nfa.size(), false);
+    for (int start : nfaStarts) closure(start, states, seen);
+    return addDfaState(std::move(states));
+}
+
+int KeyRuleSet::addDfaState(std::vector<int> nfaStates)
+{
+    std::sort(nfaStates.begin(), nfaStates.end());
+    auto it = dfaIndex.find(nfaStates);
+    if (it != dfaIndex.end()) return it->second;
+
+    DfaState state;
+    for (int s : nfaStates) {
+        if (nfa[s].type == NfaState::Accept && (state.rule < 0 || nfa[s].rule < state.rule)) state.rule = nfa[s].rule;
+    }
+    state.next.fill(-1);
+    state.nfa = nfaStates;
+    const int index = static_cast<int>(dfa.size());
+    dfa.push_back(std::move(state));
+    dfaIndex.emplace(std::move(nfaStates), index);
+    return index;
+}
+
+int KeyRuleSet::dfaStep(int state, unsigned char byte)
+{
+    const int known = dfa[state].next[byte];
+    if (known >= 0) return known;
+
+    std::vector<int> target;
+    std::vector<bool> seen(nfa.size(), false);
+    for (int s : dfa[state].nfa) {
+        if (nfa[s].type == NfaState::Chars && nfa[s].chars.test(byte)) closure(nfa[s].out, target, seen);
+    }
+    if (static_cast<int>(dfa.size()) >= MAX_DFA_STATES) {
+        // Patterns that keep producing new states: start over rather than grow without bound
+        dfa.clear();
+        dfaIndex.clear();
+        startState();
+        return addDfaState(std::move(target));
+    }
+    const int next = addDfaState(std::move(target));
+    dfa[state].next[byte] = next;
+    return next;
+}
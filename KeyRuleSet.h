@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <bitset>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Vanilla keys the cleanup always drops, by exact name, prefix, glob or regex.
+// Rules are compiled into one matcher when they are added: exact keys go into a hash map, prefixes into a
+// byte trie, globs and regexes into one NFA that is walked as a DFA built on demand. match() classifies a key
+// with one hash lookup and one walk over its bytes, however many rules there are.
+// Rule file (JSON; every rule has one kind, given one pattern or a list of patterns):
+//   {"rules": [{"name": "name overrides", "prefix": "NAME_"}, {"glob": "*_desc_old"},
+//              {"regex": "civic_[a-z_]+_tooltip"}, {"exact": ["DIFFICULTY_CADET", "DIFFICULTY_ENSIGN"]}]}
+// Globs and regexes match the whole key. Regexes support . [] | () ? * + {m,n} and \d \w \s; anchors are implicit.
+class KeyRuleSet
+{
+public:
+    enum Kind { Exact, Prefix, Glob, Regex };
+
+    struct Rule {
+        QString name;
+        Kind kind = Exact;
+        QStringList patterns;
+        qint64 matches = 0;   // keys matched since the last resetMatches()
+    };
+
+    // Adds one rule; false with error set if a pattern does not compile (the set is left unchanged)
+    bool addRule(const QString& name, Kind kind, const QStringList& patterns, QString* error = nullptr);
+    // Adds the rules of a rule file; false with error set if it is missing or malformed
+    bool loadFile(const QString& path, QString* error = nullptr);
+
+    // Index of the first rule matching key, or -1; counts the match. Not thread-safe (the DFA grows as it runs).
+    int match(const std::string& key);
+
+    bool isEmpty() const { return ruleList.empty(); }
+    const std::vector<Rule>& rules() const { return ruleList; }
+    void resetMatches();
+    qint64 dfaStates() const { return static_cast<qint64>(dfa.size()); }
+
+    static QString kindName(Kind kind);
+
+    // Parsed glob or regex, defined in KeyRuleSet.cpp
+    struct PatternNode;
+
+private:
+    struct NfaState {
+        enum Type { Chars, Split, Accept } type = Chars;
+        std::bitset<256> chars;
+        int out = -1;
+        int out1 = -1;
+        int rule = -1;
+    };
+    struct DfaState {
+        std::vector<int> nfa;      // Chars and Accept states after epsilon closure
+        int rule = -1;             // lowest accepting rule, -1 if none
+        std::array<int, 256> next; // -1 until the transition is first taken
+    };
+    struct TrieNode {
+        std::vector<std::pair<unsigned char, int>> children;
+        int rule = -1;             // lowest prefix rule ending here
+    };
+
+    int compile(const PatternNode& node, int next);
+    int startState();
+    int addDfaState(std::vector<int> nfaStates);
+    int dfaStep(int state, unsigned char byte);
+    void closure(int nfaState, std::vector<int>& out, std::vector<bool>& seen) const;
+
+    // Above this many DFA states the cache is dropped and rebuilt as keys come in
+    static const int MAX_DFA_STATES = 4096;
+
+    std::vector<Rule> ruleList;
+    std::unordered_map<std::string, int> exact;   // key -> rule
+    std::vector<TrieNode> trie;                   // node 0 is the root once a prefix is added
+    std::vector<NfaState> nfa;
+    std::vector<int> nfaStarts;                   // start state of every glob and regex pattern
+    std::vector<DfaState> dfa;                    // 0 = start state once built
+    std::map<std::vector<int>, int> dfaIndex;
+};
@@ -0,0 +1,273 @@
+#include "LocalApiServer.h"
+#include "LocalisationKernels.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QSet>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+
+LocalApiServer::LocalApiServer(const QString& fixturesDir, QObject* parent)
+    : QObject(parent), fixturesDir(fixturesDir)
+{
+    connect(&server, &QTcpServer::newConnection, this, &LocalApiServer::onNewConnection);
+}
+
+bool LocalApiServer::listen(quint16 port)
+{
+    return server.listen(QHostAddress::LocalHost, port);
+}
+
+QString LocalApiServer::endpointUrl() const
+{
+    return QString("http://127.0.0.1:%1/exec").arg(server.serverPort());
+}
+
+void LocalApiServer::onNewConnection()
+{
+    while (server.hasPendingConnections()) {
+        QTcpSocket* socket = server.nextPendingConnection();
+        pending.insert(socket, PendingRequest());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            pending.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void LocalApiServer::handleReadyRead(QTcpSocket* socket)
+{
+    auto it = pending.find(socket);
+    if (it == pending.end()) return;
+    QByteArray& buffer = it->buffer;
+    buffer += socket->readAll();
+
+    // Handle every complete request in the buffer (keep-alive connections reuse the socket)
+    for (;;) {
+        const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) return;
+
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        qint64 contentLength = 0;
+        bool keepAlive = true;
+        bool acceptDeflate = false;
+        for (int i = 1; i < lines.size(); ++i) {
+            const QByteArray line = lines.at(i).trimmed().toLower();
+            if (line.startsWith("content-length:")) contentLength = line.mid(15).trimmed().toLongLong();
+            else if (line.startsWith("connection:") && line.contains("close")) keepAlive = false;
+            else if (line.startsWith("accept-encoding:") && line.contains("deflate")) acceptDeflate = true;
+        }
+        if (buffer.size() < headerEnd + 4 + contentLength) return; // Body not complete yet
+
+        const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+        buffer.remove(0, headerEnd + 4 + contentLength);
+        if (requestLine.size() < 3) {
+            sendResponse(socket, 400, "{\"error\":\"Malformed request\"}", false);
+            return;
+        }
+        if (requestLine.at(2) == "HTTP/1.0") keepAlive = false;
+        handleRequest(socket, requestLine.at(1), keepAlive, acceptDeflate);
+    }
+}
+
+void LocalApiServer::handleRequest(QTcpSocket* socket, const QByteArray& target, bool keepAlive, bool acceptDeflate)
+{
+    ++requestCount;
+    const QUrl url(QString("http://127.0.0.1") + QString::fromLatin1(target));
+    const QUrlQuery query(url);
+
+    int status = 200;
+    QByteArray body;
+    if (query.queryItemValue("action") == "listSheets") {
+        const QJsonArray ids = QJsonDocument::fromJson(query.queryItemValue("ids", QUrl::FullyDecoded).toUtf8()).array();
+        body = handleListSheets(ids);
+    }
+    else if (query.hasQueryItem("settings")) {
+        // The client percent-encodes the JSON before adding it to the query, so it may arrive encoded twice
+        const QString raw = query.queryItemValue("settings", QUrl::FullyDecoded);
+        QJsonDocument settings = QJsonDocument::fromJson(raw.toUtf8());
+        if (!settings.isObject()) settings = QJsonDocument::fromJson(QUrl::fromPercentEncoding(raw.toUtf8()).toUtf8());
+        if (settings.isObject()) {
+            body = handleExport(settings.object(), status);
+        }
+        else {
+            status = 400;
+            body = "{\"error\":\"Invalid settings JSON\"}";
+        }
+    }
+    else {
+        status = 400;
+        body = "{\"error\":\"Unknown request\"}";
+    }
+
+    if (responseDelayMs > 0) {
+        QTimer::singleShot(responseDelayMs, socket, [this, socket, status, body, keepAlive, acceptDeflate]() {
+            sendResponse(socket, status, body, keepAlive, acceptDeflate);
+        });
+    }
+    else {
+        sendResponse(socket, status, body, keepAlive, acceptDeflate);
+    }
+}
+
+QByteArray LocalApiServer::handleListSheets(const QJsonArray& ids)
+{
+    QJsonArray spreadsheets;
+    for (const QJsonValue& idValue : ids) {
+        const QString spreadsheetId = idValue.toString();
+        const QJsonObject fixture = loadSpreadsheet(spreadsheetId);
+        if (fixture.isEmpty()) continue;
+        QJsonArray sheets;
+        for (const QJsonValue& sv : fixture.value("sheets").toArray()) {
+            const QJsonObject sheet = sv.toObject();
+            QJsonObject entry;
+            entry["id"] = sheet.value("id");
+            entry["name"] = sheet.value("name");
+            entry["revision"] = sheet.contains("revision") ? sheet.value("revision").toString()
+                : rowsRevision(sheet.value("rows").toArray());
+            entry["lastModified"] = sheet.contains("lastModified") ? sheet.value("lastModified").toString()
+                : fixture.value("lastModified").toString();
+            sheets.append(entry);
+        }
+        QJsonObject s;
+        s["spreadsheetId"] = spreadsheetId;
+        s["spreadsheetName"] = fixture.value("spreadsheetName").toString(spreadsheetId);
+        s["sheets"] = sheets;
+        spreadsheets.append(s);
+    }
+    QJsonObject root;
+    root["spreadsheets"] = spreadsheets;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+QByteArray LocalApiServer::handleExport(const QJsonObject& settings, int& status)
+{
+    const QString spreadsheetId = settings.value("spreadsheetId").toString();
+    const QJsonObject fixture = loadSpreadsheet(spreadsheetId);
+    if (fixture.isEmpty()) {
+        status = 404;
+        return "{\"error\":\"Unknown spreadsheet\"}";
+    }
+
+    QSet<qint64> wanted;
+    for (const QJsonValue& v : settings.value("targetSheets").toArray()) wanted.insert(v.toVariant().toLongLong());
+    const bool allSheets = settings.value("exportSheets").toString() != "custom";
+    // Column projection: only the listed languages (all if none are listed), optionally without unlabeled columns
+    QSet<QString> languages;
+    for (const QJsonValue& v : settings.value("languages").toArray()) languages.insert(v.toString().toLower());
+    const bool dropUnlabeled = settings.value("dropUnlabeledColumns").toBool();
+    const bool project = !languages.isEmpty() || dropUnlabeled;
+    const bool columnar = settings.value("transportFormat").toString() == "columnar";
+
+    QJsonObject root;
+    for (const QJsonValue& sv : fixture.value("sheets").toArray()) {
+        const QJsonObject sheet = sv.toObject();
+        if (!allSheets && !wanted.contains(sheet.value("id").toVariant().toLongLong())) continue;
+        QJsonArray rows = sheet.value("rows").toArray();
+        if (project) {
+            QJsonArray projected;
+            for (const QJsonValue& rv : rows) {
+                QJsonObject row = rv.toObject();
+                for (auto it = row.begin(); it != row.end();) {
+                    const QString language = LocalisationKernels::resolveLanguageColumn(it.key());
+                    const bool keep = language.isEmpty() ? !dropUnlabeled : (languages.isEmpty() || languages.contains(language));
+                    if (keep) ++it;
+                    else it = row.erase(it);
+                }
+                if (!row.isEmpty()) projected.append(row);
+            }
+            rows = projected;
+        }
+        if (columnar) root[sheet.value("name").toString()] = columnarSheet(rows);
+        else root[sheet.value("name").toString()] = rows;
+    }
+    if (columnar) {
+        QJsonObject wrapped;
+        wrapped["format"] = "columnar";
+        wrapped["sheets"] = root;
+        root = wrapped;
+    }
+    // The real script pretty-prints unless minifyData is set; mirror that so payload sizes are comparable
+    const bool minify = settings.value("minifyData").toBool();
+    return QJsonDocument(root).toJson(minify ? QJsonDocument::Compact : QJsonDocument::Indented);
+}
+
+QJsonObject LocalApiServer::loadSpreadsheet(const QString& spreadsheetId)
+{
+    const QString path = QDir(fixturesDir).filePath(spreadsheetId + ".json");
+    const QDateTime modified = QFileInfo(path).lastModified();
+    auto it = spreadsheetCache.constFind(spreadsheetId);
+    if (it != spreadsheetCache.constEnd() && it->modified == modified) return it->fixture;
+
+    QFile file(path);
+    QJsonObject fixture;
+    if (file.open(QIODevice::ReadOnly)) {
+        fixture = QJsonDocument::fromJson(file.readAll()).object();
+        // Sheets without their own lastModified report the file time
+        if (!fixture.contains("lastModified")) fixture["lastModified"] = modified.toUTC().toString(Qt::ISODate);
+    }
+    CachedFixture cached;
+    cached.modified = modified;
+    cached.fixture = fixture;
+    spreadsheetCache.insert(spreadsheetId, cached);
+    return fixture;
+}
+
+// Column names in order of first use, then one value array per row with null for cells the row does not have
+QJsonObject LocalApiServer::columnarSheet(const QJsonArray& rows)
+{
+    QJsonArray columns;
+    QHash<QString, qsizetype> columnIndex;
+    for (const QJsonValue& rv : rows) {
+        const QJsonObject row = rv.toObject();
+        for (auto it = row.begin(); it != row.end(); ++it) {
+            if (columnIndex.contains(it.key())) continue;
+            columnIndex.insert(it.key(), columns.size());
+            columns.append(it.key());
+        }
+    }
+    QJsonArray values;
+    for (const QJsonValue& rv : rows) {
+        const QJsonObject row = rv.toObject();
+        QJsonArray cells;
+        for (qsizetype i = 0; i < columns.size(); ++i) cells.append(QJsonValue::Null);
+        for (auto it = row.begin(); it != row.end(); ++it) cells[columnIndex.value(it.key())] = it.value();
+        values.append(cells);
+    }
+    QJsonObject table;
+    table["columns"] = columns;
+    table["rows"] = values;
+    return table;
+}
+
+// Stands in for the sheet revision the real script reports: changes whenever the rows do
+QString LocalApiServer::rowsRevision(const QJsonArray& rows)
+{
+    const QByteArray bytes = QJsonDocument(rows).toJson(QJsonDocument::Compact);
+    return QString::fromLatin1(QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex().left(16));
+}
+
+void LocalApiServer::sendResponse(QTcpSocket* socket, int status, const QByteArray& body, bool keepAlive, bool deflate)
+{
+    const char* reason = status == 200 ? "OK" : status == 404 ? "Not Found" : status == 400 ? "Bad Request" : "Error";
+    // Like Google's front end, larger bodies go out compressed when the client accepts it.
+    // HTTP deflate is the zlib format, which is qCompress without its 4-byte length prefix.
+    const bool compress = deflate && body.size() >= MIN_COMPRESSED_BODY;
+    const QByteArray content = compress ? qCompress(body).mid(4) : body;
+    QByteArray response;
+    response.reserve(content.size() + 180);
+    response += "HTTP/1.1 " + QByteArray::number(status) + " " + reason + "\r\n";
+    response += "Content-Type: application/json; charset=utf-8\r\n";
+    if (compress) response += "Content-Encoding: deflate\r\n";
+    response += "Content-Length: " + QByteArray::number(content.size()) + "\r\n";
+    response += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    response += content;
+    socket->write(response);
+    if (!keepAlive) socket->disconnectFromHost();
+}
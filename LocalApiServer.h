@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QObject>
+#include <QDateTime>
+#include <QTcpServer>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QString>
+
+class QTcpSocket;
+
+// Minimal HTTP stand-in for the PDG_ExportSheetData Apps Script.
+// Implements the two calls the tool makes:
+//   ?action=listSheets&ids=[...]  -> {"spreadsheets":[{spreadsheetId, spreadsheetName, sheets:[{id,name,revision,lastModified}]}]}
+//   ?settings=<json>              -> {"<sheet name>": [ {"KEY (Language)": "line", ...}, ... ], ...}
+//     settings.languages (lower-case names) and settings.dropUnlabeledColumns project the columns of every row;
+//     settings.transportFormat "columnar" answers {"format":"columnar","sheets":{"<sheet name>":{"columns":[...],"rows":[[...],...]}}}.
+// Bodies of 1 KB and more are deflate-compressed when the request accepts it.
+// Spreadsheets are served from <fixturesDir>/<spreadsheetId>.json:
+//   {"spreadsheetName": "...", "sheets": [{"id": 1, "name": "...", "revision": "...", "lastModified": "...", "rows": [ {...}, ... ]}]}
+// revision and lastModified are optional; without them a hash of the rows and the file time are reported,
+// and the fixture is re-read when its file changes so edits show up as new revisions.
+class LocalApiServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LocalApiServer(const QString& fixturesDir, QObject* parent = nullptr);
+
+    // Starts listening on 127.0.0.1; port 0 picks a free port
+    bool listen(quint16 port = 0);
+    quint16 serverPort() const { return server.serverPort(); }
+    // URL to use as TransportOptions::endpointOverride
+    QString endpointUrl() const;
+
+    // Artificial processing delay per request (simulates Apps Script execution time)
+    void setResponseDelayMs(int ms) { responseDelayMs = ms; }
+
+    qint64 requestsServed() const { return requestCount; }
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct PendingRequest {
+        QByteArray buffer;
+    };
+
+    void handleReadyRead(QTcpSocket* socket);
+    void handleRequest(QTcpSocket* socket, const QByteArray& target, bool keepAlive, bool acceptDeflate);
+    QByteArray handleListSheets(const QJsonArray& ids);
+    QByteArray handleExport(const QJsonObject& settings, int& status);
+    QJsonObject loadSpreadsheet(const QString& spreadsheetId);
+    static QString rowsRevision(const QJsonArray& rows);
+    static QJsonObject columnarSheet(const QJsonArray& rows);
+    void sendResponse(QTcpSocket* socket, int status, const QByteArray& body, bool keepAlive, bool deflate = false);
+
+    static const int MIN_COMPRESSED_BODY = 1024;
+
+    QTcpServer server;
+    QString fixturesDir;
+    struct CachedFixture {
+        QDateTime modified;   // file time the fixture was read at
+        QJsonObject fixture;
+    };
+    QHash<QString, CachedFixture> spreadsheetCache; // spreadsheetId -> fixture
+    QHash<QTcpSocket*, PendingRequest> pending;
+    int responseDelayMs = 0;
+    qint64 requestCount = 0;
+};
@@ -0,0 +1,219 @@
+#include "LocalisationKernels.h"
+#include "CancellationToken.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+QString LocalisationKernels::normalizeValue(const QString& value)
+{
+    static const QRegularExpression whitespace(R"(\s+)");
+    QString normalized = value;
+    normalized.replace(whitespace, " ");
+    return normalized.trimmed();
+}
+
+QString LocalisationKernels::resolveLanguageColumn(const QString& columnName)
+{
+    static const QRegularExpression languageSuffix(R"(\(([^)]+)\))");
+    QRegularExpressionMatch match = languageSuffix.match(columnName);
+    if (!match.hasMatch()) return QString();
+    QString language = match.captured(1);
+    if (language.compare("Braz_Por", Qt::CaseInsensitive) == 0) return "braz_por";
+    return language.toLower();
+}
+
+bool LocalisationKernels::isHeaderValue(const QString& value)
+{
+    return value.contains(" localisation (", Qt::CaseInsensitive);
+}
+
+namespace {
+    // Rest of an entry after the key's colon: ":[0-9]? +\"[^\"]*\"" (the first quote must be closed later on)
+    bool entryTailAt(std::string_view line, size_t colon)
+    {
+        size_t p = colon + 1;
+        if (p < line.size() && line[p] >= '0' && line[p] <= '9') p++;
+        const size_t spaces = p;
+        while (p < line.size() && line[p] == ' ') p++;
+        if (p == spaces || p >= line.size() || line[p] != '"') return false;
+        return line.find('"', p + 1) != std::string_view::npos;
+    }
+
+    bool isLineBreak(char c) { return c == '\n' || c == '\r'; }
+}
+
+// Same result as the former std::regex "^ +(.+?):[0-9]? +\"([^\"]*)\"", without the regex:
+// the key is the shortest run after the leading spaces that is followed by a valid entry tail.
+bool LocalisationKernels::keyOfLine(std::string_view line, std::string_view& key)
+{
+    size_t start = 0;
+    while (start < line.size() && line[start] == ' ') start++;
+    if (start == 0 || start >= line.size()) return false;
+    // '.' in the regex stops at line breaks, so the key cannot reach past one
+    const size_t limit = std::min(line.find_first_of("\r\n", start), line.size());
+    for (size_t c = line.find(':', start + 1); c != std::string_view::npos && c <= limit; c = line.find(':', c + 1)) {
+        if (entryTailAt(line, c)) {
+            key = line.substr(start, c - start);
+            return true;
+        }
+    }
+    // Backtracking case of the regex: a ':' right after the spaces makes the last space the key
+    if (start >= 2 && line[start] == ':' && entryTailAt(line, start)) {
+        key = line.substr(start - 1, 1);
+        return true;
+    }
+    return false;
+}
+
+bool LocalisationKernels::parseKeyLine(const std::string& line, std::string& key)
+{
+    std::string_view view;
+    if (!keyOfLine(line, view)) return false;
+    key.assign(view.data(), view.size());
+    return true;
+}
+
+std::string_view LocalisationKernels::entryKey(const std::string& entry)
+{
+    const size_t colon = entry.find(':');
+    if (colon == std::string::npos) return std::string_view();
+    size_t begin = 0;
+    while (begin < colon && entry[begin] == ' ') begin++;
+    return std::string_view(entry.data() + begin, colon - begin);
+}
+
+// Matches the former std::regex "^( +.+?:[0-9]? +)\"\"$": everything before the closing "" must be
+// spaces, a key, a colon with an optional digit, and spaces.
+bool LocalisationKernels::isEmptyStringEntry(std::string_view line)
+{
+    if (line.size() < 2 || line.substr(line.size() - 2) != "\"\"") return false;
+    const std::string_view prefix = line.substr(0, line.size() - 2);
+    size_t end = prefix.size();
+    while (end > 0 && prefix[end - 1] == ' ') end--;
+    if (end == prefix.size() || end == 0) return false;
+    size_t colon = end - 1;
+    if (prefix[colon] >= '0' && prefix[colon] <= '9' && colon > 0 && prefix[colon - 1] == ':') colon--;
+    if (prefix[colon] != ':' || colon < 2 || prefix[0] != ' ') return false;
+    for (size_t i = 1; i < colon; ++i) {
+        if (isLineBreak(prefix[i])) return false;
+    }
+    return true;
+}
+
+void LocalisationKernels::appendCleanedLine(QByteArray& out, std::string_view line)
+{
+    if (isEmptyStringEntry(line)) {
+        out.append(line.data(), static_cast<qsizetype>(line.size() - 2));
+        out.append("\"\\n\"", 4);
+    }
+    else {
+        out.append(line.data(), static_cast<qsizetype>(line.size()));
+    }
+}
+
+std::string LocalisationKernels::fixEmptyString(const std::string& line)
+{
+    if (!isEmptyStringEntry(line)) return line;
+    return line.substr(0, line.size() - 2) + "\"\\n\"";
+}
+
+bool LocalisationKernels::isValidUtf8(const char* data, qsizetype size, qsizetype* errorOffset)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    qsizetype i = 0;
+    while (i < size) {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        // Skip ASCII 16 bytes at a time: no byte has its top bit set
+        while (i + 16 <= size) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+            if (_mm_movemask_epi8(chunk) != 0) break;
+            i += 16;
+        }
+        if (i >= size) break;
+#endif
+        const unsigned char lead = bytes[i];
+        if (lead < 0x80) { i++; continue; }
+
+        // Length and the allowed range of the second byte (this rules out overlongs and surrogates)
+        int length = 0;
+        unsigned char low = 0x80, high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) length = 2;
+        else if (lead == 0xE0) { length = 3; low = 0xA0; }
+        else if (lead == 0xED) { length = 3; high = 0x9F; }
+        else if (lead >= 0xE1 && lead <= 0xEF) length = 3;
+        else if (lead == 0xF0) { length = 4; low = 0x90; }
+        else if (lead == 0xF4) { length = 4; high = 0x8F; }
+        else if (lead >= 0xF1 && lead <= 0xF3) length = 4;
+
+        bool valid = length > 0 && i + length <= size && bytes[i + 1] >= low && bytes[i + 1] <= high;
+        for (int k = 2; valid && k < length; ++k) valid = (bytes[i + k] & 0xC0) == 0x80;
+        if (!valid) {
+            if (errorOffset) *errorOffset = i;
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+void LocalisationKernels::sortLines(std::vector<std::string>& lines)
+{
+    std::sort(lines.begin(), lines.end());
+}
+
+bool LocalisationKernels::sortLines(std::vector<std::string>& lines, const CancellationToken& cancel)
+{
+    const size_t SORT_CHUNK = 4096;
+    const size_t n = lines.size();
+    for (size_t begin = 0; begin < n; begin += SORT_CHUNK) {
+        if (cancel.isCancelled()) return false;
+        std::sort(lines.begin() + begin, lines.begin() + std::min(n, begin + SORT_CHUNK));
+    }
+    for (size_t width = SORT_CHUNK; width < n; width *= 2) {
+        for (size_t begin = 0; begin + width < n; begin += 2 * width) {
+            if (cancel.isCancelled()) return false;
+            std::inplace_merge(lines.begin() + begin, lines.begin() + begin + width, lines.begin() + std::min(n, begin + 2 * width));
+        }
+    }
+    return true;
+}
+
+QByteArray LocalisationKernels::buildYmlFile(const QString& langLower, const std::vector<std::string>& lines)
+{
+    const QByteArray lang = langLower.toUtf8();
+    qsizetype size = 3 + 2 + lang.size() + 2;
+    for (const auto& line : lines) size += static_cast<qsizetype>(line.size()) + 2;
+
+    QByteArray out;
+    out.reserve(size);
+    out.append("\xEF\xBB\xBF" "l_", 5);
+    out.append(lang);
+    out.append(":\n", 2);
+    for (const auto& line : lines) {
+        out.append(' ');
+        out.append(line.data(), static_cast<qsizetype>(line.size()));
+        out.append('\n');
+    }
+    return out;
+}
+
+int LocalisationKernels::writeYmlFile(const QString& path, const QString& langLower, const std::vector<std::string>& lines, bool atomic)
+{
+    const QByteArray data = buildYmlFile(langLower, lines);
+    // Text mode keeps the platform line endings the files always had
+    if (atomic) {
+        QSaveFile outputFile(path);
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) return -1;
+        if (outputFile.write(data) != data.size() || !outputFile.commit()) return -1;
+    }
+    else {
+        QFile outputFile(path);
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) return -1;
+        if (outputFile.write(data) != data.size()) return -1;
+    }
+    return static_cast<int>(lines.size());
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CancellationToken;
+
+// The per-line building blocks of the create and cleanup pipelines.
+// Shared by Worker and the benchmark executable so both measure exactly the same code.
+namespace LocalisationKernels {
+    // Collapses runs of whitespace to a single space and trims the value
+    QString normalizeValue(const QString& value);
+
+    // Extracts the language from a "KEY (Language)" column name, lower-cased ("Braz_Por" -> "braz_por").
+    // Returns an empty string for columns without a language suffix.
+    QString resolveLanguageColumn(const QString& columnName);
+
+    // True for the "<Category> localisation (...)" header rows that are not real entries
+    bool isHeaderValue(const QString& value);
+
+    // Matches a YML entry line (" KEY:0 \"text\"") and returns its key
+    bool parseKeyLine(const std::string& line, std::string& key);
+    // Same match on raw UTF-8 bytes; key points into line
+    bool keyOfLine(std::string_view line, std::string_view& key);
+
+    // Key of a generated entry ("KEY:0 \"text\"" -> "KEY"); empty if the entry has no ':'
+    std::string_view entryKey(const std::string& entry);
+
+    // Rewrites an entry with an empty string value ("") to "\n" so the game keeps the override
+    std::string fixEmptyString(const std::string& line);
+    // True for the entries fixEmptyString rewrites
+    bool isEmptyStringEntry(std::string_view line);
+    // Appends fixEmptyString(line) to out without an intermediate string
+    void appendCleanedLine(QByteArray& out, std::string_view line);
+
+    // Strict UTF-8 check (no overlongs, surrogates or code points above U+10FFFF).
+    // ASCII runs are skipped 16 bytes at a time with SSE2 where the compiler targets it.
+    bool isValidUtf8(const char* data, qsizetype size, qsizetype* errorOffset = nullptr);
+
+    // Orders entries the way generated files are written
+    void sortLines(std::vector<std::string>& lines);
+    // Same order, sorted in chunks that are then merged so cancel is checked every few thousand lines.
+    // Returns false, with lines in some permutation, if the task was cancelled.
+    bool sortLines(std::vector<std::string>& lines, const CancellationToken& cancel);
+
+    // A generated file's bytes: UTF-8 BOM, "l_<lang>:" header, then one indented entry per line.
+    // Entries must already be UTF-8; they are copied as they are into a buffer sized up front.
+    QByteArray buildYmlFile(const QString& langLower, const std::vector<std::string>& lines);
+
+    // Writes buildYmlFile() with a single write call; atomic replaces the file through a temporary file,
+    // so an interrupted run leaves the previous version. Returns the number of entries or -1 on an I/O error.
+    int writeYmlFile(const QString& path, const QString& langLower, const std::vector<std::string>& lines, bool atomic = false);
+}
@@ -0,0 +1,130 @@
+#include "ModManifest.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+    const char* BUILTIN_MANIFEST = ":/PDG_LocalisationCreator_GUI/mods.json";
+}
+
+const ModCategory* ModDefinition::category(const QString& categoryName) const
+{
+    for (const ModCategory& c : categories) {
+        if (c.name == categoryName) return &c;
+    }
+    return nullptr;
+}
+
+bool ModDefinition::writesLanguage(const QString& langLower) const
+{
+    return languageSet.isEmpty() ? langLower != "italian" : languageSet.contains(langLower);
+}
+
+QStringList ModDefinition::exportLanguages() const
+{
+    QStringList result(languageSet.begin(), languageSet.end());
+    result.sort();
+    return result;
+}
+
+const ModManifest& ModManifest::instance()
+{
+    static const ModManifest manifest = []() {
+        ModManifest m;
+        QString overridePath = qEnvironmentVariable("PDG_MODS_MANIFEST");
+        if (overridePath.isEmpty() && QFileInfo::exists("mods.json")) overridePath = "mods.json";
+        QString overrideError;
+        if (!overridePath.isEmpty() && m.load(overridePath, &overrideError)) return m;
+        // A broken override falls back to the built-in list; the error stays visible through loadError()
+        m.load(BUILTIN_MANIFEST);
+        if (!overrideError.isEmpty()) m.error = overrideError;
+        return m;
+    }();
+    return manifest;
+}
+
+bool ModManifest::load(const QString& path, QString* errorOut)
+{
+    auto fail = [&](const QString& message) {
+        error = message;
+        if (errorOut) *errorOut = message;
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return fail("Could not open mod manifest " + path);
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) return fail(QString("Invalid mod manifest %1: %2").arg(path).arg(parseError.errorString()));
+
+    std::vector<ModDefinition> parsed;
+    for (const QJsonValue& mv : doc.object().value("mods").toArray()) {
+        const QJsonObject modObj = mv.toObject();
+        ModDefinition mod;
+        mod.id = modObj.value("id").toString();
+        mod.modType = modObj.value("modType").toInt();
+        mod.name = modObj.value("name").toString(mod.id);
+        mod.configGroup = modObj.value("configGroup").toString("Sheets/" + mod.id);
+        mod.staticPath = modObj.value("staticPath").toString("static_localisation");
+        if (mod.id.isEmpty() || mod.modType <= 0) return fail("Mod manifest " + path + ": every mod needs an id and a positive modType");
+
+        const QString defaultUrl = modObj.value("webAppUrl").toString();
+        for (const QJsonValue& cv : modObj.value("categories").toArray()) {
+            const QJsonObject catObj = cv.toObject();
+            ModCategory category;
+            category.name = catObj.value("name").toString();
+            category.alias = catObj.value("alias").toString(category.name);
+            category.webAppUrl = catObj.value("webAppUrl").toString(defaultUrl);
+            category.spreadsheetId = catObj.value("spreadsheetId").toString();
+            category.fileTemplate = catObj.value("fileTemplate").toString();
+            if (category.name.isEmpty() || category.spreadsheetId.isEmpty() || !category.fileTemplate.contains("<lang>")) {
+                return fail(QString("Mod manifest %1: category '%2' of %3 needs a name, spreadsheetId and a fileTemplate with <lang>")
+                    .arg(path).arg(category.name).arg(mod.id));
+            }
+            mod.categories.push_back(category);
+        }
+        for (const QJsonValue& lv : modObj.value("languages").toArray()) {
+            mod.languages.push_back(lv.toString());
+            mod.languageSet.insert(lv.toString().toLower());
+        }
+        for (const QJsonValue& kv : modObj.value("removedVanillaKeys").toArray()) mod.removedVanillaKeys.insert(kv.toString().toStdString());
+        mod.keyRulesPath = modObj.value("keyRules").toString();
+        parsed.push_back(std::move(mod));
+    }
+    if (parsed.empty()) return fail("Mod manifest " + path + " defines no mods");
+
+    modList = std::move(parsed);
+    sourcePath = path;
+    error.clear();
+    return true;
+}
+
+const ModDefinition* ModManifest::findByType(int modType) const
+{
+    for (const ModDefinition& mod : modList) {
+        if (mod.modType == modType) return &mod;
+    }
+    return nullptr;
+}
+
+const ModDefinition* ModManifest::findById(const QString& id) const
+{
+    for (const ModDefinition& mod : modList) {
+        if (mod.id.compare(id, Qt::CaseInsensitive) == 0) return &mod;
+    }
+    return nullptr;
+}
+
+const ModDefinition* ModManifest::defaultMod() const
+{
+    return modList.empty() ? nullptr : &modList.front();
+}
+
+QStringList ModManifest::ids() const
+{
+    QStringList result;
+    for (const ModDefinition& mod : modList) result << mod.id;
+    return result;
+}
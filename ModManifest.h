@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// One exported spreadsheet of a mod and the file it is written to
+struct ModCategory {
+    QString name;           // display name, also the key in the selections JSON
+    QString alias;          // short name for summaries
+    QString webAppUrl;
+    QString spreadsheetId;
+    QString fileTemplate;   // e.g. STH_main_l_<lang>.yml
+};
+
+// Everything the pipeline needs to know about one mod
+struct ModDefinition {
+    QString id;             // stable identifier used on the command line and in config keys
+    int modType = 0;        // value passed through doCreateTask/doCleanupTask
+    QString name;
+    QString configGroup;    // config group holding the sheet selections (e.g. "Sheets")
+    QString staticPath;     // static localisation copied into Output by the cleanup
+    std::vector<ModCategory> categories;
+    std::vector<QString> languages;                    // languages the create step exports and the cleanup processes
+    QSet<QString> languageSet;                         // the same, lower-cased for lookups
+    std::unordered_set<std::string> removedVanillaKeys; // vanilla keys always dropped by the cleanup
+    QString keyRulesPath;                              // rule file of further keys the cleanup drops (KeyRuleSet), empty if none
+
+    const ModCategory* category(const QString& categoryName) const;
+    // True if the create step writes langLower: a listed language, or any but Italian when the manifest lists none
+    bool writesLanguage(const QString& langLower) const;
+    // Lower-cased and sorted; empty when the manifest lists none
+    QStringList exportLanguages() const;
+    QString selectionsKey() const { return configGroup + "/SelectionsJson"; }
+};
+
+// The mods the tool can build, read once from mods.json.
+// The built-in manifest is compiled in as a resource; a mods.json in the working directory
+// (or the file named by PDG_MODS_MANIFEST) replaces it without rebuilding.
+class ModManifest
+{
+public:
+    // The manifest loaded at first use
+    static const ModManifest& instance();
+
+    // Reads a manifest file; false (with error set) if it is missing or malformed
+    bool load(const QString& path, QString* error = nullptr);
+
+    const std::vector<ModDefinition>& mods() const { return modList; }
+    const ModDefinition* findByType(int modType) const;
+    const ModDefinition* findById(const QString& id) const;
+    // First mod of the manifest, or nullptr if it has none
+    const ModDefinition* defaultMod() const;
+    QStringList ids() const;
+
+    QString source() const { return sourcePath; }
+    QString loadError() const { return error; }
+
+private:
+    std::vector<ModDefinition> modList;
+    QString sourcePath;
+    QString error;
+};
@@ -0,0 +1,347 @@
+#include "NetworkTransport.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSet>
+#include <QUrlQuery>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    QMutex g_optionsMutex;
+    bool g_optionsSet = false;
+    TransportOptions g_options;
+
+    // Interval at which replayed bodies are released when a bandwidth limit is set
+    const int REPLAY_TICK_MS = 10;
+
+    // Headers describing the wire encoding of the original transfer; the stored body is already decoded
+    bool isTransferHeader(const QByteArray& name)
+    {
+        const QByteArray lower = name.toLower();
+        return lower == "content-length" || lower == "content-encoding" || lower == "transfer-encoding";
+    }
+}
+
+TransportOptions::Mode TransportOptions::modeFromString(const QString& mode)
+{
+    if (mode.compare("record", Qt::CaseInsensitive) == 0) return Record;
+    if (mode.compare("replay", Qt::CaseInsensitive) == 0) return Replay;
+    return Live;
+}
+
+TransportOptions TransportOptions::fromEnvironment()
+{
+    TransportOptions o;
+    o.mode = modeFromString(qEnvironmentVariable("PDG_NET_MODE"));
+    o.directory = qEnvironmentVariable("PDG_NET_DIR", "recordings");
+    o.endpointOverride = qEnvironmentVariable("PDG_API_URL");
+    o.latencyMs = qEnvironmentVariableIntValue("PDG_NET_LATENCY_MS");
+    o.jitterMs = qEnvironmentVariableIntValue("PDG_NET_JITTER_MS");
+    o.bandwidthBytesPerSec = static_cast<qint64>(qEnvironmentVariableIntValue("PDG_NET_BANDWIDTH_KBPS")) * 1024;
+    o.failureRate = qEnvironmentVariable("PDG_NET_FAIL_RATE", "0").toDouble();
+    if (qEnvironmentVariableIsSet("PDG_NET_FAIL_STATUS")) o.failureStatus = qEnvironmentVariableIntValue("PDG_NET_FAIL_STATUS");
+    if (qEnvironmentVariableIsSet("PDG_NET_SEED")) o.seed = static_cast<quint32>(qEnvironmentVariableIntValue("PDG_NET_SEED"));
+    return o;
+}
+
+void NetworkTransport::setDefaultOptions(const TransportOptions& options)
+{
+    QMutexLocker locker(&g_optionsMutex);
+    g_options = options;
+    g_optionsSet = true;
+}
+
+TransportOptions NetworkTransport::defaultOptions()
+{
+    QMutexLocker locker(&g_optionsMutex);
+    if (!g_optionsSet) {
+        g_options = TransportOptions::fromEnvironment();
+        g_optionsSet = true;
+    }
+    return g_options;
+}
+
+QNetworkAccessManager* NetworkTransport::createAccessManager(QObject* parent)
+{
+    return new TransportAccessManager(defaultOptions(), parent);
+}
+
+QNetworkAccessManager* NetworkTransport::sharedAccessManager()
+{
+    static QPointer<QNetworkAccessManager> shared;
+    if (!shared) shared = createAccessManager(QCoreApplication::instance());
+    return shared;
+}
+
+void NetworkTransport::warmUp(QNetworkAccessManager* manager, const QStringList& urls)
+{
+    const TransportAccessManager* transport = qobject_cast<const TransportAccessManager*>(manager);
+    const TransportOptions options = transport ? transport->options() : defaultOptions();
+    if (options.mode == TransportOptions::Replay) return;
+
+    QList<QUrl> targets;
+    for (const QString& value : urls) {
+        const QUrl url(value);
+        if (!options.endpointOverride.isEmpty() && url.host().endsWith("google.com")) {
+            targets << QUrl(options.endpointOverride);
+            continue;
+        }
+        targets << url;
+        // Web apps answer with a redirect to the user content host, which needs its own connection
+        if (url.host() == "script.google.com") targets << QUrl("https://script.googleusercontent.com/");
+    }
+    QSet<QString> opened;
+    for (const QUrl& url : targets) {
+        if (url.host().isEmpty()) continue;
+        const bool secure = url.scheme() == "https";
+        const quint16 port = static_cast<quint16>(url.port(secure ? 443 : 80));
+        const QString origin = url.scheme() + "://" + url.host() + ":" + QString::number(port);
+        if (opened.contains(origin)) continue;
+        opened.insert(origin);
+        if (secure) manager->connectToHostEncrypted(url.host(), port);
+        else manager->connectToHost(url.host(), port);
+    }
+}
+
+QString NetworkTransport::recordingKey(const QUrl& url)
+{
+    // Hash the sorted, decoded query items: export settings JSON or listSheets ids
+    QList<QPair<QString, QString>> items = QUrlQuery(url).queryItems(QUrl::FullyDecoded);
+    std::sort(items.begin(), items.end());
+    QByteArray canonical;
+    QString action = "export";
+    for (const auto& item : items) {
+        canonical += item.first.toUtf8() + '=' + item.second.toUtf8() + '&';
+        if (item.first == "action") action = item.second;
+    }
+    const QByteArray hash = QCryptographicHash::hash(canonical, QCryptographicHash::Sha1).toHex().left(16);
+    return action + "_" + QString::fromLatin1(hash);
+}
+
+QNetworkReply::NetworkError NetworkTransport::errorForHttpStatus(int status)
+{
+    switch (status) {
+    case 401: return QNetworkReply::AuthenticationRequiredError;
+    case 403: return QNetworkReply::ContentAccessDenied;
+    case 404: return QNetworkReply::ContentNotFoundError;
+    case 405: return QNetworkReply::ContentOperationNotPermittedError;
+    case 409: return QNetworkReply::ContentConflictError;
+    case 410: return QNetworkReply::ContentGoneError;
+    case 500: return QNetworkReply::InternalServerError;
+    case 501: return QNetworkReply::OperationNotImplementedError;
+    case 503: return QNetworkReply::ServiceUnavailableError;
+    default: break;
+    }
+    if (status >= 500) return QNetworkReply::UnknownServerError;
+    if (status >= 400) return QNetworkReply::UnknownContentError;
+    return QNetworkReply::NoError;
+}
+
+// ---------------- TransportAccessManager ----------------
+TransportAccessManager::TransportAccessManager(const TransportOptions& options, QObject* parent)
+    : QNetworkAccessManager(parent), m_options(options), m_rng(options.seed)
+{
+    if (m_options.mode != TransportOptions::Live) {
+        QDir().mkpath(m_options.directory);
+    }
+}
+
+QNetworkReply* TransportAccessManager::createRequest(Operation op, const QNetworkRequest& request, QIODevice* outgoingData)
+{
+    const QUrl originalUrl = request.url();
+    QNetworkRequest effective(request);
+
+    // Point Apps Script traffic at another endpoint (local stand-in) while keeping the query intact
+    if (!m_options.endpointOverride.isEmpty() && originalUrl.host().endsWith("google.com")) {
+        QUrl target(m_options.endpointOverride);
+        target.setQuery(originalUrl.query(QUrl::FullyEncoded));
+        effective.setUrl(target);
+    }
+
+    if (m_options.mode == TransportOptions::Replay) {
+        RecordedResponse recorded = loadRecording(originalUrl);
+        if (!recorded.valid) {
+            recorded.httpStatus = 404;
+            recorded.body = "No recording for " + NetworkTransport::recordingKey(originalUrl).toUtf8();
+        }
+        int latency = m_options.latencyMs;
+        if (m_options.jitterMs > 0) latency += std::uniform_int_distribution<int>(0, m_options.jitterMs)(m_rng);
+        const bool fail = m_options.failureRate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(m_rng) < m_options.failureRate;
+        return new ReplayReply(op, effective, recorded, latency, m_options.bandwidthBytesPerSec, m_options.failureStatus, fail, this);
+    }
+
+    QNetworkReply* reply = QNetworkAccessManager::createRequest(op, effective, outgoingData);
+    if (m_options.mode == TransportOptions::Record) {
+        const qint64 startedAt = QDateTime::currentMSecsSinceEpoch();
+        // Connected before any client handler, so the body is peeked before anyone reads it
+        connect(reply, &QNetworkReply::finished, this, [this, originalUrl, reply, startedAt]() {
+            saveRecording(originalUrl, reply, QDateTime::currentMSecsSinceEpoch() - startedAt);
+        });
+    }
+    return reply;
+}
+
+void TransportAccessManager::saveRecording(const QUrl& originalUrl, QNetworkReply* reply, qint64 elapsedMs)
+{
+    const QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    if (!status.isValid()) return; // Connection-level failure: nothing worth replaying
+
+    const QString stem = QDir(m_options.directory).filePath(NetworkTransport::recordingKey(originalUrl));
+    QJsonObject meta;
+    meta["url"] = originalUrl.toString();
+    meta["status"] = status.toInt();
+    meta["elapsedMs"] = elapsedMs;
+    QJsonObject headers;
+    for (const auto& header : reply->rawHeaderPairs()) {
+        if (isTransferHeader(header.first)) continue;
+        headers[QString::fromLatin1(header.first)] = QString::fromLatin1(header.second);
+    }
+    meta["headers"] = headers;
+
+    QSaveFile body(stem + ".body");
+    if (body.open(QIODevice::WriteOnly)) {
+        body.write(reply->peek(reply->bytesAvailable()));
+        body.commit();
+    }
+    QSaveFile metaFile(stem + ".json");
+    if (metaFile.open(QIODevice::WriteOnly)) {
+        metaFile.write(QJsonDocument(meta).toJson(QJsonDocument::Indented));
+        metaFile.commit();
+    }
+}
+
+RecordedResponse TransportAccessManager::loadRecording(const QUrl& url) const
+{
+    RecordedResponse r;
+    const QString stem = QDir(m_options.directory).filePath(NetworkTransport::recordingKey(url));
+    QFile metaFile(stem + ".json");
+    QFile body(stem + ".body");
+    if (!metaFile.open(QIODevice::ReadOnly) || !body.open(QIODevice::ReadOnly)) return r;
+
+    const QJsonObject meta = QJsonDocument::fromJson(metaFile.readAll()).object();
+    r.httpStatus = meta.value("status").toInt(200);
+    r.recordedElapsedMs = meta.value("elapsedMs").toInteger();
+    const QJsonObject headers = meta.value("headers").toObject();
+    for (auto it = headers.begin(); it != headers.end(); ++it) {
+        r.headers.append({ it.key().toLatin1(), it.value().toString().toLatin1() });
+    }
+    r.body = body.readAll();
+    r.valid = true;
+    return r;
+}
+
+// ---------------- ReplayReply ----------------
+ReplayReply::ReplayReply(Operation op, const QNetworkRequest& request, const RecordedResponse& response,
+    int latencyMs, qint64 bandwidthBytesPerSec, int injectedFailureStatus, bool injectFailure, QObject* parent)
+    : QNetworkReply(parent), m_body(response.body), m_injectFailure(injectFailure), m_injectedStatus(injectedFailureStatus)
+{
+    setRequest(request);
+    setOperation(op);
+    setUrl(request.url());
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    if (!injectFailure) {
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, response.httpStatus);
+        for (const auto& header : response.headers) {
+            if (!isTransferHeader(header.first)) setRawHeader(header.first, header.second);
+        }
+        setHeader(QNetworkRequest::ContentLengthHeader, m_body.size());
+    }
+    else {
+        // Injected failures carry no body, like a throttled or dropped request
+        m_body.clear();
+        if (m_injectedStatus > 0) {
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, m_injectedStatus);
+            if (m_injectedStatus == 429) setRawHeader("Retry-After", "1");
+        }
+    }
+
+    if (bandwidthBytesPerSec > 0) {
+        m_chunkBytes = std::max<qint64>(1, bandwidthBytesPerSec * REPLAY_TICK_MS / 1000);
+    }
+    m_timer.setInterval(REPLAY_TICK_MS);
+    connect(&m_timer, &QTimer::timeout, this, &ReplayReply::deliverChunk);
+    QTimer::singleShot(std::max(0, latencyMs), this, &ReplayReply::deliverChunk);
+}
+
+void ReplayReply::abort()
+{
+    if (isFinished()) return;
+    finishWithError(OperationCanceledError, "Operation canceled");
+}
+
+qint64 ReplayReply::bytesAvailable() const
+{
+    return (m_delivered - m_readPos) + QNetworkReply::bytesAvailable();
+}
+
+qint64 ReplayReply::readData(char* data, qint64 maxSize)
+{
+    const qint64 available = m_delivered - m_readPos;
+    if (available <= 0) return isFinished() ? -1 : 0;
+    const qint64 n = std::min(available, maxSize);
+    memcpy(data, m_body.constData() + m_readPos, static_cast<size_t>(n));
+    m_readPos += n;
+    return n;
+}
+
+void ReplayReply::deliverChunk()
+{
+    if (isFinished()) return;
+
+    if (!m_headersSent) {
+        m_headersSent = true;
+        if (m_injectFailure) {
+            if (m_injectedStatus > 0) {
+                emit metaDataChanged();
+                finishWithError(NetworkTransport::errorForHttpStatus(m_injectedStatus), QString("Injected HTTP %1").arg(m_injectedStatus));
+            }
+            else {
+                finishWithError(RemoteHostClosedError, "Injected connection failure");
+            }
+            return;
+        }
+        emit metaDataChanged();
+    }
+
+    const qint64 remaining = m_body.size() - m_delivered;
+    const qint64 step = m_chunkBytes > 0 ? std::min(m_chunkBytes, remaining) : remaining;
+    m_delivered += step;
+    if (step > 0) {
+        emit readyRead();
+        emit downloadProgress(m_delivered, m_body.size());
+    }
+    if (m_delivered < m_body.size()) {
+        if (!m_timer.isActive()) m_timer.start();
+        return;
+    }
+
+    m_timer.stop();
+    const int status = attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status >= 400) {
+        // Like a real reply: the error body stays readable
+        finishWithError(NetworkTransport::errorForHttpStatus(status), QString("Replayed HTTP %1").arg(status));
+        return;
+    }
+    setFinished(true);
+    emit finished();
+}
+
+void ReplayReply::finishWithError(NetworkError code, const QString& message)
+{
+    m_timer.stop();
+    setError(code, message);
+    emit errorOccurred(code);
+    setFinished(true);
+    emit finished();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <random>
+
+// How Worker and SheetsSelectionDialog talk to the Apps Script API.
+// Live hits the network, Record additionally captures every response to disk,
+// Replay serves previously captured responses without any network access.
+struct TransportOptions {
+    enum Mode { Live, Record, Replay };
+
+    Mode mode = Live;
+    QString directory;               // Recording directory (Record/Replay)
+    QString endpointOverride;        // Redirects script.google.com requests, e.g. to the local stand-in
+    int latencyMs = 0;               // Replay: time to first byte
+    int jitterMs = 0;                // Replay: uniform extra latency in [0, jitterMs]
+    qint64 bandwidthBytesPerSec = 0; // Replay: 0 = unlimited
+    double failureRate = 0.0;        // Replay: probability of an injected failure per request
+    int failureStatus = 503;         // Replay: HTTP status of injected failures (0 = connection error)
+    quint32 seed = 1;                // Replay: RNG seed so latency/failure sequences are reproducible
+
+    // Reads PDG_NET_MODE, PDG_NET_DIR, PDG_API_URL, PDG_NET_LATENCY_MS, PDG_NET_JITTER_MS,
+    // PDG_NET_BANDWIDTH_KBPS, PDG_NET_FAIL_RATE, PDG_NET_FAIL_STATUS and PDG_NET_SEED
+    static TransportOptions fromEnvironment();
+    static Mode modeFromString(const QString& mode);
+};
+
+namespace NetworkTransport {
+    // Process-wide options used by createAccessManager (defaults to fromEnvironment())
+    void setDefaultOptions(const TransportOptions& options);
+    TransportOptions defaultOptions();
+
+    // Creates the access manager every API client should use instead of a plain QNetworkAccessManager
+    QNetworkAccessManager* createAccessManager(QObject* parent);
+    // The GUI thread's access manager, created on first use and kept for the application's lifetime,
+    // so dialogs reuse the connections opened at start-up. Only for use on the GUI thread.
+    QNetworkAccessManager* sharedAccessManager();
+
+    // Opens connections (TLS for https) to the hosts of the given Apps Script URLs ahead of the first request,
+    // honouring the endpoint override; does nothing in Replay mode
+    void warmUp(QNetworkAccessManager* manager, const QStringList& urls);
+
+    // Stable file name stem for a request, independent of host so recordings survive endpoint overrides
+    QString recordingKey(const QUrl& url);
+
+    // Maps an HTTP status to the error QNetworkReply would report for it
+    QNetworkReply::NetworkError errorForHttpStatus(int status);
+}
+
+// A captured response as stored on disk
+struct RecordedResponse {
+    bool valid = false;
+    int httpStatus = 200;
+    QByteArray body;
+    QList<QPair<QByteArray, QByteArray>> headers;
+    qint64 recordedElapsedMs = 0;
+};
+
+// QNetworkAccessManager that records or replays according to TransportOptions
+class TransportAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    explicit TransportAccessManager(const TransportOptions& options, QObject* parent = nullptr);
+
+    const TransportOptions& options() const { return m_options; }
+
+protected:
+    QNetworkReply* createRequest(Operation op, const QNetworkRequest& request, QIODevice* outgoingData = nullptr) override;
+
+private:
+    void saveRecording(const QUrl& originalUrl, QNetworkReply* reply, qint64 elapsedMs);
+    RecordedResponse loadRecording(const QUrl& url) const;
+
+    TransportOptions m_options;
+    std::mt19937 m_rng;
+};
+
+// Serves a RecordedResponse with simulated latency, bandwidth and failures
+class ReplayReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    ReplayReply(Operation op, const QNetworkRequest& request, const RecordedResponse& response,
+        int latencyMs, qint64 bandwidthBytesPerSec, int injectedFailureStatus, bool injectFailure, QObject* parent = nullptr);
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+
+private slots:
+    void deliverChunk();
+
+private:
+    void finishWithError(NetworkError code, const QString& message);
+
+    QByteArray m_body;
+    qint64 m_delivered = 0;   // bytes made available so far
+    qint64 m_readPos = 0;     // bytes consumed by the reader
+    qint64 m_chunkBytes = 0;  // bytes released per tick (0 = everything at once)
+    bool m_injectFailure = false;
+    int m_injectedStatus = 0;
+    bool m_headersSent = false;
+    QTimer m_timer;
+};
@@ -15,11 +15,14 @@
 #include <QJsonArray>
 #include <QStringList>
 #include <QTimer>
+#include <QSignalBlocker>
 #include <QDesktopServices>
 #include <QUrl>
 #include "ConfigManager.h" // Assuming ConfigManager is included and defined
 #include "SheetsSelectionDialog.h" // Assuming SheetsSelectionDialog is included and defined
+#include "KeyExplorerDialog.h"
 #include "ProgressOverlay.h" // Extracted overlay classes
+#include "NetworkTransport.h"
 
 // Overlay classes moved to ProgressOverlay.h/cpp
 
@@ -46,8 +49,22 @@ PDG_LocalisationCreator_GUI::PDG_LocalisationCreator_GUI(QWidget* parent)
     // Initialize ConfigManager and load settings
     configManager = new ConfigManager(this); // Parented to GUI
     loadPathsFromConfig();
+    // The mod to build comes from the mod manifest; Mods/Active picks one when it lists several
+    const ModManifest& manifest = ModManifest::instance();
+    activeMod = manifest.findById(configManager->loadSetting("Mods/Active", "").toString());
+    if (!activeMod) activeMod = manifest.defaultMod();
+    if (!manifest.loadError().isEmpty()) {
+        QMessageBox::warning(this, "Mod Manifest", manifest.loadError() + "\nUsing the built-in mod list.");
+    }
+    if (!activeMod) {
+        QMessageBox::critical(this, "Mod Manifest", "No mods are defined; localisation cannot be created.");
+        ui->unifiedRunButton->setEnabled(false);
+        ui->selectSheetsButton->setEnabled(false);
+        ui->watchCheckBox->setEnabled(false);
+        ui->keyExplorerButton->setEnabled(false);
+    }
     // Load saved sheet selections JSON if present
-    sheetsSelectionsJson = configManager->loadSetting("Sheets/SelectionsJson", "{}").toString();
+    sheetsSelectionsJson = activeMod ? configManager->loadSetting(activeMod->selectionsKey(), "{}").toString() : QString("{}");
     updateSheetsSummary();
 
     // Connect signals from the worker thread to slots in this (main) thread
@@ -63,7 +80,44 @@ PDG_LocalisationCreator_GUI::PDG_LocalisationCreator_GUI(QWidget* parent)
     // Connect worker's logMessage to the file writer slot
     connect(worker, &Worker::logMessage, this, &PDG_LocalisationCreator_GUI::writeToLogFile);
 
+    // Watch mode runs incremental cycles on the same worker
+    watchController = new WatchController(worker, this);
+    connect(watchController, &WatchController::logMessage, this, &PDG_LocalisationCreator_GUI::writeToLogFile);
+    connect(watchController, &WatchController::cycleStarted, this, [this](const QString& reason) {
+        writeToLogFile("Watch cycle started: " + reason);
+        ui->watchCheckBox->setText("Watch (rebuilding…)");
+    });
+    connect(watchController, &WatchController::cycleFinished, this, [this](bool success, const QString& summary) {
+        ui->watchCheckBox->setText(success ? "Watch" : "Watch (errors)");
+        ui->watchCheckBox->setToolTip(QString("Last cycle %1: %2\nLog: %3")
+            .arg(QTime::currentTime().toString("hh:mm:ss")).arg(summary).arg(currentLogFileName));
+    });
+
     workerThread.start(); // Start the worker thread
+
+    // Open the Apps Script connections now rather than on the first click (the dialog shares the GUI thread's manager)
+    if (activeMod) {
+        QStringList urls;
+        for (const ModCategory& category : activeMod->categories) urls << category.webAppUrl;
+        NetworkTransport::warmUp(NetworkTransport::sharedAccessManager(), urls);
+        QMetaObject::invokeMethod(worker, "warmUp", Qt::QueuedConnection, Q_ARG(int, activeMod->modType));
+        startPrefetch();
+    }
+}
+
+// Fetches the saved selection's exports in the background when Network/Prefetch is on; a run started while
+// they are fresh uses them
+void PDG_LocalisationCreator_GUI::startPrefetch()
+{
+    if (!activeMod || !configManager->loadSetting("Network/Prefetch", false).toBool()) return;
+    QMetaObject::invokeMethod(worker, "setDeltaExport", Qt::QueuedConnection,
+        Q_ARG(bool, configManager->loadSetting("Create/DeltaExport", true).toBool()));
+    QMetaObject::invokeMethod(worker, "setCompactExport", Qt::QueuedConnection,
+        Q_ARG(bool, configManager->loadSetting("Network/CompactExport", true).toBool()));
+    QMetaObject::invokeMethod(worker, "setPrefetchMaxAge", Qt::QueuedConnection,
+        Q_ARG(int, configManager->loadSetting("Network/PrefetchMaxAgeSec", 120).toInt()));
+    QMetaObject::invokeMethod(worker, "prefetchExports", Qt::QueuedConnection,
+        Q_ARG(int, activeMod->modType), Q_ARG(QString, sheetsSelectionsJson));
 }
 
 // Keep overlay sized to window
@@ -90,7 +144,8 @@ PDG_LocalisationCreator_GUI::~PDG_LocalisationCreator_GUI()
 // Slot: Handles the unified run button click, sets up log file, disables UI, and starts creation task
 void PDG_LocalisationCreator_GUI::on_unifiedRunButton_clicked()
 {
-    int modType = 1; // Only STNH is available now
+    if (!activeMod) return;
+    const int modType = activeMod->modType;
 
     // Get the paths from QLineEdit fields
     QString outputPath = ui->outputPathLineEdit->text();
@@ -119,11 +174,18 @@ void PDG_LocalisationCreator_GUI::on_unifiedRunButton_clicked()
         connect(worker, &Worker::statusMessage,  progressPanel, &ProgressPanel::setStatusText,       Qt::UniqueConnection);
         connect(worker, &Worker::fetchActive,    progressPanel, &ProgressPanel::setFetchingActive,   Qt::UniqueConnection);
         connect(worker, &Worker::processActive,  progressPanel, &ProgressPanel::setProcessingActive, Qt::UniqueConnection);
+        connect(worker, &Worker::metricsUpdated, progressPanel, &ProgressPanel::setMetrics,          Qt::UniqueConnection);
         // Allow user to dismiss overlay when finished
         connect(progressPanel, &ProgressPanel::dismissRequested, this, [this]() {
             if (overlayWidget) overlayWidget->hideOverlay();
             if (progressPanel) progressPanel->setDismissVisible(false);
         });
+        // The token is thread-safe, so the request goes straight to the worker instead of through its busy event loop
+        connect(progressPanel, &ProgressPanel::cancelRequested, this, [this]() {
+            cancelPending = true;
+            writeToLogFile("Cancel requested by user.");
+            worker->requestCancel();
+        });
     }
     // Set initial state and show overlay
     if (progressPanel) {
@@ -131,25 +193,16 @@ void PDG_LocalisationCreator_GUI::on_unifiedRunButton_clicked()
         progressPanel->setOverallProgress(0);
         progressPanel->setFetchingActive(false);
         progressPanel->setProcessingActive(false);
+        progressPanel->setMetrics(WorkerMetrics());
         progressPanel->setDismissVisible(false);
+        progressPanel->setCancelVisible(true);
     }
+    cancelPending = false;
     overlayWidget->showOverlay();
 
     // Setup logging for this run
-    QDateTime currentDateTime = QDateTime::currentDateTime();
-    currentLogFileName = "logs/log_" + currentDateTime.toString("yyyy-MM-dd_hh-mm-ss") + ".txt";
-
-    // Ensure log directory exists
-    QDir logsDir("logs");
-    if (!logsDir.exists()) {
-        logsDir.mkpath(".");
-    }
-
-    writeToLogFile("--- Log Session Started: " + currentDateTime.toString(Qt::ISODate) + " ---");
-    writeToLogFile("DEBUG GUI: Log file system initialized and ready.");
-    writeToLogFile("STARTING NEW LOCALISATION PROCESS");
-    writeToLogFile("Log file: " + currentLogFileName);
-    writeToLogFile("Selected Mod Type: " + QString::number(modType));
+    startLogSession("STARTING NEW LOCALISATION PROCESS");
+    writeToLogFile("Selected Mod: " + activeMod->name + " (type " + QString::number(modType) + ")");
     writeToLogFile("Output Path: " + outputPath);
     writeToLogFile("Vanilla Path: " + vanillaPath);
     writeToLogFile("Timestamp: " + QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
@@ -157,6 +210,28 @@ void PDG_LocalisationCreator_GUI::on_unifiedRunButton_clicked()
     // Status shown via the progress overlay
     // Provide selections to worker (queued to its thread)
     QMetaObject::invokeMethod(worker, "setSelectionsJson", Qt::QueuedConnection, Q_ARG(QString, sheetsSelectionsJson));
+    QMetaObject::invokeMethod(worker, "setDeltaExport", Qt::QueuedConnection,
+        Q_ARG(bool, configManager->loadSetting("Create/DeltaExport", true).toBool()));
+    QMetaObject::invokeMethod(worker, "setSheetCacheDirectory", Qt::QueuedConnection,
+        Q_ARG(QString, configManager->loadSetting("Create/SheetCacheDir", "cache/sheets").toString()));
+    QMetaObject::invokeMethod(worker, "setReportDirectory", Qt::QueuedConnection,
+        Q_ARG(QString, configManager->loadSetting("Reports/Directory", "reports").toString()));
+    QMetaObject::invokeMethod(worker, "setKeyDiffDirectory", Qt::QueuedConnection,
+        Q_ARG(QString, configManager->loadSetting("Reports/KeyDiff", true).toBool() ? QFileInfo(currentLogFileName).path() : QString()));
+    QMetaObject::invokeMethod(worker, "setValidateUtf8", Qt::QueuedConnection,
+        Q_ARG(bool, configManager->loadSetting("Cleanup/ValidateUtf8", false).toBool()));
+    QMetaObject::invokeMethod(worker, "setVanillaFilter", Qt::QueuedConnection,
+        Q_ARG(QStringList, configManager->loadSetting("Cleanup/IncludeGlobs", VanillaIndex::Filter::defaultInclude()).toStringList()),
+        Q_ARG(QStringList, configManager->loadSetting("Cleanup/ExcludeGlobs", VanillaIndex::Filter::defaultExclude()).toStringList()));
+    QMetaObject::invokeMethod(worker, "setRequestLimits", Qt::QueuedConnection,
+        Q_ARG(int, configManager->loadSetting("Network/MaxConcurrentRequests", 6).toInt()),
+        Q_ARG(int, configManager->loadSetting("Network/RequestTimeoutSec", 120).toInt()));
+    QMetaObject::invokeMethod(worker, "setHedgeBudget", Qt::QueuedConnection,
+        Q_ARG(int, configManager->loadSetting("Network/HedgeBudgetPercent", 0).toInt()));
+    QMetaObject::invokeMethod(worker, "setCompactExport", Qt::QueuedConnection,
+        Q_ARG(bool, configManager->loadSetting("Network/CompactExport", true).toBool()));
+    QMetaObject::invokeMethod(worker, "setPlanMode", Qt::QueuedConnection,
+        Q_ARG(bool, configManager->loadSetting("Create/PlanMode", false).toBool()));
     // Start the creation task in the worker thread, passing the paths
     QMetaObject::invokeMethod(worker, "doCreateTask", Qt::QueuedConnection,
         Q_ARG(int, modType),
@@ -172,7 +247,7 @@ void PDG_LocalisationCreator_GUI::handleProgressUpdate(int value)
 }
 
 // Slot: Handles task completion, manages log, UI state, and triggers cleanup if needed
-void PDG_LocalisationCreator_GUI::handleTaskFinished(bool success, const QString& message)
+void PDG_LocalisationCreator_GUI::handleTaskFinished(bool success, const QString& message, bool cancelled)
 {
     // Log final status before closing stream
     writeToLogFile("Task Sequence Finished");
@@ -182,9 +257,20 @@ void PDG_LocalisationCreator_GUI::handleTaskFinished(bool success, const QString
         writeToLogFile("Please check this log file for detailed errors.");
     }
 
+    // A cancel the user asked for is not an error: skip the remaining steps and close the overlay.
+    // A cancel clicked after the create's last check still stops here; the cleanup would reset the token.
+    if (cancelled || (cancelPending && !isCleanupStep)) {
+        cancelPending = false;
+        if (progressPanel) progressPanel->setCancelVisible(false);
+        isCleanupStep = false;
+        setUiEnabled(true);
+        if (overlayWidget) { overlayWidget->hideOverlay(); }
+        return;
+    }
+
     if (!isCleanupStep) { // If the creation task just finished
         if (success) {
-            int modType = 1;
+            const int modType = activeMod->modType;
 
             // Get the paths from QLineEdit fields for cleanup task
             QString inputPath = ""; // Input path is no longer needed
@@ -204,6 +290,7 @@ void PDG_LocalisationCreator_GUI::handleTaskFinished(bool success, const QString
                 Q_ARG(QString, vanillaPath));
         }
         else { // If creation failed
+            if (progressPanel) progressPanel->setCancelVisible(false);
             setUiEnabled(true);
             QMessageBox::critical(this, "Error", message + "\nCreation failed. Check the log file for details: " + currentLogFileName);
             isCleanupStep = false;
@@ -211,6 +298,7 @@ void PDG_LocalisationCreator_GUI::handleTaskFinished(bool success, const QString
         }
     }
     else { // If the cleanup task just finished
+        if (progressPanel) progressPanel->setCancelVisible(false);
         setUiEnabled(true);
 
         if (!success) {
@@ -310,6 +398,63 @@ void PDG_LocalisationCreator_GUI::cleanOldLogs()
     qDebug() << "Log cleanup finished.";
 }
 
+// Starts a new log file under logs/ and writes the session header
+void PDG_LocalisationCreator_GUI::startLogSession(const QString& title)
+{
+    QDateTime currentDateTime = QDateTime::currentDateTime();
+    currentLogFileName = "logs/log_" + currentDateTime.toString("yyyy-MM-dd_hh-mm-ss") + ".txt";
+
+    // Ensure log directory exists
+    QDir logsDir("logs");
+    if (!logsDir.exists()) {
+        logsDir.mkpath(".");
+    }
+
+    writeToLogFile("--- Log Session Started: " + currentDateTime.toString(Qt::ISODate) + " ---");
+    writeToLogFile("DEBUG GUI: Log file system initialized and ready.");
+    writeToLogFile(title);
+    writeToLogFile("Log file: " + currentLogFileName);
+}
+
+// Slot: Starts or stops watch mode (incremental rebuilds whenever sheets or local files change)
+void PDG_LocalisationCreator_GUI::on_watchCheckBox_toggled(bool checked)
+{
+    if (!checked) {
+        watchController->stop();
+        ui->watchCheckBox->setText("Watch");
+        ui->unifiedRunButton->setEnabled(true);
+        ui->folderSelectionBox->setEnabled(true);
+        return;
+    }
+
+    QString outputPath = ui->outputPathLineEdit->text();
+    QString vanillaPath = ui->vanillaPathLineEdit->text();
+    if (!activeMod || outputPath.isEmpty() || vanillaPath.isEmpty()) {
+        QMessageBox::warning(this, "Missing Paths", "Please select all Output, and Vanilla Files directories before watching.");
+        const QSignalBlocker blocker(ui->watchCheckBox);
+        ui->watchCheckBox->setChecked(false);
+        return;
+    }
+    savePathsToConfig();
+
+    // Paths stay fixed while watching; sheet selections may still change
+    ui->unifiedRunButton->setEnabled(false);
+    ui->folderSelectionBox->setEnabled(false);
+
+    startLogSession("STARTING WATCH MODE");
+    writeToLogFile("Output Path: " + outputPath);
+    writeToLogFile("Vanilla Path: " + vanillaPath);
+
+    WatchOptions options;
+    options.outputPath = outputPath;
+    options.vanillaPath = vanillaPath;
+    options.modType = activeMod->modType;
+    options.staticPath = activeMod->staticPath;
+    options.pollIntervalSec = configManager->loadSetting("Watch/PollIntervalSec", options.pollIntervalSec).toInt();
+    QMetaObject::invokeMethod(worker, "setSelectionsJson", Qt::QueuedConnection, Q_ARG(QString, sheetsSelectionsJson));
+    watchController->start(options);
+}
+
 // New Slot: Handle Output Path selection
 void PDG_LocalisationCreator_GUI::on_outputPathButton_clicked()
 {
@@ -338,6 +483,7 @@ void PDG_LocalisationCreator_GUI::loadPathsFromConfig()
 // New: Saves current paths from UI to config file
 void PDG_LocalisationCreator_GUI::savePathsToConfig()
 {
+    ConfigTransaction transaction(configManager);
     configManager->saveSetting("Paths/OutputPath", ui->outputPathLineEdit->text());
     configManager->saveSetting("Paths/VanillaPath", ui->vanillaPathLineEdit->text());
     qDebug() << "Saved configuration paths.";
@@ -346,19 +492,36 @@ void PDG_LocalisationCreator_GUI::savePathsToConfig()
 // New: open the sheets selection dialog when button clicked
 void PDG_LocalisationCreator_GUI::on_selectSheetsButton_clicked()
 {
+    if (!activeMod) return;
     // Reuse a single dialog instance to avoid re-fetching sheets; reset to saved before showing
     if (!sheetsSelectionDialog) {
-        sheetsSelectionDialog = new SheetsSelectionDialog(configManager, this);
+        sheetsSelectionDialog = new SheetsSelectionDialog(configManager, *activeMod, this);
     }
     sheetsSelectionDialog->resetToSavedSelections();
     if (sheetsSelectionDialog->exec() == QDialog::Accepted) {
+        // Per-category ids and the combined JSON are written together
+        ConfigTransaction transaction(configManager);
         sheetsSelectionsJson = sheetsSelectionDialog->selectionsJson();
         // Persist selections JSON
-        configManager->saveSetting("Sheets/SelectionsJson", sheetsSelectionsJson);
+        configManager->saveSetting(activeMod->selectionsKey(), sheetsSelectionsJson);
         updateSheetsSummary();
+        startPrefetch();
+        if (watchController->isActive()) {
+            QMetaObject::invokeMethod(worker, "setSelectionsJson", Qt::QueuedConnection, Q_ARG(QString, sheetsSelectionsJson));
+            watchController->requestSheetsRefresh();
+        }
     }
 }
 
+// Opens the key index saved by the last create + cleanup of the active mod
+void PDG_LocalisationCreator_GUI::on_keyExplorerButton_clicked()
+{
+    if (!activeMod) return;
+    const QString sheetCacheDir = configManager->loadSetting("Create/SheetCacheDir", "cache/sheets").toString();
+    KeyExplorerDialog dialog(*activeMod, KeyIndex::pathFor(sheetCacheDir, activeMod->id), this);
+    dialog.exec();
+}
+
 // New: update the summary label with counts per category
 void PDG_LocalisationCreator_GUI::updateSheetsSummary()
 {
@@ -389,15 +552,10 @@ void PDG_LocalisationCreator_GUI::updateSheetsSummary()
         return;
     }
 
-    // Optional: map long names to shorter aliases for compactness
-    auto alias = [](const QString& k) -> QString {
-        if (k.startsWith("Main", Qt::CaseInsensitive)) return "Main";
-        if (k.startsWith("Ships", Qt::CaseInsensitive)) return "Ships";
-        if (k.startsWith("Modifiers", Qt::CaseInsensitive)) return "Modifiers";
-        if (k.startsWith("Events", Qt::CaseInsensitive)) return "Events";
-        if (k.startsWith("Tech", Qt::CaseInsensitive)) return "Tech";
-        if (k.startsWith("Synced", Qt::CaseInsensitive)) return "Synced";
-        return k;
+    // Short category names from the mod manifest keep the summary compact
+    auto alias = [this](const QString& k) -> QString {
+        const ModCategory* category = activeMod ? activeMod->category(k) : nullptr;
+        return category ? category->alias : k;
     };
 
     // Build pill badges using RichText HTML
@@ -8,6 +8,8 @@
 #include <QScopedPointer>
 #include "ConfigManager.h" // New: Include the ConfigManager header
 #include "SheetsSelectionDialog.h" // Include the SheetsSelectionDialog header
+#include "WatchController.h"
+#include "ModManifest.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class PDG_LocalisationCreator_GUIClass; };
@@ -40,7 +42,7 @@ private slots:
     // Slot: updates the progress bar value.
     void handleProgressUpdate(int value);
     // Slot: handles completion of worker tasks.
-    void handleTaskFinished(bool success, const QString& message);
+    void handleTaskFinished(bool success, const QString& message, bool cancelled);
     // Slot: updates status in the progress dialog.
     void handleStatusMessage(const QString& message);
     // Slot: writes a message to the log file.
@@ -52,12 +54,19 @@ private slots:
 
     // New: open the sheets selection dialog
     void on_selectSheetsButton_clicked();
+    // Open the key explorer on the active mod's key index
+    void on_keyExplorerButton_clicked();
+
+    // Watch mode: start or stop automatic incremental rebuilds
+    void on_watchCheckBox_toggled(bool checked);
 
 private:
     // Enables or disables UI controls during processing.
     void setUiEnabled(bool enabled);
     // Removes old log files from the logs directory.
     void cleanOldLogs();
+    // Starts a new log file for this run
+    void startLogSession(const QString& title);
     // New: Loads paths from config file and updates UI
     void loadPathsFromConfig();
     // New: Saves current paths from UI to config file
@@ -65,21 +74,28 @@ private:
 
     // New: Update the summary label for selected sheets
     void updateSheetsSummary();
+    // Background prefetch of the saved selection's exports, if enabled
+    void startPrefetch();
 
     Ui::PDG_LocalisationCreator_GUIClass* ui; // Pointer to the UI elements.
     QThread workerThread;                     // Thread for running the worker object.
     Worker* worker;                           // Pointer to the background worker.
     bool isCleanupStep;                       // Flag to track if the cleanup step is running.
+    bool cancelPending = false;               // Cancel clicked; no further step is started after the current one.
     QString currentLogFileName;               // Name of the current log file.
 
     ConfigManager* configManager;             // New: Instance of ConfigManager
 
     // New: cached selections JSON (category -> [sheetIds])
     QString sheetsSelectionsJson;
+    const ModDefinition* activeMod = nullptr; // mod built by ENGAGE and watch mode (config Mods/Active)
 
     // New: SheetsSelectionDialog instance
     SheetsSelectionDialog* sheetsSelectionDialog;
 
+    // Watch mode driver (incremental rebuilds on sheet or file changes)
+    WatchController* watchController = nullptr;
+
     // New: In-window overlay and panel (Option B)
     OverlayWidget* overlayWidget = nullptr;
     ProgressPanel* progressPanel = nullptr;
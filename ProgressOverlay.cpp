@@ -1,6 +1,7 @@
 #include "ProgressOverlay.h"
 #include <QEasingCurve>
 #include <QPainter>
+#include <QLocale>
 
 // ---------------- ProgressPanel ----------------
 ProgressPanel::ProgressPanel(QWidget* parent)
@@ -55,6 +56,14 @@ ProgressPanel::ProgressPanel(QWidget* parent)
 
     root->addLayout(grid);
 
+    metricsLabel = new QLabel(this);
+    QFont mf = metricsLabel->font();
+    mf.setPointSize(std::max(8, mf.pointSize() - 1));
+    metricsLabel->setFont(mf);
+    metricsLabel->setAlignment(Qt::AlignLeft | Qt::AlignVCenter);
+    metricsLabel->setVisible(false);
+    root->addWidget(metricsLabel);
+
     // Dismiss button, hidden by default; becomes visible on completion
     dismissBtn = new QPushButton("Close", this);
     dismissBtn->setVisible(false);
@@ -62,6 +71,16 @@ ProgressPanel::ProgressPanel(QWidget* parent)
     QObject::connect(dismissBtn, &QPushButton::clicked, this, [this]() { emit dismissRequested(); });
     root->addWidget(dismissBtn, 0, Qt::AlignHCenter);
 
+    // Cancel button, visible while a task runs; disabled once clicked until the task stops
+    cancelBtn = new QPushButton("Cancel", this);
+    cancelBtn->setVisible(false);
+    QObject::connect(cancelBtn, &QPushButton::clicked, this, [this]() {
+        cancelBtn->setEnabled(false);
+        cancelBtn->setText("Cancelling…");
+        emit cancelRequested();
+    });
+    root->addWidget(cancelBtn, 0, Qt::AlignHCenter);
+
     // Card-like styling via stylesheet (ensure styled background is drawn)
     setObjectName("card");
     setAttribute(Qt::WA_StyledBackground, true);
@@ -96,6 +115,36 @@ void ProgressPanel::setDismissVisible(bool visible) {
     if (dismissBtn) dismissBtn->setVisible(visible);
 }
 
+void ProgressPanel::setCancelVisible(bool visible) {
+    if (!cancelBtn) return;
+    cancelBtn->setEnabled(true);
+    cancelBtn->setText("Cancel");
+    cancelBtn->setVisible(visible);
+}
+
+void ProgressPanel::setMetrics(const WorkerMetrics& m) {
+    if (!metricsLabel) return;
+    const QLocale locale;
+    auto rate = [&](double bytesPerSec) { return locale.formattedDataSize(static_cast<qint64>(bytesPerSec)) + "/s"; };
+    QStringList lines;
+    if (m.remainingMs >= 0 && m.percent() < 100) lines << "About " + WorkerMetrics::formatDuration(m.remainingMs) + " left";
+    if (m.bytesDownloaded > 0) {
+        lines << QString("Download: %1 (%2)").arg(rate(m.downloadBytesPerSec), locale.formattedDataSize(m.bytesDownloaded));
+    }
+    if (m.rowsParsed > 0) {
+        lines << QString("Rows parsed: %1 (%2/s)").arg(m.rowsParsed).arg(static_cast<qint64>(m.rowsPerSec));
+    }
+    if (m.vanillaBytes > 0) {
+        lines << QString("Vanilla: %1 (%2)").arg(rate(m.vanillaBytesPerSec), locale.formattedDataSize(m.vanillaBytes));
+    }
+    if (m.filesWritten > 0) lines << QString("Files written: %1").arg(m.filesWritten);
+    if (m.requestsInFlight > 0 || m.requestsWaiting > 0 || m.itemsQueued > 0) {
+        lines << QString("Queue: %1 in flight, %2 retrying, %3 pending").arg(m.requestsInFlight).arg(m.requestsWaiting).arg(m.itemsQueued);
+    }
+    metricsLabel->setText(lines.join('\n'));
+    metricsLabel->setVisible(!lines.isEmpty());
+}
+
 // ---------------- OverlayWidget ----------------
 OverlayWidget::OverlayWidget(QWidget* parent)
     : QWidget(parent)
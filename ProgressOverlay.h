@@ -8,6 +8,7 @@
 #include <QGraphicsOpacityEffect>
 #include <QPropertyAnimation>
 #include <QPushButton>
+#include "WorkerMetrics.h"
 
 // Lightweight progress panel embedded in an overlay
 class ProgressPanel : public QWidget {
@@ -20,9 +21,14 @@ public:
     void setFetchingActive(bool active);
     void setProcessingActive(bool active);
     void setDismissVisible(bool visible);
+    // Cancel button shown while a task runs; showing it re-arms it after a previous click
+    void setCancelVisible(bool visible);
+    // Time left, live throughput and queue depths; a default-constructed value clears them
+    void setMetrics(const WorkerMetrics& metrics);
 
 signals:
     void dismissRequested();
+    void cancelRequested();
 
 private:
     QLabel* header = nullptr;
@@ -31,7 +37,9 @@ private:
     QProgressBar* processBar = nullptr;
     QLabel* fetchLabel = nullptr;
     QLabel* processLabel = nullptr;
+    QLabel* metricsLabel = nullptr;
     QPushButton* dismissBtn = nullptr;
+    QPushButton* cancelBtn = nullptr;
 };
 
 // Full-window overlay that centers a ProgressPanel and fades in/out
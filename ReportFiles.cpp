@@ -0,0 +1,28 @@
+#include "ReportFiles.h"
+#include <QDir>
+#include <QSaveFile>
+
+QByteArray ReportFiles::csvField(const QString& value)
+{
+    QByteArray utf8 = value.toUtf8();
+    if (!utf8.contains(',') && !utf8.contains('"') && !utf8.contains('\n')) return utf8;
+    utf8.replace("\"", "\"\"");
+    return "\"" + utf8 + "\"";
+}
+
+bool ReportFiles::ensureDirectory(const QString& dir, QString* error)
+{
+    if (QDir().mkpath(dir)) return true;
+    if (error) *error = "Could not create report directory " + dir;
+    return false;
+}
+
+bool ReportFiles::writeFile(const QString& path, const QByteArray& data, QString* error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        if (error) *error = "Could not write " + path;
+        return false;
+    }
+    return true;
+}
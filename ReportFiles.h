@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Small helpers shared by the run reports (coverage, key conflicts)
+namespace ReportFiles {
+    // A CSV field, quoted only when it contains a comma, quote or line break
+    QByteArray csvField(const QString& value);
+
+    // Creates dir if needed; false with error set on failure
+    bool ensureDirectory(const QString& dir, QString* error);
+
+    // Replaces path with data atomically; false with error set on failure
+    bool writeFile(const QString& path, const QByteArray& data, QString* error);
+}
@@ -0,0 +1,153 @@
+#include "RequestScheduler.h"
+#include <QDateTime>
+#include <QVariant>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+    // A successful attempt this much slower than its key's baseline counts as a congestion signal
+    const double SLOW_FACTOR = 2.0;
+    // Window factor for slow replies; throttling, timeouts and errors halve it
+    const double SLOW_DECREASE = 0.8;
+    const double FAILURE_DECREASE = 0.5;
+    // Longest Retry-After honoured; anything beyond is treated as this
+    const qint64 MAX_RETRY_AFTER_MS = 5 * 60 * 1000;
+}
+
+RequestScheduler::RequestScheduler(const Settings& settings)
+    : config(settings), windowSize(settings.initialWindow), rng(std::random_device{}())
+{
+    clock.start();
+    setSettings(settings);
+}
+
+void RequestScheduler::setSettings(const Settings& settings)
+{
+    config = settings;
+    config.maxWindow = std::max(1, config.maxWindow);
+    windowSize = std::clamp(windowSize, 1.0, static_cast<double>(config.maxWindow));
+    startQueued();
+}
+
+int RequestScheduler::capacity() const
+{
+    return std::max(1, static_cast<int>(std::floor(windowSize)));
+}
+
+void RequestScheduler::submit(const QString& key, StartFn start)
+{
+    waiting.push_back(Pending{ key, std::move(start) });
+    startQueued();
+}
+
+void RequestScheduler::startQueued()
+{
+    while (!waiting.empty() && running < capacity()) {
+        Pending next = std::move(waiting.front());
+        waiting.pop_front();
+        Ticket ticket;
+        ticket.id = nextId++;
+        ticket.key = next.key;
+        ticket.startedMs = clock.elapsed();
+        running++;
+        next.start(ticket);
+    }
+}
+
+void RequestScheduler::decrease(const Ticket& ticket, double factor)
+{
+    // One decrease per round: attempts already running when the window shrank saw the old load
+    if (ticket.id < decreasedBefore) return;
+    windowSize = std::max(1.0, windowSize * factor);
+    decreasedBefore = nextId;
+}
+
+void RequestScheduler::finish(const Ticket& ticket, Outcome outcome)
+{
+    running = std::max(0, running - 1);
+    switch (outcome) {
+    case Completed: {
+        const double latency = static_cast<double>(clock.elapsed() - ticket.startedMs);
+        auto baseline = baselineMs.find(ticket.key);
+        if (baseline != baselineMs.end() && latency > SLOW_FACTOR * baseline.value()) {
+            decrease(ticket, SLOW_DECREASE);
+        }
+        else {
+            windowSize = std::min(static_cast<double>(config.maxWindow), windowSize + 1.0 / windowSize);
+        }
+        // Faster attempts lower the baseline at once, slower ones raise it gradually
+        if (baseline == baselineMs.end()) baselineMs.insert(ticket.key, latency);
+        else if (latency < baseline.value()) baseline.value() = latency;
+        else baseline.value() += 0.1 * (latency - baseline.value());
+        break;
+    }
+    case Throttled:
+    case Failed:
+        decrease(ticket, FAILURE_DECREASE);
+        break;
+    case Rejected:
+        break;
+    }
+    startQueued();
+}
+
+bool RequestScheduler::acquireExtra()
+{
+    if (!waiting.empty() || running >= capacity()) return false;
+    running++;
+    return true;
+}
+
+void RequestScheduler::releaseExtra()
+{
+    // Extra copies do not adapt the window; their attempt's ticket does
+    running = std::max(0, running - 1);
+    startQueued();
+}
+
+int RequestScheduler::retryDelayMs(int attempt, qint64 retryAfterMs)
+{
+    const double cap = std::min(static_cast<double>(config.maxRetryDelayMs), config.baseRetryDelayMs * std::pow(2.0, attempt));
+    std::uniform_int_distribution<int> jitter(0, std::max(0, static_cast<int>(cap)));
+    const qint64 delay = std::max<qint64>(jitter(rng), std::min(retryAfterMs, MAX_RETRY_AFTER_MS));
+    return static_cast<int>(delay);
+}
+
+qint64 RequestScheduler::makespanMs(const std::vector<qint64>& costsMs, int width)
+{
+    // Finish times of the slots as a min-heap
+    std::vector<qint64> finish(static_cast<size_t>(std::max(1, width)), 0);
+    for (qint64 cost : costsMs) {
+        std::pop_heap(finish.begin(), finish.end(), std::greater<qint64>());
+        finish.back() += std::max<qint64>(0, cost);
+        std::push_heap(finish.begin(), finish.end(), std::greater<qint64>());
+    }
+    return *std::max_element(finish.begin(), finish.end());
+}
+
+RequestScheduler::Outcome RequestScheduler::classify(const QNetworkReply* reply, bool timedOut)
+{
+    if (timedOut) return Failed;
+    if (reply->error() == QNetworkReply::NoError) return Completed;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 429 || status == 503) return Throttled;
+    if (status >= 500 || status == 408) return Failed;
+    if (status >= 400) return Rejected;
+    return Failed;
+}
+
+qint64 RequestScheduler::retryAfterMs(const QNetworkReply* reply)
+{
+    if (!reply->hasRawHeader("Retry-After")) return -1;
+    const QByteArray value = reply->rawHeader("Retry-After").trimmed();
+    bool isNumber = false;
+    const qint64 seconds = value.toLongLong(&isNumber);
+    if (isNumber) return std::max<qint64>(0, seconds) * 1000;
+    // HTTP date, e.g. "Wed, 21 Oct 2026 07:28:00 GMT"
+    QString date = QString::fromLatin1(value);
+    if (date.endsWith(" GMT")) date.replace(date.size() - 4, 4, " +0000");
+    const QDateTime at = QDateTime::fromString(date, Qt::RFC2822Date);
+    if (!at.isValid()) return -1;
+    return std::max<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(at));
+}
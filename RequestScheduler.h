@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkReply>
+#include <QString>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Decides how many Apps Script requests run at once and when failed ones are tried again.
+// The number of concurrent requests (the window) grows by about one per round of successful requests and is
+// halved on HTTP 429/5xx, timeouts and connection errors (AIMD). A request much slower than its own earlier
+// attempts shrinks it a little, so the window settles below the point where Apps Script starts to queue.
+// Retries wait a random time up to an exponentially growing cap (full jitter), or what Retry-After asks for.
+// Timers stay with the caller; the scheduler only keeps the bookkeeping.
+class RequestScheduler
+{
+public:
+    struct Settings {
+        double initialWindow = 2;
+        int maxWindow = 6;               // never more requests at once than this
+        int attemptTimeoutMs = 120000;   // an attempt running longer is aborted and counts as failed
+        int maxRetries = 3;              // attempts = 1 + maxRetries
+        int baseRetryDelayMs = 1000;     // cap of the first retry delay, doubled per attempt
+        int maxRetryDelayMs = 30000;
+    };
+
+    enum Outcome {
+        Completed,   // reply received
+        Throttled,   // HTTP 429 or 503: the server asks us to slow down
+        Failed,      // other 5xx, timeouts and connection errors: worth another attempt
+        Rejected     // other 4xx: another attempt would fail the same way
+    };
+
+    // One started attempt, handed back to finish()
+    struct Ticket {
+        uint64_t id = 0;
+        QString key;          // what is fetched; latencies are compared per key
+        qint64 startedMs = 0;
+    };
+    using StartFn = std::function<void(const Ticket&)>;
+
+    explicit RequestScheduler(const Settings& settings = Settings());
+
+    const Settings& settings() const { return config; }
+    // Applies new limits; the current window is clamped to the new maximum
+    void setSettings(const Settings& settings);
+
+    // Starts the attempt now if the window has room, otherwise once an earlier one finishes
+    void submit(const QString& key, StartFn start);
+    // Books an attempt's outcome, adapts the window and starts queued attempts.
+    // Every started ticket must be finished exactly once.
+    void finish(const Ticket& ticket, Outcome outcome);
+    // Extra copy of a running attempt (a hedge): takes a slot only if the window has room and nothing is queued,
+    // so hedges never add load beyond the window. A taken slot is given back with releaseExtra().
+    bool acquireExtra();
+    void releaseExtra();
+
+    // Time to wait before retry number attempt (0-based); retryAfterMs (-1 if absent) is a lower bound
+    int retryDelayMs(int attempt, qint64 retryAfterMs);
+
+    double window() const { return windowSize; }
+    int inFlight() const { return running; }
+    int queued() const { return static_cast<int>(waiting.size()); }
+
+    // Makespan of jobs started in this order on `width` parallel slots, each job taking the next free slot
+    static qint64 makespanMs(const std::vector<qint64>& costsMs, int width);
+
+    static Outcome classify(const QNetworkReply* reply, bool timedOut);
+    // Retry-After in ms (delta-seconds or an HTTP date), -1 if the reply has none
+    static qint64 retryAfterMs(const QNetworkReply* reply);
+
+private:
+    int capacity() const;
+    void startQueued();
+    void decrease(const Ticket& ticket, double factor);
+
+    struct Pending {
+        QString key;
+        StartFn start;
+    };
+
+    Settings config;
+    double windowSize;
+    int running = 0;
+    uint64_t nextId = 1;
+    uint64_t decreasedBefore = 0;         // tickets started before the last decrease cannot decrease again
+    std::deque<Pending> waiting;
+    QHash<QString, double> baselineMs;    // key -> typical latency of its successful attempts
+    std::mt19937 rng;
+    QElapsedTimer clock;
+};
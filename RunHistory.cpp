@@ -0,0 +1,150 @@
+#include "RunHistory.h"
+#include "ReportFiles.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Weight of the newest run; about the last five runs matter
+    const double EWMA_ALPHA = 0.3;
+    // Below this fraction the observed rate is mostly start-up noise
+    const double MIN_OBSERVED_FRACTION = 0.03;
+    // Request latencies kept per category, and how many a percentile needs
+    const int REQUEST_SAMPLES = 20;
+    const int MIN_PERCENTILE_SAMPLES = 5;
+
+    QHash<QString, RunHistory::Sample> readSamples(const QJsonObject& obj)
+    {
+        QHash<QString, RunHistory::Sample> samples;
+        for (auto it = obj.begin(); it != obj.end(); ++it) {
+            const QJsonObject s = it.value().toObject();
+            RunHistory::Sample sample;
+            sample.ms = s.value("ms").toDouble();
+            sample.bytes = s.value("bytes").toDouble();
+            sample.runs = s.value("runs").toInt();
+            if (sample.runs > 0 && sample.ms >= 0) samples.insert(it.key(), sample);
+        }
+        return samples;
+    }
+
+    QJsonObject writeSamples(const QHash<QString, RunHistory::Sample>& samples)
+    {
+        QJsonObject obj;
+        for (auto it = samples.constBegin(); it != samples.constEnd(); ++it) {
+            QJsonObject s;
+            s["ms"] = qRound64(it->ms);
+            s["bytes"] = qRound64(it->bytes);
+            s["runs"] = it->runs;
+            obj[it.key()] = s;
+        }
+        return obj;
+    }
+}
+
+RunHistory::RunHistory(const QString& path)
+    : file(path)
+{
+}
+
+void RunHistory::load()
+{
+    if (loaded) return;
+    loaded = true;
+    QFile in(file);
+    if (!in.open(QIODevice::ReadOnly)) return;
+    const QJsonObject root = QJsonDocument::fromJson(in.readAll()).object();
+    fetches = readSamples(root.value("fetch").toObject());
+    cleanups = readSamples(root.value("cleanup").toObject());
+    const QJsonObject requestObj = root.value("requests").toObject();
+    for (auto it = requestObj.begin(); it != requestObj.end(); ++it) {
+        QList<qint64>& latencies = requests[it.key()];
+        for (const QJsonValue& v : it.value().toArray()) latencies << static_cast<qint64>(v.toDouble());
+    }
+}
+
+bool RunHistory::save(QString* error) const
+{
+    if (!ReportFiles::ensureDirectory(QFileInfo(file).absolutePath(), error)) return false;
+    QJsonObject root;
+    root["fetch"] = writeSamples(fetches);
+    root["cleanup"] = writeSamples(cleanups);
+    QJsonObject requestObj;
+    for (auto it = requests.constBegin(); it != requests.constEnd(); ++it) {
+        QJsonArray latencies;
+        for (qint64 ms : it.value()) latencies.append(static_cast<double>(ms));
+        requestObj[it.key()] = latencies;
+    }
+    root["requests"] = requestObj;
+    return ReportFiles::writeFile(file, QJsonDocument(root).toJson(QJsonDocument::Compact), error);
+}
+
+void RunHistory::fold(Sample& sample, qint64 ms, qint64 bytes)
+{
+    if (sample.runs == 0) {
+        sample.ms = static_cast<double>(ms);
+        sample.bytes = static_cast<double>(bytes);
+    }
+    else {
+        sample.ms += EWMA_ALPHA * (static_cast<double>(ms) - sample.ms);
+        sample.bytes += EWMA_ALPHA * (static_cast<double>(bytes) - sample.bytes);
+    }
+    sample.runs++;
+}
+
+void RunHistory::recordFetch(const QString& modId, const QString& category, qint64 ms, qint64 bytes)
+{
+    fold(fetches[modId + "/" + category], ms, bytes);
+}
+
+void RunHistory::recordCleanup(const QString& lang, qint64 ms, qint64 bytes)
+{
+    fold(cleanups[lang], ms, bytes);
+}
+
+void RunHistory::recordRequest(const QString& modId, const QString& category, qint64 ms)
+{
+    QList<qint64>& latencies = requests[modId + "/" + category];
+    latencies << ms;
+    while (latencies.size() > REQUEST_SAMPLES) latencies.removeFirst();
+}
+
+qint64 RunHistory::requestPercentileMs(const QString& modId, const QString& category, double p) const
+{
+    QList<qint64> latencies = requests.value(modId + "/" + category);
+    if (latencies.size() < MIN_PERCENTILE_SAMPLES) return -1;
+    std::sort(latencies.begin(), latencies.end());
+    // Nearest rank
+    const qsizetype rank = static_cast<qsizetype>(std::ceil(std::clamp(p, 0.0, 1.0) * latencies.size()));
+    return latencies[std::clamp<qsizetype>(rank - 1, 0, latencies.size() - 1)];
+}
+
+qint64 RunHistory::typicalRequestMs(const QString& modId, const QString& category) const
+{
+    QList<qint64> latencies = requests.value(modId + "/" + category);
+    if (latencies.isEmpty()) return -1;
+    std::sort(latencies.begin(), latencies.end());
+    return latencies[latencies.size() / 2];
+}
+
+qint64 RunHistory::predictCleanupMs(const QString& lang, qint64 bytes) const
+{
+    const Sample sample = cleanups.value(lang);
+    if (sample.runs == 0) return -1;
+    if (sample.bytes <= 0 || bytes <= 0) return qRound64(sample.ms);
+    return qRound64(sample.ms * static_cast<double>(bytes) / sample.bytes);
+}
+
+qint64 RunHistory::remainingMs(qint64 predictedRemainingMs, qint64 elapsedMs, double fraction)
+{
+    fraction = std::clamp(fraction, 0.0, 1.0);
+    if (fraction >= 1.0) return 0;
+    qint64 observed = -1;
+    if (fraction >= MIN_OBSERVED_FRACTION) observed = qRound64(static_cast<double>(elapsedMs) * (1.0 - fraction) / fraction);
+    if (predictedRemainingMs < 0) return observed;
+    if (observed < 0) return predictedRemainingMs;
+    return qRound64((1.0 - fraction) * static_cast<double>(predictedRemainingMs) + fraction * static_cast<double>(observed));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+// Durations and sizes measured by earlier runs, kept as exponentially weighted averages so a few slow
+// runs (a cold disk, a busy web app) fade out again. Predicts how long the steps of the next run take.
+// Stored as {"fetch":{"<mod>/<category>":{"ms","bytes","runs"}}, "cleanup":{"<lang>":{"ms","bytes","runs"}},
+// "requests":{"<mod>/<category>":[ms, ...]}}; request latencies keep the last few values for percentiles.
+class RunHistory
+{
+public:
+    struct Sample {
+        double ms = 0;       // duration
+        double bytes = 0;    // fetch: export payload size; cleanup: vanilla bytes of the language
+        int runs = 0;        // measurements folded in (0: nothing known)
+    };
+
+    explicit RunHistory(const QString& path = "cache/history.json");
+
+    QString path() const { return file; }
+
+    // Reads the stored history once; a missing or damaged file just means no history
+    void load();
+    // false with error set if the file could not be written
+    bool save(QString* error = nullptr) const;
+
+    // Time from the start of a create run until the category's files were written
+    void recordFetch(const QString& modId, const QString& category, qint64 ms, qint64 bytes);
+    // Time spent cleaning one language's vanilla files
+    void recordCleanup(const QString& lang, qint64 ms, qint64 bytes);
+    // Latency of one successful export request
+    void recordRequest(const QString& modId, const QString& category, qint64 ms);
+
+    Sample fetch(const QString& modId, const QString& category) const { return fetches.value(modId + "/" + category); }
+    Sample cleanup(const QString& lang) const { return cleanups.value(lang); }
+    // The p-quantile (0..1) of a category's recent request latencies; -1 with too few of them
+    qint64 requestPercentileMs(const QString& modId, const QString& category, double p) const;
+    // Median of a category's recent request latencies, whatever their number; -1 if none were recorded
+    qint64 typicalRequestMs(const QString& modId, const QString& category) const;
+    // Cleanup time of a language scaled to the bytes it has now; -1 without history
+    qint64 predictCleanupMs(const QString& lang, qint64 bytes) const;
+
+    // Remaining time of a task: the history prediction (-1 if unknown) blended with the rate observed so
+    // far, which takes over as the completed fraction grows. -1 while neither is available.
+    static qint64 remainingMs(qint64 predictedRemainingMs, qint64 elapsedMs, double fraction);
+
+private:
+    static void fold(Sample& sample, qint64 ms, qint64 bytes);
+
+    QString file;
+    bool loaded = false;
+    QHash<QString, Sample> fetches;   // "<mod>/<category>"
+    QHash<QString, Sample> cleanups;  // language
+    QHash<QString, QList<qint64>> requests; // "<mod>/<category>" -> latest request latencies, oldest first
+};
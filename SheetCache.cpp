@@ -0,0 +1,134 @@
+#include "SheetCache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+    bool writeJsonAtomically(const QString& path, const QJsonDocument& doc)
+    {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) return false;
+        const QByteArray bytes = doc.toJson(QJsonDocument::Compact);
+        if (file.write(bytes) != bytes.size()) {
+            file.cancelWriting();
+            return false;
+        }
+        return file.commit();
+    }
+}
+
+SheetCache::SheetCache(const QString& rootDir)
+    : root(rootDir)
+{
+}
+
+QString SheetCache::spreadsheetDir(const QString& spreadsheetId) const
+{
+    return root + "/" + spreadsheetId;
+}
+
+SheetCache::Manifest SheetCache::loadManifest(const QString& spreadsheetId) const
+{
+    Manifest manifest;
+    QFile file(spreadsheetDir(spreadsheetId) + "/manifest.json");
+    if (!file.open(QIODevice::ReadOnly)) return manifest;
+    const QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    manifest.outputPath = obj.value("outputPath").toString();
+    for (const QJsonValue& v : obj.value("selected").toArray()) manifest.selected << v.toVariant().toLongLong();
+    for (const QJsonValue& v : obj.value("languages").toArray()) manifest.languages << v.toString();
+    const QJsonObject sheets = obj.value("sheets").toObject();
+    for (auto it = sheets.begin(); it != sheets.end(); ++it) {
+        const qint64 id = it.key().toLongLong();
+        manifest.revisions.insert(id, it.value().toObject().value("revision").toString());
+        manifest.names.insert(id, it.value().toObject().value("name").toString());
+    }
+    const QJsonObject outputs = obj.value("outputs").toObject();
+    for (auto it = outputs.begin(); it != outputs.end(); ++it) {
+        manifest.outputs.insert(it.key(), QByteArray::fromHex(it.value().toString().toLatin1()));
+    }
+    return manifest;
+}
+
+bool SheetCache::saveManifest(const QString& spreadsheetId, const Manifest& manifest) const
+{
+    if (!QDir().mkpath(spreadsheetDir(spreadsheetId))) return false;
+    QJsonObject obj;
+    obj["outputPath"] = manifest.outputPath;
+    QJsonArray selected;
+    for (qint64 id : manifest.selected) selected.append(static_cast<double>(id));
+    obj["selected"] = selected;
+    obj["languages"] = QJsonArray::fromStringList(manifest.languages);
+    QJsonObject sheets;
+    for (auto it = manifest.revisions.constBegin(); it != manifest.revisions.constEnd(); ++it) {
+        QJsonObject sheet;
+        sheet["revision"] = it.value();
+        sheet["name"] = manifest.names.value(it.key());
+        sheets[QString::number(it.key())] = sheet;
+    }
+    obj["sheets"] = sheets;
+    QJsonObject outputs;
+    for (auto it = manifest.outputs.constBegin(); it != manifest.outputs.constEnd(); ++it) {
+        outputs[it.key()] = QString::fromLatin1(it.value().toHex());
+    }
+    obj["outputs"] = outputs;
+    return writeJsonAtomically(spreadsheetDir(spreadsheetId) + "/manifest.json", QJsonDocument(obj));
+}
+
+QDateTime SheetCache::manifestTime(const QString& spreadsheetId) const
+{
+    const QFileInfo info(spreadsheetDir(spreadsheetId) + "/manifest.json");
+    return info.exists() ? info.lastModified() : QDateTime();
+}
+
+bool SheetCache::hasSheet(const QString& spreadsheetId, qint64 sheetId) const
+{
+    return QFileInfo::exists(spreadsheetDir(spreadsheetId) + "/" + QString::number(sheetId) + ".json");
+}
+
+bool SheetCache::loadSheet(const QString& spreadsheetId, qint64 sheetId, LanguageEntries& entries) const
+{
+    QFile file(spreadsheetDir(spreadsheetId) + "/" + QString::number(sheetId) + ".json");
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) return false;
+    const QJsonObject obj = doc.object();
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        std::vector<std::string>& lines = entries[it.key().toStdString()];
+        const QJsonArray values = it.value().toArray();
+        lines.reserve(lines.size() + values.size());
+        for (const QJsonValue& v : values) lines.push_back(v.toString().toStdString());
+    }
+    return true;
+}
+
+bool SheetCache::storeSheet(const QString& spreadsheetId, qint64 sheetId, const LanguageEntries& entries) const
+{
+    if (!QDir().mkpath(spreadsheetDir(spreadsheetId))) return false;
+    QJsonObject obj;
+    for (const auto& entry : entries) {
+        QJsonArray values;
+        for (const std::string& line : entry.second) values.append(QString::fromStdString(line));
+        obj[QString::fromStdString(entry.first)] = values;
+    }
+    return writeJsonAtomically(spreadsheetDir(spreadsheetId) + "/" + QString::number(sheetId) + ".json", QJsonDocument(obj));
+}
+
+void SheetCache::invalidate(const QString& spreadsheetId) const
+{
+    QDir(spreadsheetDir(spreadsheetId)).removeRecursively();
+}
+
+QByteArray SheetCache::entriesHash(const std::vector<std::string>& sortedLines)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const std::string& line : sortedLines) {
+        hash.addData(QByteArrayView(line.data(), static_cast<qsizetype>(line.size())));
+        hash.addData("\n");
+    }
+    return hash.result();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-sheet contributions of earlier create runs, so sheets whose revision did not change need not be fetched again.
+// Layout below the root directory:
+//   <spreadsheetId>/manifest.json  {"outputPath", "selected":[ids], "languages":[...], "sheets":{"<id>":{"revision","name"}}, "outputs":{"<lang>":"<sha1>"}}
+//   <spreadsheetId>/<sheetId>.json {"<lang>": ["KEY:0 \"text\"", ...]}
+class SheetCache
+{
+public:
+    using LanguageEntries = std::unordered_map<std::string, std::vector<std::string>>;
+
+    // What is known about one spreadsheet from the previous run
+    struct Manifest {
+        QString outputPath;                   // Output folder the recorded outputs were written to
+        QList<qint64> selected;               // sheet ids that made up the outputs
+        QStringList languages;                // languages the cached sheets were exported with (empty: all)
+        QHash<qint64, QString> revisions;     // sheet id -> revision of the cached contribution
+        QHash<qint64, QString> names;         // sheet id -> sheet name
+        QHash<QString, QByteArray> outputs;   // language -> hash of the written entries
+    };
+
+    explicit SheetCache(const QString& rootDir = "cache/sheets");
+
+    QString rootDir() const { return root; }
+
+    Manifest loadManifest(const QString& spreadsheetId) const;
+    bool saveManifest(const QString& spreadsheetId, const Manifest& manifest) const;
+    // When the manifest was last saved; invalid if there is none
+    QDateTime manifestTime(const QString& spreadsheetId) const;
+
+    bool hasSheet(const QString& spreadsheetId, qint64 sheetId) const;
+    bool loadSheet(const QString& spreadsheetId, qint64 sheetId, LanguageEntries& entries) const;
+    bool storeSheet(const QString& spreadsheetId, qint64 sheetId, const LanguageEntries& entries) const;
+
+    // Forgets everything cached for a spreadsheet (e.g. after a run without per-sheet data)
+    void invalidate(const QString& spreadsheetId) const;
+
+    // Hash of a language's sorted entries, as recorded in Manifest::outputs
+    static QByteArray entriesHash(const std::vector<std::string>& sortedLines);
+
+private:
+    QString spreadsheetDir(const QString& spreadsheetId) const;
+
+    QString root;
+};
@@ -1,36 +1,32 @@
 #include "SheetsSelectionDialog.h"
 #include "ConfigManager.h"
+#include "NetworkTransport.h"
+#include "ModManifest.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QJsonValue>
 #include <QUrlQuery>
 #include <QUrl>
 #include <QListWidgetItem>
+#include <QDateTime>
 #include <QTimer>
 
-static const char* CFG_PREFIX = "Sheets/";
-
-SheetsSelectionDialog::SheetsSelectionDialog(ConfigManager* config, QWidget* parent)
-    : QDialog(parent), configManager(config)
+SheetsSelectionDialog::SheetsSelectionDialog(ConfigManager* config, const ModDefinition& mod, QWidget* parent)
+    : QDialog(parent), configManager(config), configPrefix(mod.configGroup + "/")
 {
-    setWindowTitle("Select Sheets");
+    setWindowTitle("Select Sheets — " + mod.name);
     resize(800, 520);
     setMinimumWidth(720);
-    nam = new QNetworkAccessManager(this);
+    // Shared with the main window, which opened its connections at start-up
+    nam = NetworkTransport::sharedAccessManager();
     buildUi();
 
-    // Define categories (display name -> webAppUrl + spreadsheetId)
+    // Categories come from the mod manifest (display name -> webAppUrl + spreadsheetId)
     categories.clear();
-    auto addCat = [this](const QString& name, const QString& url, const QString& ssid) {
-        CategoryInfo info; info.displayName = name; info.webAppUrl = url; info.spreadsheetId = ssid; 
-        categories.insert(name, info);
-    };
-    addCat("Main Localisation",    "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec", "1jQOrWJpAF_9TQVyrrOfxinyTTxvoDJg_E7BHUNEkoio");
-    addCat("Ships Localisation",   "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec", "19z068O5ARdrXLyswqTeDqcQdhAwA39kI8Gx_nhZPL3I");
-    addCat("Modifiers Localisation","https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec", "1TZylnt8An15CLYlQmy1tjUYvHgMQoosh_x1jC35HOck");
-    addCat("Events Localisation",  "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec", "1YNdrUt0Ro1w6aiVZR0uSJnnulpzhh4thvy3K1-fJ_qA");
-    addCat("Tech Localisation",    "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec", "15QcA1M4dX455UYD2GEv3tDJ3P4z3jhK7p5qPMTDFS60");
-    addCat("Synced Localisation",  "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec", "1MgcmiOr8OMqD6qo5EMwk3ymVenSqAS8MWdo33hKjIPk");
+    for (const ModCategory& category : mod.categories) {
+        CategoryInfo info; info.displayName = category.name; info.webAppUrl = category.webAppUrl; info.spreadsheetId = category.spreadsheetId;
+        categories.insert(category.name, info);
+    }
 
     // Create tabs and controls per category
     for (auto it = categories.begin(); it != categories.end(); ++it) {
@@ -141,8 +137,17 @@ void SheetsSelectionDialog::onFetchFinished()
                     QListWidgetItem* item = new QListWidgetItem(name, it->listWidget);
                     item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
                     item->setData(Qt::UserRole + 1, id);
+                    // Revision metadata (reported by newer script versions) tells which sheets changed since the last run
+                    const QString revision = sh.value("revision").toString();
+                    const QString lastModified = sh.value("lastModified").toString();
+                    item->setData(Qt::UserRole + 2, revision);
+                    item->setData(Qt::UserRole + 3, lastModified);
+                    if (!lastModified.isEmpty()) {
+                        const QDateTime modified = QDateTime::fromString(lastModified, Qt::ISODate);
+                        item->setToolTip("Last modified: " + (modified.isValid() ? modified.toLocalTime().toString("yyyy-MM-dd HH:mm") : lastModified));
+                    }
                     // Pre-check from saved config
-                    QString key = QString("%1%2/SelectedIds").arg(CFG_PREFIX).arg(it.key());
+                    QString key = QString("%1%2/SelectedIds").arg(configPrefix).arg(it.key());
                     QVariant saved = configManager ? configManager->loadSetting(key) : QVariant();
                     const QStringList savedIds = saved.toStringList();
                     item->setCheckState(savedIds.contains(QString::number(id)) ? Qt::Checked : Qt::Unchecked);
@@ -177,7 +182,7 @@ void SheetsSelectionDialog::resetToSavedSelections()
     // Restore check states for each category from saved configuration
     for (auto it = categories.begin(); it != categories.end(); ++it) {
         if (!it->listWidget) continue;
-        const QString key = QString("%1%2/SelectedIds").arg(CFG_PREFIX).arg(it.key());
+        const QString key = QString("%1%2/SelectedIds").arg(configPrefix).arg(it.key());
         const QStringList savedIds = configManager ? configManager->loadSetting(key).toStringList() : QStringList();
         for (int i = 0; i < it->listWidget->count(); ++i) {
             QListWidgetItem* item = it->listWidget->item(i);
@@ -240,6 +245,8 @@ void SheetsSelectionDialog::onFilterTextChanged(const QString& text)
 QString SheetsSelectionDialog::selectionsJson() const
 {
     QJsonObject obj;
+    // Persist every category's ids in one config write
+    ConfigTransaction transaction(configManager);
     for (auto it = categories.begin(); it != categories.end(); ++it) {
         if (!it->listWidget) continue;
         QJsonArray ids;
@@ -256,7 +263,7 @@ QString SheetsSelectionDialog::selectionsJson() const
         obj.insert(it.key(), ids);
         // Persist
         if (configManager) {
-            const QString key = QString("%1%2/SelectedIds").arg(CFG_PREFIX).arg(it.key());
+            const QString key = QString("%1%2/SelectedIds").arg(configPrefix).arg(it.key());
             configManager->saveSetting(key, saveIds);
         }
     }
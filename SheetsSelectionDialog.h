@@ -16,12 +16,14 @@
 #include <QJsonArray>
 
 class ConfigManager;
+struct ModDefinition;
 
 class SheetsSelectionDialog : public QDialog
 {
     Q_OBJECT
 public:
-    explicit SheetsSelectionDialog(ConfigManager* config, QWidget* parent = nullptr);
+    // Lists the sheets of every category of the given mod
+    SheetsSelectionDialog(ConfigManager* config, const ModDefinition& mod, QWidget* parent = nullptr);
 
     // Returns a JSON string mapping category -> array of sheet ids
     QString selectionsJson() const;
@@ -60,4 +62,5 @@ private:
     QList<QNetworkReply*> pendingReplies;
 
     ConfigManager* configManager{nullptr};
+    QString configPrefix; // config group of the mod's selections, with a trailing '/'
 };
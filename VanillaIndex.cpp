@@ -0,0 +1,309 @@
+#include "VanillaIndex.h"
+#include "LocalisationKernels.h"
+#include "CancellationToken.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <cstring>
+
+VanillaIndex::Filter::Filter()
+    : Filter(defaultInclude(), defaultExclude())
+{
+}
+
+VanillaIndex::Filter::Filter(const QStringList& include, const QStringList& exclude)
+    : includePatterns(include), excludePatterns(exclude), includeRegexes(compile(include)), excludeRegexes(compile(exclude))
+{
+}
+
+std::vector<VanillaIndex::Filter::Pattern> VanillaIndex::Filter::compile(const QStringList& patterns)
+{
+    std::vector<Pattern> result;
+    for (const QString& raw : patterns) {
+        const QString pattern = raw.trimmed();
+        if (pattern.isEmpty()) continue;
+        Pattern compiled;
+        compiled.regex = QRegularExpression::fromWildcard(pattern, Qt::CaseInsensitive);
+        compiled.wholePath = pattern.contains('/');
+        result.push_back(compiled);
+    }
+    return result;
+}
+
+// anyFolder: name patterns are tried on every part of the path, not only the last one
+bool VanillaIndex::Filter::matches(const std::vector<Pattern>& patterns, const QString& relativePath, bool anyFolder)
+{
+    const QStringList parts = relativePath.split('/', Qt::SkipEmptyParts);
+    for (const Pattern& pattern : patterns) {
+        if (pattern.wholePath) {
+            if (pattern.regex.match(relativePath).hasMatch()) return true;
+            continue;
+        }
+        for (qsizetype i = anyFolder ? 0 : parts.size() - 1; i < parts.size(); ++i) {
+            if (pattern.regex.match(parts[i]).hasMatch()) return true;
+        }
+    }
+    return false;
+}
+
+bool VanillaIndex::Filter::accepts(const QString& relativePath) const
+{
+    if (matches(excludeRegexes, relativePath, true)) return false;
+    return includeRegexes.empty() || matches(includeRegexes, relativePath, false);
+}
+
+bool VanillaIndex::Filter::skipsFolder(const QString& relativePath) const
+{
+    return matches(excludeRegexes, relativePath, false);
+}
+
+VanillaIndex::VanillaIndex(const QString& vanillaPath)
+    : root(vanillaPath)
+{
+}
+
+VanillaIndex::~VanillaIndex()
+{
+    // Pool tasks only touch their Scan, but wait so none outlives the cancel token they poll
+    pool.waitForDone();
+}
+
+void VanillaIndex::scan(const QStringList& langs, const CancellationToken* cancel)
+{
+    for (const QString& lang : langs) {
+        // A scan nobody collected yet may be out of date; take its files as the base for a new one
+        if (scans.contains(lang)) language(lang);
+        auto job = std::make_shared<Scan>();
+        job->previous = languages.take(lang);
+        scans.insert(lang, job);
+        const QString langDir = root + "/" + lang;
+        const Filter filter = fileFilter;
+        // Walks go ahead of the chunks already queued, so every language's listing is known early
+        pool.start([job, langDir, filter, cancel, this]() { walk(langDir, filter, cancel, job, pool); }, 1);
+    }
+}
+
+std::shared_ptr<VanillaIndex::Scan> VanillaIndex::scanOf(const QString& lang, const CancellationToken* cancel)
+{
+    if (!scans.contains(lang)) scan({ lang }, cancel);
+    return scans.value(lang);
+}
+
+bool VanillaIndex::listing(const QString& lang, Listing& result, const CancellationToken* cancel)
+{
+    std::shared_ptr<Scan> job = scanOf(lang, cancel);
+    QMutexLocker locker(&job->mutex);
+    while (!job->listed) job->changed.wait(&job->mutex);
+    result = job->listing;
+    return job->exists && !(cancel && cancel->isCancelled());
+}
+
+const VanillaIndex::File* VanillaIndex::file(const QString& lang, qsizetype i, const CancellationToken* cancel)
+{
+    std::shared_ptr<Scan> job = scanOf(lang, cancel);
+    QMutexLocker locker(&job->mutex);
+    while (!job->listed || (static_cast<size_t>(i) < job->states.size() && job->states[i] == Pending)) {
+        job->changed.wait(&job->mutex);
+    }
+    if (static_cast<size_t>(i) >= job->states.size() || job->states[i] != Ready) return nullptr;
+    return &job->files[i];
+}
+
+const std::vector<VanillaIndex::File>* VanillaIndex::language(const QString& lang, const CancellationToken* cancel)
+{
+    std::shared_ptr<Scan> job = scanOf(lang, cancel);
+    scans.remove(lang);
+    {
+        QMutexLocker locker(&job->mutex);
+        while (!job->done) job->changed.wait(&job->mutex);
+    }
+    parsedCount += job->parsed;
+    reusedCount += job->reused;
+    if (!job->exists) return nullptr;
+
+    std::vector<File>& cached = languages[lang];
+    if (!job->cancelled) {
+        cached = std::move(job->files);
+        return &cached;
+    }
+    // A cancelled scan keeps what it read and the untouched entries; the next call picks up the rest
+    cached.clear();
+    QSet<QString> read;
+    for (size_t i = 0; i < job->files.size(); ++i) {
+        if (job->states[i] != Ready) continue;
+        read.insert(job->files[i].fileName);
+        cached.push_back(std::move(job->files[i]));
+    }
+    for (File& old : job->stale) {
+        if (!read.contains(old.fileName)) cached.push_back(std::move(old));
+    }
+    return nullptr;
+}
+
+QStringList VanillaIndex::listFiles(const QString& dir, const Filter& filter, const CancellationToken* cancel)
+{
+    QStringList result;
+    if (!QDir(dir).exists()) return result;
+    std::vector<QString> folders { QString() };
+    while (!folders.empty()) {
+        if (cancel && cancel->isCancelled()) break;
+        const QString folder = folders.back();
+        folders.pop_back();
+        QDirIterator it(folder.isEmpty() ? dir : dir + "/" + folder, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            const QString relativePath = folder.isEmpty() ? info.fileName() : folder + "/" + info.fileName();
+            if (info.isDir()) {
+                // Links could lead back up the tree
+                if (!info.isSymLink() && !filter.skipsFolder(relativePath)) folders.push_back(relativePath);
+            }
+            else if (filter.accepts(relativePath)) {
+                result << relativePath;
+            }
+        }
+    }
+    result.sort();
+    return result;
+}
+
+void VanillaIndex::walk(const QString& langDir, const Filter& filter, const CancellationToken* cancel,
+    const std::shared_ptr<Scan>& scan, QThreadPool& pool)
+{
+    // Files are parsed in chunks of about this many bytes, so a few large files do not hold up the rest
+    const qint64 chunkBytes = 1 << 20;
+    std::vector<std::vector<size_t>> chunks;
+    if (!QDir(langDir).exists()) {
+        scan->exists = false;
+    }
+    else {
+        // Reuse parsed files whose size and time still match; everything else is read again
+        QHash<QString, size_t> previousByName;
+        for (size_t i = 0; i < scan->previous.size(); ++i) previousByName.insert(scan->previous[i].fileName, i);
+        std::vector<bool> taken(scan->previous.size(), false);
+
+        const QStringList paths = listFiles(langDir, filter, cancel);
+        scan->files.resize(static_cast<size_t>(paths.size()));
+        scan->states.assign(scan->files.size(), Pending);
+        qint64 pendingBytes = 0;
+        for (qsizetype i = 0; i < paths.size(); ++i) {
+            const QString& relativePath = paths[i];
+            const QFileInfo info(langDir + "/" + relativePath);
+            scan->listing.files++;
+            scan->listing.bytes += info.size();
+            auto it = previousByName.constFind(relativePath);
+            if (it != previousByName.constEnd()) {
+                File& old = scan->previous[it.value()];
+                if (old.size == info.size() && old.modifiedMs == info.lastModified().toMSecsSinceEpoch()) {
+                    scan->files[i] = std::move(old);
+                    scan->states[i] = Ready;
+                    taken[it.value()] = true;
+                    scan->reused++;
+                    continue;
+                }
+            }
+            scan->files[i].fileName = relativePath;
+            if (chunks.empty() || pendingBytes >= chunkBytes) {
+                chunks.emplace_back();
+                pendingBytes = 0;
+            }
+            chunks.back().push_back(static_cast<size_t>(i));
+            pendingBytes += info.size();
+        }
+        for (size_t i = 0; i < scan->previous.size(); ++i) {
+            if (!taken[i]) scan->stale.push_back(std::move(scan->previous[i]));
+        }
+        scan->previous.clear();
+        if (cancel && cancel->isCancelled()) {
+            scan->cancelled = true;
+            for (FileState& state : scan->states) {
+                if (state == Pending) state = Skipped;
+            }
+            chunks.clear();
+        }
+    }
+
+    {
+        QMutexLocker locker(&scan->mutex);
+        scan->listed = true;
+        scan->pendingChunks = static_cast<int>(chunks.size());
+        scan->done = chunks.empty();
+        scan->changed.wakeAll();
+    }
+    for (std::vector<size_t>& chunk : chunks) {
+        pool.start([scan, langDir, cancel, indices = std::move(chunk)]() mutable { parseChunk(langDir, std::move(indices), cancel, *scan); });
+    }
+}
+
+void VanillaIndex::parseChunk(const QString& langDir, std::vector<size_t> indices, const CancellationToken* cancel, Scan& scan)
+{
+    for (size_t i : indices) {
+        const bool cancelled = cancel && cancel->isCancelled();
+        bool parsed = false;
+        if (!cancelled) {
+            File& file = scan.files[i];
+            const QString relativePath = file.fileName;
+            // Unreadable files stay listed so the caller reports them
+            parsed = parseFile(langDir + "/" + relativePath, file);
+            file.fileName = relativePath;
+        }
+        QMutexLocker locker(&scan.mutex);
+        scan.states[i] = cancelled ? Skipped : Ready;
+        if (cancelled) scan.cancelled = true;
+        if (parsed) scan.parsed++;
+        scan.changed.wakeAll();
+    }
+    QMutexLocker locker(&scan.mutex);
+    if (--scan.pendingChunks == 0) scan.done = true;
+    scan.changed.wakeAll();
+}
+
+bool VanillaIndex::parseFile(const QString& path, File& file)
+{
+    QFileInfo info(path);
+    file.fileName = info.fileName();
+    file.size = info.size();
+    file.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+    file.lines.clear();
+    file.keys.clear();
+
+    QFile in(path);
+    if (!in.open(QIODevice::ReadOnly)) {
+        file.size = -1;
+        file.data.clear();
+        file.bodyOffset = 0;
+        return false;
+    }
+    parseData(in.readAll(), file);
+    return true;
+}
+
+void VanillaIndex::parseData(const QByteArray& data, File& file)
+{
+    file.lines.clear();
+    file.keys.clear();
+    file.data = data;
+    // The BOM is skipped in place rather than removed, which would move the whole file
+    file.bodyOffset = file.data.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+
+    // Same line splitting as QTextStream::readLine: "\n" or "\r\n", no empty line after a final break
+    const char* bytes = file.data.constData();
+    const qsizetype size = file.data.size();
+    qsizetype start = file.bodyOffset;
+    while (start < size) {
+        const char* nl = static_cast<const char*>(memchr(bytes + start, '\n', static_cast<size_t>(size - start)));
+        const qsizetype end = nl ? nl - bytes : size;
+        qsizetype length = end - start;
+        if (length > 0 && bytes[start + length - 1] == '\r') length--;
+        file.lines.emplace_back(start, length);
+        start = end + 1;
+    }
+
+    file.keys.resize(file.lines.size());
+    std::string_view key;
+    for (size_t i = 0; i < file.lines.size(); ++i) {
+        if (LocalisationKernels::keyOfLine(file.view(i), key)) file.keys[i].assign(key.data(), key.size());
+    }
+}
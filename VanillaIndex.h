@@ -0,0 +1,142 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CancellationToken;
+
+// Parsed vanilla localisation, kept between tasks so several mods built in one session scan it once.
+// Each file is read once as raw UTF-8 and split into lines with their keys; a file is parsed again only when its
+// size or modification time changed.
+// Language folders are walked recursively; scan() walks several languages at once on a thread pool and parses
+// their files there in chunks, so the cleanup can clean the files read so far while the rest are still being read.
+class VanillaIndex
+{
+public:
+    // Which files of a language folder are cleaned. Patterns without a '/' are matched against the file name and
+    // every folder name on the way (a matching folder is skipped whole); patterns with a '/' against the path
+    // relative to the language folder. Matching ignores case.
+    class Filter
+    {
+    public:
+        Filter();
+        Filter(const QStringList& include, const QStringList& exclude);
+
+        bool accepts(const QString& relativePath) const;
+        bool skipsFolder(const QString& relativePath) const;
+        QStringList include() const { return includePatterns; }
+        QStringList exclude() const { return excludePatterns; }
+
+        static QStringList defaultInclude() { return { "*.yml" }; }
+        // Name list files are copied, not cleaned
+        static QStringList defaultExclude() { return { "name_lists_*", "random_names_*", "name_lists", "random_names" }; }
+
+    private:
+        struct Pattern {
+            QRegularExpression regex;
+            bool wholePath = false;
+        };
+        static std::vector<Pattern> compile(const QStringList& patterns);
+        static bool matches(const std::vector<Pattern>& patterns, const QString& relativePath, bool folder);
+
+        QStringList includePatterns;
+        QStringList excludePatterns;
+        std::vector<Pattern> includeRegexes;
+        std::vector<Pattern> excludeRegexes;
+    };
+
+    struct File {
+        QString fileName;                                     // path relative to the language folder, '/' separated
+        qint64 size = -1;
+        qint64 modifiedMs = 0;
+        QByteArray data;                                      // raw file contents; lines start after a UTF-8 BOM
+        qsizetype bodyOffset = 0;                             // 3 when the file has a BOM
+        std::vector<std::pair<qsizetype, qsizetype>> lines;   // offset and length of every line (no line break)
+        std::vector<std::string> keys;                        // key of every line, empty for non-entry lines
+
+        std::string_view view(size_t i) const { return std::string_view(data.constData() + lines[i].first, static_cast<size_t>(lines[i].second)); }
+        std::string line(size_t i) const { return std::string(view(i)); }
+    };
+
+    // What the walk of a language folder found
+    struct Listing {
+        qsizetype files = 0;
+        qint64 bytes = 0;
+    };
+
+    explicit VanillaIndex(const QString& vanillaPath);
+    ~VanillaIndex();
+
+    QString vanillaPath() const { return root; }
+    // Applies to scans started afterwards
+    void setFilter(const Filter& filter) { fileFilter = filter; }
+    const Filter& filter() const { return fileFilter; }
+
+    // Starts walking and parsing the given languages on the pool; listing(), file() and language() then wait for the result
+    void scan(const QStringList& langs, const CancellationToken* cancel = nullptr);
+
+    // Waits until <vanilla>/<lang> has been walked (scanning it now unless scan() started it); false if the folder
+    // does not exist or cancel is set
+    bool listing(const QString& lang, Listing& result, const CancellationToken* cancel = nullptr);
+    // Waits until file i (by relative path) of a language being scanned is read; nullptr if cancel is set first.
+    // Valid until language() collects the scan.
+    const File* file(const QString& lang, qsizetype i, const CancellationToken* cancel = nullptr);
+
+    // The files of <vanilla>/<lang> the filter accepts, sorted by relative path; scanned now unless scan() started it.
+    // Returns nullptr if the language folder does not exist, or when cancel is set part way through the scan.
+    const std::vector<File>* language(const QString& lang, const CancellationToken* cancel = nullptr);
+
+    // Relative paths of the files under dir the filter accepts, sorted; stops early when cancel is set
+    static QStringList listFiles(const QString& dir, const Filter& filter, const CancellationToken* cancel = nullptr);
+    // Reads and splits one file; false if it cannot be opened
+    static bool parseFile(const QString& path, File& file);
+    // Splits contents already in memory (name, size and time are left as they are)
+    static void parseData(const QByteArray& data, File& file);
+
+    qint64 filesParsed() const { return parsedCount; }
+    qint64 filesReused() const { return reusedCount; }
+
+private:
+    enum FileState : quint8 { Pending, Ready, Skipped };
+
+    // One language being scanned on the pool: walked by one task, then parsed by one task per chunk of files
+    struct Scan {
+        QMutex mutex;
+        QWaitCondition changed;       // walked, a file read, or done
+        bool listed = false;
+        bool done = false;            // listed and every chunk finished
+        bool exists = true;
+        bool cancelled = false;
+        int pendingChunks = 0;
+        Listing listing;
+        std::vector<File> previous;   // parsed files of the last scan, reused when unchanged
+        std::vector<File> stale;      // previous files not reused, kept if the scan is cancelled
+        std::vector<File> files;      // sized by the walk; chunk tasks fill their own entries
+        std::vector<FileState> states;
+        qint64 parsed = 0;
+        qint64 reused = 0;
+    };
+    static void walk(const QString& langDir, const Filter& filter, const CancellationToken* cancel,
+        const std::shared_ptr<Scan>& scan, QThreadPool& pool);
+    static void parseChunk(const QString& langDir, std::vector<size_t> indices, const CancellationToken* cancel, Scan& scan);
+    // The scan of lang, started now if scan() did not
+    std::shared_ptr<Scan> scanOf(const QString& lang, const CancellationToken* cancel);
+
+    QString root;
+    Filter fileFilter;
+    QHash<QString, std::vector<File>> languages;
+    QHash<QString, std::shared_ptr<Scan>> scans;   // started by scan(), collected by language()
+    QThreadPool pool;
+    qint64 parsedCount = 0;
+    qint64 reusedCount = 0;
+};
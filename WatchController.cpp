@@ -0,0 +1,173 @@
+#include "WatchController.h"
+#include "worker.h"
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+
+WatchController::WatchController(Worker* worker, QObject* parent)
+    : QObject(parent), worker(worker)
+{
+    debounceTimer.setSingleShot(true);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &WatchController::handleDirectoryChanged);
+    connect(&debounceTimer, &QTimer::timeout, this, &WatchController::handleDebounceTimeout);
+    connect(&pollTimer, &QTimer::timeout, this, &WatchController::requestSheetsRefresh);
+    connect(worker, &Worker::incrementalFinished, this, &WatchController::handleIncrementalFinished);
+}
+
+void WatchController::start(const WatchOptions& watchOptions)
+{
+    stop();
+    options = watchOptions;
+    active = true;
+    watchTree(false);
+    emit logMessage(QString("INFO: Watch mode started — %1 directories watched, sheets polled every %2 s")
+        .arg(watcher.directories().size()).arg(options.pollIntervalSec));
+
+    // The worker forgets earlier cycles so the first one rebuilds everything
+    QMetaObject::invokeMethod(worker, "resetWatchState", Qt::QueuedConnection);
+    fullRebuildDue = true;
+    sheetsDue = true;
+    pendingFiles.clear();
+    if (options.pollIntervalSec > 0) pollTimer.start(options.pollIntervalSec * 1000);
+    runCycleIfPending();
+}
+
+void WatchController::stop()
+{
+    if (!active) return;
+    active = false;
+    pollTimer.stop();
+    debounceTimer.stop();
+    if (!watcher.directories().isEmpty()) watcher.removePaths(watcher.directories());
+    snapshots.clear();
+    pendingDirs.clear();
+    pendingFiles.clear();
+    // The running cycle stops at its next cancellation point; its incrementalFinished still ends it
+    if (cycleRunning) {
+        emit logMessage("INFO: Cancelling the running watch cycle...");
+        worker->requestCancel();
+    }
+    emit logMessage("INFO: Watch mode stopped");
+}
+
+void WatchController::requestSheetsRefresh()
+{
+    if (!active) return;
+    sheetsDue = true;
+    runCycleIfPending();
+}
+
+// Watches <vanilla>, <vanilla>/<lang> with every folder below it and static_localisation/<lang>
+void WatchController::watchTree(bool reportNewFiles)
+{
+    QList<QString> roots = { options.vanillaPath, options.staticPath };
+    for (const QString& root : roots) {
+        QDir rootDir(root);
+        if (!rootDir.exists()) continue;
+        addDirectory(rootDir.absolutePath(), reportNewFiles);
+        for (const QString& langFolder : rootDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            const QString langDir = rootDir.absoluteFilePath(langFolder);
+            addDirectory(langDir, reportNewFiles);
+            if (root != options.vanillaPath) continue;
+            // Name lists and nested localisation; the worker's filter decides which files matter
+            QDirIterator it(langDir, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDirIterator::Subdirectories);
+            while (it.hasNext()) addDirectory(it.next(), reportNewFiles);
+        }
+    }
+}
+
+void WatchController::addDirectory(const QString& dir, bool reportFiles)
+{
+    if (snapshots.contains(dir)) return;
+    QHash<QString, FileStamp> snapshot = snapshotDirectory(dir);
+    // Files in a directory that appeared while watching are new to the worker as well
+    if (reportFiles) {
+        for (auto it = snapshot.constBegin(); it != snapshot.constEnd(); ++it) pendingFiles.insert(it.key());
+    }
+    snapshots.insert(dir, snapshot);
+    watcher.addPath(dir);
+}
+
+QHash<QString, WatchController::FileStamp> WatchController::snapshotDirectory(const QString& dir) const
+{
+    QHash<QString, FileStamp> snapshot;
+    const QFileInfoList entries = QDir(dir).entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    for (const QFileInfo& info : entries) {
+        FileStamp stamp;
+        stamp.size = info.size();
+        stamp.modifiedMs = info.lastModified().toMSecsSinceEpoch();
+        snapshot.insert(info.absoluteFilePath(), stamp);
+    }
+    return snapshot;
+}
+
+void WatchController::handleDirectoryChanged(const QString& path)
+{
+    if (!active) return;
+    // Editors and game patches touch many files at once; collect them into one cycle
+    pendingDirs.insert(path);
+    debounceTimer.start(options.debounceMs);
+}
+
+void WatchController::handleDebounceTimeout()
+{
+    if (!active) return;
+    for (const QString& dir : pendingDirs) {
+        const QHash<QString, FileStamp> before = snapshots.value(dir);
+        const QHash<QString, FileStamp> after = snapshotDirectory(dir);
+        for (auto it = after.constBegin(); it != after.constEnd(); ++it) {
+            auto old = before.constFind(it.key());
+            if (old == before.constEnd() || !(old.value() == it.value())) pendingFiles.insert(it.key());
+        }
+        for (auto it = before.constBegin(); it != before.constEnd(); ++it) {
+            if (!after.contains(it.key())) pendingFiles.insert(it.key());
+        }
+        if (QFileInfo::exists(dir)) {
+            snapshots.insert(dir, after);
+        }
+        else {
+            snapshots.remove(dir);
+        }
+    }
+    pendingDirs.clear();
+    // Pick up language or name list folders created meanwhile
+    watchTree(true);
+    runCycleIfPending();
+}
+
+void WatchController::runCycleIfPending()
+{
+    if (!active || cycleRunning) return;
+    if (!fullRebuildDue && !sheetsDue && pendingFiles.isEmpty()) return;
+
+    QStringList reasons;
+    if (fullRebuildDue) reasons << "initial full rebuild";
+    else {
+        if (sheetsDue) reasons << "sheets poll";
+        if (!pendingFiles.isEmpty()) reasons << QString("%1 changed files").arg(pendingFiles.size());
+    }
+    const QStringList changedFiles = pendingFiles.values();
+    const bool refreshSheets = sheetsDue;
+    pendingFiles.clear();
+    sheetsDue = false;
+    fullRebuildDue = false;
+    cycleRunning = true;
+
+    emit cycleStarted(reasons.join(", "));
+    QMetaObject::invokeMethod(worker, "doIncrementalTask", Qt::QueuedConnection,
+        Q_ARG(int, options.modType),
+        Q_ARG(QString, options.outputPath),
+        Q_ARG(QString, options.vanillaPath),
+        Q_ARG(QStringList, changedFiles),
+        Q_ARG(bool, refreshSheets));
+}
+
+void WatchController::handleIncrementalFinished(bool success, const QString& summary)
+{
+    if (!cycleRunning) return;
+    cycleRunning = false;
+    emit cycleFinished(success, summary);
+    // Changes that arrived during the cycle go into the next one
+    runCycleIfPending();
+}
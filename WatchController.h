@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class Worker;
+
+// Settings for a watch session
+struct WatchOptions {
+    int modType = 1;            // mod from the mod manifest
+    QString outputPath;
+    QString vanillaPath;
+    QString staticPath = "static_localisation";
+    int pollIntervalSec = 60;   // how often the selected sheets are re-fetched; 0 disables polling
+    int debounceMs = 750;       // file changes are collected this long before a cycle starts
+};
+
+// Drives Worker::doIncrementalTask: watches the vanilla and static_localisation trees,
+// polls the sheets on a timer and runs one cycle at a time with everything that changed meanwhile.
+class WatchController : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WatchController(Worker* worker, QObject* parent = nullptr);
+
+    // Starts watching; the first cycle is a full rebuild that primes the worker's in-memory state
+    void start(const WatchOptions& options);
+    // Stops watching and cancels a cycle that is still running
+    void stop();
+    bool isActive() const { return active; }
+    bool isCycleRunning() const { return cycleRunning; }
+
+public slots:
+    // Re-fetches the sheets in the next cycle (e.g. after the selections changed)
+    void requestSheetsRefresh();
+
+signals:
+    void cycleStarted(const QString& reason);
+    void cycleFinished(bool success, const QString& summary);
+    void logMessage(const QString& message);
+
+private slots:
+    void handleDirectoryChanged(const QString& path);
+    void handleDebounceTimeout();
+    void handleIncrementalFinished(bool success, const QString& summary);
+
+private:
+    // Size and modification time of a file, enough to tell whether it changed
+    struct FileStamp {
+        qint64 size = -1;
+        qint64 modifiedMs = 0;
+        bool operator==(const FileStamp& other) const { return size == other.size && modifiedMs == other.modifiedMs; }
+    };
+
+    void watchTree(bool reportNewFiles);
+    void addDirectory(const QString& dir, bool reportFiles);
+    QHash<QString, FileStamp> snapshotDirectory(const QString& dir) const;
+    void runCycleIfPending();
+
+    Worker* worker;
+    QFileSystemWatcher watcher;
+    QTimer pollTimer;
+    QTimer debounceTimer;
+    WatchOptions options;
+    bool active = false;
+    bool cycleRunning = false;
+    bool sheetsDue = false;
+    bool fullRebuildDue = false;
+    QSet<QString> pendingDirs;
+    QSet<QString> pendingFiles;
+    QHash<QString, QHash<QString, FileStamp>> snapshots; // watched directory -> file -> stamp
+};
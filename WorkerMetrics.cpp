@@ -0,0 +1,51 @@
+#include "WorkerMetrics.h"
+
+int WorkerMetrics::percent() const
+{
+    if (workTotal <= 0) return -1;
+    const qint64 done = qBound<qint64>(0, workDone, workTotal);
+    return static_cast<int>((done * 100) / workTotal);
+}
+
+double WorkerMetrics::fraction() const
+{
+    if (workTotal <= 0) return 0.0;
+    return static_cast<double>(qBound<qint64>(0, workDone, workTotal)) / static_cast<double>(workTotal);
+}
+
+QString WorkerMetrics::formatDuration(qint64 ms)
+{
+    const qint64 seconds = (qMax<qint64>(0, ms) + 999) / 1000;
+    if (seconds < 60) return QString("%1s").arg(seconds);
+    if (seconds < 3600) return QString("%1m %2s").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+    return QString("%1h %2m").arg(seconds / 3600).arg((seconds / 60) % 60, 2, 10, QChar('0'));
+}
+
+void MetricsTracker::start()
+{
+    current = WorkerMetrics();
+    previous = WorkerMetrics();
+    previousMs = 0;
+    clock.start();
+}
+
+bool MetricsTracker::snapshot(WorkerMetrics& out, bool force)
+{
+    if (!clock.isValid()) clock.start();
+    const qint64 now = clock.elapsed();
+    const qint64 elapsed = now - previousMs;
+    if (!force && elapsed < interval) return false;
+
+    // A forced snapshot inside the interval keeps the last rates rather than measuring a tiny window
+    if (elapsed >= interval && elapsed > 0) {
+        const double seconds = static_cast<double>(elapsed) / 1000.0;
+        current.downloadBytesPerSec = static_cast<double>(current.bytesDownloaded - previous.bytesDownloaded) / seconds;
+        current.rowsPerSec = static_cast<double>(current.rowsParsed - previous.rowsParsed) / seconds;
+        current.vanillaBytesPerSec = static_cast<double>(current.vanillaBytes - previous.vanillaBytes) / seconds;
+        previous = current;
+        previousMs = now;
+    }
+    current.elapsedMs = now;
+    out = current;
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QString>
+
+// Live counters of a running task. Worker sends a snapshot a few times per second; progress is
+// workDone / workTotal in task-specific units (create: per-category download and write shares,
+// cleanup: bytes of the files still to read and copy).
+struct WorkerMetrics {
+    qint64 bytesDownloaded = 0;
+    qint64 rowsParsed = 0;
+    qint64 vanillaBytes = 0;     // vanilla bytes cleaned
+    qint64 filesWritten = 0;
+    double downloadBytesPerSec = 0;
+    double rowsPerSec = 0;
+    double vanillaBytesPerSec = 0;
+    int requestsInFlight = 0;
+    int requestsWaiting = 0;     // retries waiting for their backoff delay
+    int itemsQueued = 0;         // categories or vanilla files not yet processed
+    qint64 workDone = 0;
+    qint64 workTotal = 0;
+    qint64 elapsedMs = 0;
+    qint64 remainingMs = -1;     // predicted time left, -1 while unknown
+
+    // 0..100, or -1 while the total is unknown
+    int percent() const;
+    // workDone / workTotal as 0..1 (0 while the total is unknown)
+    double fraction() const;
+    // "45s", "3m 20s", "1h 05m"
+    static QString formatDuration(qint64 ms);
+};
+Q_DECLARE_METATYPE(WorkerMetrics)
+
+// Accumulates the counters and turns them into snapshots with rates over the last interval.
+// Snapshots are taken from the counting sites themselves, so they also flow during synchronous loops.
+class MetricsTracker
+{
+public:
+    explicit MetricsTracker(int intervalMs = 250) : interval(intervalMs) {}
+
+    // Zeroes every counter and restarts the clock
+    void start();
+    WorkerMetrics& counters() { return current; }
+
+    // True with out filled when the interval has passed since the last snapshot (always when forced)
+    bool snapshot(WorkerMetrics& out, bool force = false);
+
+private:
+    WorkerMetrics current;
+    WorkerMetrics previous;
+    QElapsedTimer clock;
+    qint64 previousMs = 0;
+    int interval;
+};
@@ -0,0 +1,236 @@
+#include "CorpusGenerator.h"
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+    // Key families seen in Stellaris localisation
+    const char* const KEY_PREFIXES[] = {
+        "ship_size_", "tech_", "edict_", "building_", "job_", "NAME_", "opinion_", "mod_", "trait_", "event_", "policy_", "civic_"
+    };
+    const int KEY_PREFIX_COUNT = static_cast<int>(sizeof(KEY_PREFIXES) / sizeof(KEY_PREFIXES[0]));
+
+    // Per-language vocabularies so byte lengths and UTF-8 widths match real files
+    QStringList wordsFor(const QString& language)
+    {
+        if (language == "russian") return { "корабль", "флот", "империя", "технология", "исследование", "планета", "звезда", "союз", "война", "мир", "§Yэнергия§!", "$NAME$" };
+        if (language == "polish") return { "statek", "flota", "imperium", "technologia", "badanie", "planeta", "gwiazda", "sojusz", "wojna", "pokój", "żółć", "§Yenergia§!", "$NAME$" };
+        if (language == "german") return { "Schiff", "Flotte", "Imperium", "Technologie", "Forschung", "Planet", "Stern", "Bündnis", "Krieg", "Frieden", "§YEnergie§!", "$NAME$" };
+        if (language == "french") return { "vaisseau", "flotte", "empire", "technologie", "recherche", "planète", "étoile", "alliance", "guerre", "paix", "§Yénergie§!", "$NAME$" };
+        if (language == "spanish") return { "nave", "flota", "imperio", "tecnología", "investigación", "planeta", "estrella", "alianza", "guerra", "paz", "§Yenergía§!", "$NAME$" };
+        if (language == "braz_por") return { "nave", "frota", "império", "tecnologia", "pesquisa", "planeta", "estrela", "aliança", "guerra", "paz", "§Yenergia§!", "$NAME$" };
+        if (language == "italian") return { "nave", "flotta", "impero", "tecnologia", "ricerca", "pianeta", "stella", "alleanza", "guerra", "pace", "$NAME$" };
+        return { "ship", "fleet", "empire", "technology", "research", "planet", "star", "alliance", "war", "peace", "§Yenergy§!", "$NAME$", "\\n" };
+    }
+}
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+    : opts(options), rng(options.seed)
+{
+    vanillaKeyCount = opts.filesPerLanguage * opts.linesPerFile;
+}
+
+bool CorpusGenerator::chance(double p)
+{
+    return p > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+}
+
+QString CorpusGenerator::keyName(int id) const
+{
+    return QString::fromLatin1(KEY_PREFIXES[id % KEY_PREFIX_COUNT]) + QString::number(id);
+}
+
+QString CorpusGenerator::entryText(const QString& language, int minWords, int maxWords)
+{
+    const QStringList words = wordsFor(language);
+    const int count = std::uniform_int_distribution<int>(minWords, maxWords)(rng);
+    QString text;
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) text += ' ';
+        text += words.at(std::uniform_int_distribution<int>(0, static_cast<int>(words.size()) - 1)(rng));
+    }
+    return text;
+}
+
+QString CorpusGenerator::columnName(const QString& language) const
+{
+    if (language == "braz_por") return "KEY (Braz_Por)";
+    return "KEY (" + language.left(1).toUpper() + language.mid(1) + ")";
+}
+
+bool CorpusGenerator::generateVanillaTree(const QString& root, QString* error)
+{
+    auto writeFile = [this, error](const QString& path, const QByteArray& bytes) {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size()) {
+            if (error) *error = "Could not write " + path;
+            return false;
+        }
+        totalBytes += bytes.size();
+        return true;
+    };
+
+    for (const QString& language : opts.languages) {
+        QDir langDir(root + "/" + language);
+        if (!langDir.mkpath(".")) {
+            if (error) *error = "Could not create " + langDir.path();
+            return false;
+        }
+
+        for (int f = 0; f < opts.filesPerLanguage; ++f) {
+            QByteArray bytes;
+            bytes.reserve(opts.linesPerFile * 64);
+            if (chance(opts.bomRatio)) bytes += "\xEF\xBB\xBF";
+            bytes += "l_" + language.toUtf8() + ":\n";
+            for (int i = 0; i < opts.linesPerFile; ++i) {
+                if (chance(opts.commentRatio)) {
+                    bytes += chance(0.5) ? QByteArray("\n") : " # " + entryText("english", 2, 6).toUtf8() + "\n";
+                }
+                const QByteArray key = keyName(f * opts.linesPerFile + i).toUtf8();
+                if (chance(opts.emptyStringRatio)) bytes += " " + key + ":0 \"\"\n";
+                else bytes += " " + key + ":0 \"" + entryText(language, 2, 14).toUtf8() + "\"\n";
+            }
+            const QString name = QString("synthetic_%1_l_%2.yml").arg(f, 3, 10, QChar('0')).arg(language);
+            if (!writeFile(langDir.filePath(name), bytes)) return false;
+        }
+
+        // Name lists are skipped by cleanup and copied verbatim from their subfolders
+        for (const QString& folder : { QString("name_lists"), QString("random_names") }) {
+            langDir.mkpath(folder);
+            for (int n = 0; n < opts.nameListFiles; ++n) {
+                QByteArray bytes = "\xEF\xBB\xBFl_" + language.toUtf8() + ":\n";
+                for (int i = 0; i < 200; ++i) {
+                    bytes += " " + folder.toUtf8() + "_" + QByteArray::number(n) + "_" + QByteArray::number(i) + ":0 \"" + entryText(language, 1, 2).toUtf8() + "\"\n";
+                }
+                const QString suffix = QString("%1_%2_l_%3.yml").arg(folder).arg(n).arg(language);
+                if (!writeFile(langDir.filePath(suffix), bytes)) return false;
+                if (!writeFile(langDir.filePath(folder + "/" + suffix), bytes)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CorpusGenerator::generateExportFixtures(const QString& fixturesDir, const QList<CorpusCategory>& categories,
+    QString* selectionsJson, QString* error)
+{
+    if (!QDir().mkpath(fixturesDir)) {
+        if (error) *error = "Could not create " + fixturesDir;
+        return false;
+    }
+
+    // The export also carries Italian (dropped by the worker) and a column without a language suffix
+    QStringList columnLanguages = opts.languages;
+    if (!columnLanguages.contains("italian")) columnLanguages << "italian";
+
+    int nextModKey = vanillaKeyCount;
+    QJsonObject selections;
+    for (int c = 0; c < categories.size(); ++c) {
+        const CorpusCategory& category = categories.at(c);
+        QJsonArray sheets;
+        QJsonArray selectedIds;
+        for (int s = 0; s < opts.sheetsPerCategory; ++s) {
+            const qint64 sheetId = 1000LL * (c + 1) + s;
+            QJsonArray rows;
+
+            QJsonObject header;
+            for (const QString& language : columnLanguages) {
+                header[columnName(language)] = category.name + " (" + language + ")";
+            }
+            rows.append(header);
+
+            for (int r = 0; r < opts.rowsPerSheet; ++r) {
+                const int keyId = (vanillaKeyCount > 0 && chance(opts.modOverrideRatio))
+                    ? std::uniform_int_distribution<int>(0, vanillaKeyCount - 1)(rng)
+                    : nextModKey++;
+                const QString key = keyName(keyId);
+                QJsonObject row;
+                for (const QString& language : columnLanguages) {
+                    if (language != "english" && chance(opts.missingCellRatio)) continue;
+                    QString text = entryText(language, 2, 18);
+                    // Sheets often contain doubled spaces and line breaks that normalization removes
+                    if (chance(0.1)) text.replace(" ", "  ");
+                    if (chance(0.05)) text += "\n";
+                    row[columnName(language)] = key + ":0 \"" + text + "\"";
+                }
+                if (chance(0.2)) row["Notes"] = entryText("english", 1, 5);
+                rows.append(row);
+            }
+
+            QJsonObject sheet;
+            sheet["id"] = sheetId;
+            sheet["name"] = QString("%1 Sheet %2").arg(category.name.section(' ', 0, 0)).arg(s + 1);
+            sheet["rows"] = rows;
+            sheets.append(sheet);
+            selectedIds.append(sheetId);
+        }
+
+        QJsonObject fixture;
+        fixture["spreadsheetName"] = category.name;
+        fixture["sheets"] = sheets;
+        QFile file(QDir(fixturesDir).filePath(category.spreadsheetId + ".json"));
+        const QByteArray bytes = QJsonDocument(fixture).toJson(QJsonDocument::Compact);
+        if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size()) {
+            if (error) *error = "Could not write " + file.fileName();
+            return false;
+        }
+        totalBytes += bytes.size();
+        selections[category.name] = selectedIds;
+    }
+
+    if (selectionsJson) *selectionsJson = QString::fromUtf8(QJsonDocument(selections).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+QStringList CorpusGenerator::sampleValues(int count)
+{
+    QStringList values;
+    values.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QString& language = opts.languages.at(i % opts.languages.size());
+        QString text = entryText(language, 2, 18);
+        if (chance(0.3)) text.replace(" ", "  \t");
+        values << "  " + keyName(i) + ":0 \"" + text + "\"\n";
+    }
+    return values;
+}
+
+QStringList CorpusGenerator::sampleColumnNames(int count)
+{
+    QStringList names;
+    names.reserve(count);
+    QStringList pool;
+    for (const QString& language : opts.languages) pool << columnName(language);
+    pool << "KEY (Italian)" << "Notes" << "ID";
+    for (int i = 0; i < count; ++i) names << pool.at(i % pool.size());
+    return names;
+}
+
+std::vector<std::string> CorpusGenerator::sampleVanillaLines(int count)
+{
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QString& language = opts.languages.at((i / 64) % opts.languages.size());
+        if (chance(opts.commentRatio)) {
+            lines.push_back(" # " + entryText("english", 2, 6).toStdString());
+        }
+        else if (chance(opts.emptyStringRatio)) {
+            lines.push_back(" " + keyName(i).toStdString() + ":0 \"\"");
+        }
+        else {
+            lines.push_back(" " + keyName(i).toStdString() + ":0 \"" + entryText(language, 2, 14).toStdString() + "\"");
+        }
+    }
+    return lines;
+}
+
+std::vector<std::string> CorpusGenerator::sampleKeys(int count, int firstId)
+{
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (int i = 0; i < count; ++i) keys.push_back(keyName(firstId + i).toStdString());
+    return keys;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <random>
+#include <string>
+#include <vector>
+
+// Shape of a synthetic Stellaris-style corpus
+struct CorpusOptions {
+    QStringList languages = { "english", "braz_por", "french", "german", "polish", "russian", "spanish" };
+    int filesPerLanguage = 40;       // vanilla *.yml files per language (excluding name lists)
+    int linesPerFile = 1500;         // entries per vanilla file
+    double bomRatio = 0.9;           // share of vanilla files starting with a UTF-8 BOM
+    double emptyStringRatio = 0.02;  // share of entries with an empty "" value
+    double commentRatio = 0.03;      // share of comment/blank lines
+    int nameListFiles = 4;           // name_lists_*/random_names_* files and name_lists/ entries per language
+    int sheetsPerCategory = 4;       // sheets per exported spreadsheet
+    int rowsPerSheet = 2500;         // rows per sheet
+    double modOverrideRatio = 0.05;  // share of mod keys that override a vanilla key
+    double missingCellRatio = 0.04;  // share of non-English cells left empty
+    quint32 seed = 42;
+};
+
+// A category as the worker requests it (display name + spreadsheet it is exported from)
+struct CorpusCategory {
+    QString name;
+    QString spreadsheetId;
+};
+
+// Generates reproducible vanilla trees, export fixtures for LocalApiServer and kernel inputs
+class CorpusGenerator
+{
+public:
+    explicit CorpusGenerator(const CorpusOptions& options);
+
+    // Writes <root>/<lang>/*.yml including name_lists_/random_names_ files and name_lists/ subfolders
+    bool generateVanillaTree(const QString& root, QString* error = nullptr);
+
+    // Writes <fixturesDir>/<spreadsheetId>.json per category and returns the matching selections JSON
+    bool generateExportFixtures(const QString& fixturesDir, const QList<CorpusCategory>& categories,
+        QString* selectionsJson, QString* error = nullptr);
+
+    // Raw cell values as they come from the API (with stray whitespace runs)
+    QStringList sampleValues(int count);
+    // Column names as they appear in export rows, with and without language suffix
+    QStringList sampleColumnNames(int count);
+    // Vanilla file lines (entries, comments, empty strings)
+    std::vector<std::string> sampleVanillaLines(int count);
+    // Consecutive keys starting at firstId, named like the corpus keys
+    std::vector<std::string> sampleKeys(int count, int firstId);
+
+    const CorpusOptions& options() const { return opts; }
+    qint64 bytesWritten() const { return totalBytes; }
+
+private:
+    QString keyName(int id) const;
+    QString entryText(const QString& language, int minWords, int maxWords);
+    QString columnName(const QString& language) const;
+    bool chance(double p);
+
+    CorpusOptions opts;
+    std::mt19937 rng;
+    qint64 totalBytes = 0;
+    int vanillaKeyCount = 0;
+};
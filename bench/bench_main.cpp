@@ -0,0 +1,346 @@
+#include "CorpusGenerator.h"
+#include "../worker.h"
+#include "../LocalisationKernels.h"
+#include "../LocalApiServer.h"
+#include "../NetworkTransport.h"
+#include "../ModManifest.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <unordered_set>
+
+namespace {
+    // Categories as the worker requests them (the default mod of the manifest); fixture files are named after their spreadsheet ids
+    QList<CorpusCategory> manifestCategories()
+    {
+        QList<CorpusCategory> categories;
+        if (const ModDefinition* mod = ModManifest::instance().defaultMod()) {
+            for (const ModCategory& c : mod->categories) categories.append({ c.name, c.spreadsheetId });
+        }
+        return categories;
+    }
+
+    // One benchmark's timings; items/bytes describe the work done by a single repetition
+    struct BenchResult {
+        QString name;
+        qint64 items = 0;
+        qint64 bytes = 0;
+        std::vector<qint64> samplesNs;
+    };
+
+    // Keeps the optimizer from discarding kernel results
+    volatile size_t g_sink = 0;
+
+    BenchResult runBench(const QString& name, int repeat, qint64 items, qint64 bytes, const std::function<void()>& body)
+    {
+        BenchResult result;
+        result.name = name;
+        result.items = items;
+        result.bytes = bytes;
+        body(); // warm-up
+        for (int i = 0; i < repeat; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            body();
+            result.samplesNs.push_back(timer.nsecsElapsed());
+        }
+        return result;
+    }
+
+    QJsonObject toJson(const BenchResult& r)
+    {
+        std::vector<qint64> sorted = r.samplesNs;
+        std::sort(sorted.begin(), sorted.end());
+        qint64 total = 0;
+        for (qint64 ns : sorted) total += ns;
+        const double medianNs = sorted.empty() ? 0.0 : static_cast<double>(sorted[sorted.size() / 2]);
+        QJsonObject o;
+        o["name"] = r.name;
+        o["repeat"] = static_cast<int>(sorted.size());
+        o["items"] = r.items;
+        o["bytes"] = r.bytes;
+        o["min_ms"] = sorted.empty() ? 0.0 : sorted.front() / 1e6;
+        o["median_ms"] = medianNs / 1e6;
+        o["mean_ms"] = sorted.empty() ? 0.0 : (static_cast<double>(total) / sorted.size()) / 1e6;
+        o["ns_per_item"] = (r.items > 0 && medianNs > 0) ? medianNs / r.items : 0.0;
+        o["items_per_sec"] = medianNs > 0 ? r.items / (medianNs / 1e9) : 0.0;
+        o["mb_per_sec"] = medianNs > 0 ? (r.bytes / (1024.0 * 1024.0)) / (medianNs / 1e9) : 0.0;
+        return o;
+    }
+
+    qint64 totalBytes(const std::vector<std::string>& lines)
+    {
+        qint64 n = 0;
+        for (const auto& l : lines) n += static_cast<qint64>(l.size());
+        return n;
+    }
+
+    // Runs one worker task on its own thread and waits for taskFinished
+    bool runWorkerTask(Worker* worker, const char* method, const QString& outputPath, const QString& vanillaPath, QString* message)
+    {
+        QEventLoop loop;
+        bool ok = false;
+        QMetaObject::Connection c = QObject::connect(worker, &Worker::taskFinished, &loop, [&](bool success, const QString& msg) {
+            ok = success;
+            if (message) *message = msg;
+            loop.quit();
+        });
+        QMetaObject::invokeMethod(worker, method, Qt::QueuedConnection,
+            Q_ARG(int, ModManifest::instance().defaultMod()->modType), Q_ARG(QString, ""), Q_ARG(QString, outputPath), Q_ARG(QString, vanillaPath));
+        loop.exec();
+        QObject::disconnect(c);
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Microbenchmarks and end-to-end benchmarks for the localisation pipeline on a synthetic corpus.");
+    parser.addHelpOption();
+    QCommandLineOption corpusOption("corpus", "Corpus directory (generated if missing). Defaults to a temporary directory.", "dir");
+    QCommandLineOption outOption("out", "Write results as JSON to this file.", "file");
+    QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains this text.", "text");
+    QCommandLineOption repeatOption("repeat", "Repetitions per benchmark (default 5).", "n", "5");
+    QCommandLineOption languagesOption("languages", "Comma-separated languages (default: the seven supported).", "list");
+    QCommandLineOption filesOption("files", "Vanilla files per language.", "n");
+    QCommandLineOption linesOption("lines", "Entries per vanilla file.", "n");
+    QCommandLineOption sheetsOption("sheets", "Sheets per category.", "n");
+    QCommandLineOption rowsOption("rows", "Rows per sheet.", "n");
+    QCommandLineOption bomOption("bom-ratio", "Share of vanilla files with a BOM (0..1).", "ratio");
+    QCommandLineOption emptyOption("empty-ratio", "Share of empty-string entries (0..1).", "ratio");
+    QCommandLineOption nameListsOption("name-lists", "name_lists/random_names files per language.", "n");
+    QCommandLineOption seedOption("seed", "Generator seed.", "n");
+    QCommandLineOption noE2EOption("no-e2e", "Skip the end-to-end create/cleanup benchmarks.");
+    parser.addOptions({ corpusOption, outOption, filterOption, repeatOption, languagesOption, filesOption, linesOption,
+        sheetsOption, rowsOption, bomOption, emptyOption, nameListsOption, seedOption, noE2EOption });
+    parser.process(app);
+
+    CorpusOptions corpus;
+    if (parser.isSet(languagesOption)) corpus.languages = parser.value(languagesOption).split(',', Qt::SkipEmptyParts);
+    if (parser.isSet(filesOption)) corpus.filesPerLanguage = parser.value(filesOption).toInt();
+    if (parser.isSet(linesOption)) corpus.linesPerFile = parser.value(linesOption).toInt();
+    if (parser.isSet(sheetsOption)) corpus.sheetsPerCategory = parser.value(sheetsOption).toInt();
+    if (parser.isSet(rowsOption)) corpus.rowsPerSheet = parser.value(rowsOption).toInt();
+    if (parser.isSet(bomOption)) corpus.bomRatio = parser.value(bomOption).toDouble();
+    if (parser.isSet(emptyOption)) corpus.emptyStringRatio = parser.value(emptyOption).toDouble();
+    if (parser.isSet(nameListsOption)) corpus.nameListFiles = parser.value(nameListsOption).toInt();
+    if (parser.isSet(seedOption)) corpus.seed = parser.value(seedOption).toUInt();
+    const int repeat = std::max(1, parser.value(repeatOption).toInt());
+    const QString filter = parser.value(filterOption);
+    auto enabled = [&filter](const QString& name) { return filter.isEmpty() || name.contains(filter, Qt::CaseInsensitive); };
+
+    QTemporaryDir tempDir;
+    const QString corpusDir = parser.isSet(corpusOption) ? parser.value(corpusOption) : tempDir.path();
+    const QString vanillaDir = corpusDir + "/vanilla";
+    const QString fixturesDir = corpusDir + "/fixtures";
+    const QString outputDir = corpusDir + "/output";
+
+    QList<BenchResult> results;
+    CorpusGenerator generator(corpus);
+
+    // ---- Microbenchmarks on in-memory samples ----
+    const int sampleCount = 200000;
+    const QStringList values = generator.sampleValues(sampleCount);
+    qint64 valueBytes = 0;
+    for (const QString& v : values) valueBytes += v.toUtf8().size();
+    if (enabled("normalize_value")) {
+        results << runBench("normalize_value", repeat, values.size(), valueBytes, [&]() {
+            size_t n = 0;
+            for (const QString& v : values) n += static_cast<size_t>(LocalisationKernels::normalizeValue(v).size());
+            g_sink = n;
+        });
+    }
+
+    const QStringList columns = generator.sampleColumnNames(sampleCount);
+    if (enabled("resolve_language")) {
+        results << runBench("resolve_language", repeat, columns.size(), 0, [&]() {
+            size_t n = 0;
+            for (const QString& c : columns) n += static_cast<size_t>(LocalisationKernels::resolveLanguageColumn(c).size());
+            g_sink = n;
+        });
+    }
+
+    const std::vector<std::string> vanillaLines = generator.sampleVanillaLines(sampleCount);
+    const qint64 vanillaLineBytes = totalBytes(vanillaLines);
+    if (enabled("key_scan")) {
+        results << runBench("key_scan", repeat, static_cast<qint64>(vanillaLines.size()), vanillaLineBytes, [&]() {
+            size_t n = 0;
+            std::string key;
+            for (const std::string& line : vanillaLines) {
+                if (LocalisationKernels::parseKeyLine(line, key)) n += key.size();
+            }
+            g_sink = n;
+        });
+    }
+    if (enabled("empty_string_fix")) {
+        results << runBench("empty_string_fix", repeat, static_cast<qint64>(vanillaLines.size()), vanillaLineBytes, [&]() {
+            size_t n = 0;
+            for (const std::string& line : vanillaLines) n += LocalisationKernels::fixEmptyString(line).size();
+            g_sink = n;
+        });
+    }
+    if (enabled("utf8_validate")) {
+        QByteArray joined;
+        joined.reserve(vanillaLineBytes + static_cast<qint64>(vanillaLines.size()));
+        for (const std::string& line : vanillaLines) joined.append(line.data(), static_cast<qsizetype>(line.size())).append('\n');
+        results << runBench("utf8_validate", repeat, static_cast<qint64>(vanillaLines.size()), joined.size(), [&]() {
+            g_sink = LocalisationKernels::isValidUtf8(joined.constData(), joined.size()) ? 1 : 0;
+        });
+    }
+
+    if (enabled("used_tags_lookup")) {
+        // Half the probed keys are mod tags, like a vanilla scan against a large mod
+        const std::vector<std::string> modKeys = generator.sampleKeys(sampleCount, 0);
+        std::unordered_set<std::string> usedTags(modKeys.begin(), modKeys.end());
+        const std::vector<std::string> probes = generator.sampleKeys(sampleCount, sampleCount / 2);
+        results << runBench("used_tags_lookup", repeat, static_cast<qint64>(probes.size()), totalBytes(probes), [&]() {
+            size_t hits = 0;
+            for (const std::string& k : probes) hits += usedTags.count(k);
+            g_sink = hits;
+        });
+    }
+
+    std::vector<std::string> entries;
+    entries.reserve(vanillaLines.size());
+    for (const std::string& line : vanillaLines) entries.push_back(line.substr(1));
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(corpus.seed));
+    if (enabled("sort_lines")) {
+        results << runBench("sort_lines", repeat, static_cast<qint64>(entries.size()), totalBytes(entries), [&]() {
+            std::vector<std::string> copy = entries;
+            LocalisationKernels::sortLines(copy);
+            g_sink = copy.size();
+        });
+    }
+
+    if (enabled("yml_write")) {
+        QDir().mkpath(corpusDir);
+        const QString path = corpusDir + "/bench_write_l_english.yml";
+        std::vector<std::string> sorted = entries;
+        LocalisationKernels::sortLines(sorted);
+        results << runBench("yml_write", repeat, static_cast<qint64>(sorted.size()), totalBytes(sorted), [&]() {
+            g_sink = static_cast<size_t>(LocalisationKernels::writeYmlFile(path, "english", sorted));
+        });
+        results << runBench("yml_write_atomic", repeat, static_cast<qint64>(sorted.size()), totalBytes(sorted), [&]() {
+            g_sink = static_cast<size_t>(LocalisationKernels::writeYmlFile(path, "english", sorted, true));
+        });
+        QFile::remove(path);
+    }
+
+    // ---- End-to-end create and cleanup on a generated corpus ----
+    if (!parser.isSet(noE2EOption) && (enabled("e2e_create") || enabled("e2e_cleanup"))) {
+        QString error;
+        QString selectionsJson;
+        QElapsedTimer genTimer; genTimer.start();
+        if (!QDir(vanillaDir).exists() && !generator.generateVanillaTree(vanillaDir, &error)) {
+            std::fprintf(stderr, "ERROR: %s\n", qUtf8Printable(error));
+            return 1;
+        }
+        const QList<CorpusCategory> categories = manifestCategories();
+        if (!generator.generateExportFixtures(fixturesDir, categories, &selectionsJson, &error)) {
+            std::fprintf(stderr, "ERROR: %s\n", qUtf8Printable(error));
+            return 1;
+        }
+        std::fprintf(stderr, "Generated corpus in %s (%lld bytes, %lld ms)\n", qUtf8Printable(corpusDir),
+            static_cast<long long>(generator.bytesWritten()), static_cast<long long>(genTimer.elapsed()));
+
+        // Serve the fixtures locally and route the worker's Apps Script traffic there
+        LocalApiServer server(fixturesDir);
+        if (!server.listen()) {
+            std::fprintf(stderr, "ERROR: Could not start the local API server\n");
+            return 1;
+        }
+        TransportOptions transport;
+        transport.endpointOverride = server.endpointUrl();
+        NetworkTransport::setDefaultOptions(transport);
+
+        QThread workerThread;
+        Worker* worker = new Worker();
+        worker->moveToThread(&workerThread);
+        QObject::connect(&workerThread, &QThread::finished, worker, &QObject::deleteLater);
+        workerThread.start();
+        QMetaObject::invokeMethod(worker, "setSelectionsJson", Qt::QueuedConnection, Q_ARG(QString, selectionsJson));
+        // Every repetition measures a full export rather than a sheet cache hit
+        QMetaObject::invokeMethod(worker, "setDeltaExport", Qt::QueuedConnection, Q_ARG(bool, false));
+
+        qint64 exportBytes = 0;
+        for (const CorpusCategory& c : categories) exportBytes += QFileInfo(fixturesDir + "/" + c.spreadsheetId + ".json").size();
+        const qint64 rows = static_cast<qint64>(categories.size()) * corpus.sheetsPerCategory * corpus.rowsPerSheet;
+        const qint64 vanillaEntries = static_cast<qint64>(corpus.languages.size()) * corpus.filesPerLanguage * corpus.linesPerFile;
+
+        bool ok = true;
+        QString message;
+        if (enabled("e2e_create")) {
+            results << runBench("e2e_create", repeat, rows, exportBytes, [&]() {
+                ok = runWorkerTask(worker, "doCreateTask", outputDir, vanillaDir, &message) && ok;
+            });
+        }
+        else {
+            // Cleanup needs the STH_ files of one create run; that setup is neither timed nor reported
+            ok = runWorkerTask(worker, "doCreateTask", outputDir, vanillaDir, &message);
+        }
+        if (ok && enabled("e2e_cleanup")) {
+            // Cleanup is repeatable on the same output: it only reads the STH_ files and rewrites vanilla copies.
+            // After the warm-up the worker's vanilla index is primed, so this measures the cost per additional mod.
+            results << runBench("e2e_cleanup", repeat, vanillaEntries, generator.bytesWritten(), [&]() {
+                ok = runWorkerTask(worker, "doCleanupTask", outputDir, vanillaDir, &message) && ok;
+            });
+        }
+        if (!ok) std::fprintf(stderr, "WARNING: End-to-end run reported failure: %s\n", qUtf8Printable(message));
+
+        workerThread.quit();
+        workerThread.wait();
+    }
+
+    // ---- Report ----
+    QJsonArray jsonResults;
+    for (const BenchResult& r : results) {
+        const QJsonObject o = toJson(r);
+        jsonResults.append(o);
+        std::fprintf(stderr, "%-20s median %10.3f ms  %12.1f items/s  %8.1f MB/s\n", qUtf8Printable(r.name),
+            o.value("median_ms").toDouble(), o.value("items_per_sec").toDouble(), o.value("mb_per_sec").toDouble());
+    }
+    QJsonObject root;
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["host"] = QSysInfo::machineHostName();
+    root["os"] = QSysInfo::prettyProductName();
+    root["cpu_arch"] = QSysInfo::currentCpuArchitecture();
+    QJsonObject corpusJson;
+    corpusJson["languages"] = QJsonArray::fromStringList(corpus.languages);
+    corpusJson["files_per_language"] = corpus.filesPerLanguage;
+    corpusJson["lines_per_file"] = corpus.linesPerFile;
+    corpusJson["sheets_per_category"] = corpus.sheetsPerCategory;
+    corpusJson["rows_per_sheet"] = corpus.rowsPerSheet;
+    corpusJson["bom_ratio"] = corpus.bomRatio;
+    corpusJson["empty_string_ratio"] = corpus.emptyStringRatio;
+    corpusJson["seed"] = static_cast<qint64>(corpus.seed);
+    root["corpus"] = corpusJson;
+    root["results"] = jsonResults;
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (parser.isSet(outOption)) {
+        QFile out(parser.value(outOption));
+        if (!out.open(QIODevice::WriteOnly) || out.write(json) != json.size()) {
+            std::fprintf(stderr, "ERROR: Could not write %s\n", qUtf8Printable(parser.value(outOption)));
+            return 1;
+        }
+    }
+    else {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+    return 0;
+}
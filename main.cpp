@@ -1,9 +1,15 @@
 #include "PDG_LocalisationCreator_GUI.h"
+#include "BatchRunner.h"
 #include <QtWidgets/QApplication>
 #include <QIcon>
 
 int main(int argc, char *argv[])
 {
+    // Headless mode (--cli/--headless) runs on a QCoreApplication and never touches widgets
+    if (BatchRunner::isHeadlessRequested(argc, argv)) {
+        return BatchRunner::runFromCommandLine(argc, argv);
+    }
+
     QApplication app(argc, argv);
     // Set global application/window icon from resources
     app.setWindowIcon(QIcon(":/PDG_LocalisationCreator_GUI/icons/app.png"));
@@ -1,7 +1,17 @@
 #include "worker.h"
+#include "NetworkTransport.h"
+#include "LocalisationKernels.h"
+#include "SheetCache.h"
+#include "ModManifest.h"
+#include "VanillaIndex.h"
+#include "CoverageReport.h"
+#include "KeyConflicts.h"
+#include "ChangeSet.h"
+#include "KeyDiffReport.h"
+#include "KeyIndex.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QDir>
-#include <QTextStream>
 #include <QRegularExpression>
 #include <QFileInfo>
 #include <QDebug>
@@ -10,8 +20,8 @@
 #include <unordered_set>
 #include <string>
 #include <vector>
-#include <regex>
 #include <algorithm>
+#include <iterator>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
@@ -24,6 +34,9 @@
 #include <functional>
 #include <cmath>
 #include <QElapsedTimer>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <memory>
 
 
 // A struct to hold the API call data for each file.
@@ -31,111 +44,588 @@ struct ApiData {
     QString webAppUrl;
     QString spreadsheetId;
     QJsonArray targetSheets;
+    QStringList languages;   // language columns to export, lower-cased; empty: all
+    bool columnar = false;   // ask for the compact columnar layout
+};
+
+namespace {
+    // Category -> output file template for a mod
+    std::vector<std::pair<QString, QString>> modFileNames(const ModDefinition& mod)
+    {
+        std::vector<std::pair<QString, QString>> filenames;
+        for (const ModCategory& category : mod.categories) filenames.emplace_back(category.name, category.fileTemplate);
+        return filenames;
+    }
+
+    // Map categories to their corresponding API data (targetSheets intentionally left empty; must be provided by user selection)
+    QMap<QString, ApiData> modApiMappings(const ModDefinition& mod, bool columnar)
+    {
+        QMap<QString, ApiData> apiMappings;
+        for (const ModCategory& category : mod.categories) {
+            apiMappings[category.name] = { category.webAppUrl, category.spreadsheetId, QJsonArray(), mod.exportLanguages(), columnar };
+        }
+        return apiMappings;
+    }
+
+    // Copies selected sheet ids (category -> [sheetIds]) into the mappings; false if the JSON is not an object
+    bool applySelections(const QString& selectionsJson, QMap<QString, ApiData>& apiMappings)
+    {
+        QJsonDocument selDoc = QJsonDocument::fromJson(selectionsJson.toUtf8());
+        if (!selDoc.isObject()) return false;
+        QJsonObject selObj = selDoc.object();
+        for (auto it = selObj.begin(); it != selObj.end(); ++it) {
+            if (!it.value().isArray()) continue;
+            const QString category = it.key();
+            if (apiMappings.contains(category)) {
+                QJsonArray ids = it.value().toArray();
+                if (!ids.isEmpty()) {
+                    apiMappings[category].targetSheets = ids;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Builds the Apps Script export URL for one category
+    QUrl buildExportUrl(const ApiData& apiData)
+    {
+        QJsonObject jsonSettings;
+        jsonSettings["exportType"] = "jsonFormat";
+        jsonSettings["spreadsheetId"] = apiData.spreadsheetId;
+        jsonSettings["exportSheets"] = "custom";
+        jsonSettings["targetSheets"] = apiData.targetSheets;
+        // Compact: one header row of column names, then value arrays, no whitespace.
+        // Script versions that do not know transportFormat send the usual row objects.
+        jsonSettings["minifyData"] = apiData.columnar;
+        if (apiData.columnar) jsonSettings["transportFormat"] = "columnar";
+        jsonSettings["exportBoolsAsInts"] = false;
+        jsonSettings["ignoreEmptyCells"] = true;
+        jsonSettings["includeFirstColumn"] = false;
+        jsonSettings["nestedElements"] = false;
+        jsonSettings["unwrapSingleRows"] = false;
+        jsonSettings["collapseSingleRows"] = false;
+        jsonSettings["ignoreColumnsWithPrefix"] = true;
+        jsonSettings["ignorePrefix"] = "NOEX_";
+        jsonSettings["unwrapSheetsWithPrefix"] = false;
+        jsonSettings["unwrapPrefix"] = "US_";
+        jsonSettings["collapseSheetsWithPrefix"] = false;
+        jsonSettings["collapsePrefix"] = "CS_";
+        // Column projection: the script leaves out other languages and columns without a "(Language)" suffix.
+        // Script versions without it send every column; the parser drops them then.
+        if (!apiData.languages.isEmpty()) jsonSettings["languages"] = QJsonArray::fromStringList(apiData.languages);
+        jsonSettings["dropUnlabeledColumns"] = true;
+        QJsonObject jsonSubSettings;
+        jsonSubSettings["forceString"] = false;
+        jsonSubSettings["exportCellArray"] = false;
+        jsonSubSettings["exportSheetArray"] = true;
+        jsonSubSettings["exportValueArray"] = false;
+        QJsonObject advancedSubSettings;
+        advancedSubSettings["exportContentsAsArray"] = false;
+        advancedSubSettings["exportCellObject"] = false;
+        advancedSubSettings["emptyValueFormat"] = "null";
+        advancedSubSettings["nullValueFormat"] = "null";
+        advancedSubSettings["separatorChar"] = ",";
+        advancedSubSettings["forceArray"] = false;
+        advancedSubSettings["forceArrayPrefix"] = "JA_";
+        advancedSubSettings["forceArrayNest"] = false;
+        advancedSubSettings["forceNestedArrayPrefix"] = "NA_";
+        jsonSubSettings["advanced"] = advancedSubSettings;
+        jsonSettings["json"] = jsonSubSettings;
+
+        QJsonDocument jsonDoc(jsonSettings);
+        QByteArray encodedPayload = QUrl::toPercentEncoding(jsonDoc.toJson(QJsonDocument::Compact));
+        QUrlQuery urlQuery;
+        urlQuery.addQueryItem("settings", encodedPayload);
+        QUrl url(apiData.webAppUrl);
+        url.setQuery(urlQuery);
+        return url;
+    }
+
+    // Appends language -> entries from the rows of one exported sheet; languages the mod does not write are skipped.
+    // Stops early once the task is cancelled.
+    void appendSheetRows(const QJsonArray& rows, const ModDefinition& mod, std::unordered_map<std::string, std::vector<std::string>>& translations,
+        const CancellationToken& cancel, qint64* rowCount)
+    {
+        if (rowCount) *rowCount += rows.size();
+        for (qsizetype r = 0; r < rows.size(); ++r) {
+            if (cancel.isCancelledAt(r)) return;
+            const QJsonValue itemValue = rows.at(r);
+            if (itemValue.isObject()) {
+                QJsonObject itemObject = itemValue.toObject();
+                for (auto locIt = itemObject.begin(); locIt != itemObject.end(); ++locIt) {
+                    const QString language = LocalisationKernels::resolveLanguageColumn(locIt.key());
+                    if (!language.isEmpty() && mod.writesLanguage(language)) {
+                        const QString value = LocalisationKernels::normalizeValue(locIt.value().toString());
+                        if (!LocalisationKernels::isHeaderValue(value)) {
+                            translations[language.toStdString()].push_back(value.toStdString());
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Same for a sheet in the columnar layout ({"columns": [...], "rows": [[...], ...]}, null for empty cells).
+    // Column languages are resolved once per sheet instead of once per cell.
+    void appendColumnarRows(const QJsonObject& table, const ModDefinition& mod, std::unordered_map<std::string, std::vector<std::string>>& translations,
+        const CancellationToken& cancel, qint64* rowCount)
+    {
+        // column -> entries of its language, null for columns that are not written
+        std::vector<std::vector<std::string>*> targets;
+        for (const QJsonValue& column : table.value("columns").toArray()) {
+            const QString language = LocalisationKernels::resolveLanguageColumn(column.toString());
+            targets.push_back(!language.isEmpty() && mod.writesLanguage(language) ? &translations[language.toStdString()] : nullptr);
+        }
+        const QJsonArray rows = table.value("rows").toArray();
+        if (rowCount) *rowCount += rows.size();
+        for (qsizetype r = 0; r < rows.size(); ++r) {
+            if (cancel.isCancelledAt(r)) return;
+            const QJsonArray row = rows.at(r).toArray();
+            const qsizetype cells = std::min<qsizetype>(row.size(), static_cast<qsizetype>(targets.size()));
+            for (qsizetype i = 0; i < cells; ++i) {
+                if (!targets[i]) continue;
+                const QJsonValue cell = row.at(i);
+                if (cell.isNull() || cell.isUndefined()) continue;
+                const QString value = LocalisationKernels::normalizeValue(cell.toString());
+                if (!LocalisationKernels::isHeaderValue(value)) targets[i]->push_back(value.toStdString());
+            }
+        }
+    }
+
+    // Calls appendSheet(sheet name, sheet, columnar) for every sheet of an export payload, in either layout;
+    // false if the payload is not a JSON object
+    template<typename AppendSheet>
+    bool forEachExportSheet(const QByteArray& responseData, AppendSheet appendSheet)
+    {
+        QJsonDocument responseDoc = QJsonDocument::fromJson(responseData);
+        if (!responseDoc.isObject()) return false;
+        const QJsonObject rootObject = responseDoc.object();
+        const bool columnar = rootObject.value("format").toString() == "columnar";
+        const QJsonObject sheets = columnar ? rootObject.value("sheets").toObject() : rootObject;
+        for (auto it = sheets.begin(); it != sheets.end(); ++it) {
+            if (columnar ? it.value().isObject() : it.value().isArray()) appendSheet(it.key(), it.value(), columnar);
+        }
+        return true;
+    }
+
+    // Collects language -> entries from an export payload; false if the payload is not a JSON object.
+    // rowCount, when given, is increased by the number of rows read.
+    // A cancelled task stops early with part of the entries; callers check the token.
+    bool parseExportPayload(const QByteArray& responseData, const ModDefinition& mod,
+        std::unordered_map<std::string, std::vector<std::string>>& translations, const CancellationToken& cancel, qint64* rowCount = nullptr)
+    {
+        return forEachExportSheet(responseData, [&](const QString&, const QJsonValue& sheet, bool columnar) {
+            if (columnar) appendColumnarRows(sheet.toObject(), mod, translations, cancel, rowCount);
+            else appendSheetRows(sheet.toArray(), mod, translations, cancel, rowCount);
+            });
+    }
+
+    // Same as parseExportPayload, but keeps every sheet's entries apart (sheet name -> language -> entries)
+    bool parseExportSheets(const QByteArray& responseData, const ModDefinition& mod, QHash<QString, SheetCache::LanguageEntries>& sheets,
+        const CancellationToken& cancel, qint64* rowCount = nullptr)
+    {
+        return forEachExportSheet(responseData, [&](const QString& name, const QJsonValue& sheet, bool columnar) {
+            if (columnar) appendColumnarRows(sheet.toObject(), mod, sheets[name], cancel, rowCount);
+            else appendSheetRows(sheet.toArray(), mod, sheets[name], cancel, rowCount);
+            });
+    }
+
+    // Builds the listSheets URL for a set of spreadsheets served by one web app
+    QUrl buildListSheetsUrl(const QString& webAppUrl, const QStringList& spreadsheetIds)
+    {
+        QJsonArray ids;
+        for (const QString& id : spreadsheetIds) ids.append(id);
+        QUrlQuery urlQuery;
+        urlQuery.addQueryItem("action", "listSheets");
+        urlQuery.addQueryItem("ids", QString::fromUtf8(QJsonDocument(ids).toJson(QJsonDocument::Compact)));
+        QUrl url(webAppUrl);
+        url.setQuery(urlQuery);
+        return url;
+    }
+
+    // Revision of a sheet in a listSheets reply; older script versions only report lastModified
+    QString sheetRevision(const QJsonObject& sheet)
+    {
+        const QString revision = sheet.value("revision").toString();
+        return revision.isEmpty() ? sheet.value("lastModified").toString() : revision;
+    }
+
+    // Output/<lang>/<file> for a category file template such as STH_main_l_<lang>.yml
+    QString categoryFilePath(const QString& outputPath, const QString& fileTemplate, const QString& lang)
+    {
+        QString fileName = fileTemplate;
+        fileName.replace("<lang>", lang);
+        return outputPath + "/" + lang + "/" + fileName;
+    }
+
+    // Empties Output but keeps the generated category files, which the delta export only rewrites when they changed
+    void clearOutputExceptCategoryFiles(const QString& outputPath, const std::vector<std::pair<QString, QString>>& filenames)
+    {
+        QDir outputDir(outputPath);
+        for (const QFileInfo& entry : outputDir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
+            if (!entry.isDir()) {
+                QFile::remove(entry.absoluteFilePath());
+                continue;
+            }
+            const QString lang = entry.fileName();
+            QSet<QString> keep;
+            for (const auto& filePair : filenames) {
+                QString fileName = filePair.second;
+                keep.insert(fileName.replace("<lang>", lang));
+            }
+            QDir langDir(entry.absoluteFilePath());
+            for (const QFileInfo& langEntry : langDir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
+                if (langEntry.isDir()) QDir(langEntry.absoluteFilePath()).removeRecursively();
+                else if (!keep.contains(langEntry.fileName())) QFile::remove(langEntry.absoluteFilePath());
+            }
+        }
+    }
+
+    // Languages the cleanup processes: the same ones the create step writes (ModDefinition::writesLanguage), taken
+    // from the manifest or, when it lists none, from the vanilla language folders
+    std::vector<QString> cleanupLanguages(const ModDefinition& mod, const QString& vanillaPath)
+    {
+        std::vector<QString> candidates = mod.languages;
+        if (candidates.empty()) {
+            for (const QString& dir : QDir(vanillaPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) candidates.push_back(dir);
+        }
+        std::vector<QString> result;
+        for (const QString& lang : candidates) {
+            if (mod.writesLanguage(lang.toLower())) result.push_back(lang);
+        }
+        return result;
+    }
+
+    // Moves the generated category files out of Output into the same layout under targetDir; a file that cannot
+    // be renamed (e.g. another drive) is copied and removed. Returns the target paths of the files not moved.
+    QStringList moveCategoryFiles(const QString& outputPath, const std::vector<std::pair<QString, QString>>& filenames, const QString& targetDir)
+    {
+        QStringList failed;
+        for (const QString& lang : QDir(outputPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            for (const auto& filePair : filenames) {
+                const QString path = categoryFilePath(outputPath, filePair.second, lang);
+                if (!QFileInfo::exists(path)) continue;
+                const QString target = categoryFilePath(targetDir, filePair.second, lang);
+                QDir(targetDir).mkpath(lang);
+                if (QFile::rename(path, target)) continue;
+                if (QFile::copy(path, target)) {
+                    QFile::remove(path);
+                    continue;
+                }
+                failed << target;
+            }
+        }
+        return failed;
+    }
+
+    // Replies of one export attempt: the request and possibly its hedge
+    struct ExportAttempt {
+        QList<QNetworkReply*> replies;   // still running
+        QNetworkReply* hedge = nullptr;
+        QHash<QNetworkReply*, qint64> received; // body bytes read from the connection, before decompression
+        bool settled = false;            // a reply was used, or every reply failed
+        bool timedOut = false;
+    };
+
+    // Hedged requests of a create run; the budget is a share of the attempts
+    struct HedgeStats {
+        int primaries = 0;
+        int sent = 0;
+        int won = 0;
+    };
+
+    // Time from the first export request to the last reply, and what the history predicted for it
+    struct MakespanStats {
+        QElapsedTimer clock;
+        qint64 expectedMs = -1;   // -1: some category had no recorded latency
+        qint64 actualMs = 0;
+        int requests = 0;         // categories requested from the web app
+    };
+
+    // Export bytes of a create run: as transferred, and after decompression
+    struct TransferStats {
+        qint64 transferred = 0;
+        qint64 decoded = 0;
+    };
+}
+
+// Per category: what the create task fetches, and what listSheets reported for the selected sheets
+struct Worker::CategoryPlan {
+    bool delta = false;                 // sheet metadata available; false falls back to exporting all selected sheets
+    QString spreadsheetId;
+    QList<qint64> selected;             // selected sheets that still exist
+    QJsonArray fetchSheets;             // sheets whose revision changed (or is unknown)
+    QHash<qint64, QString> names;       // sheet id -> name, to map the export payload (keyed by name) back to ids
+    QHash<qint64, QString> revisions;   // sheet id -> current revision
+    SheetCache::Manifest manifest;      // what the previous run cached and wrote
 };
 
 // Constructor for Worker class
-Worker::Worker(QObject* parent) : QObject(parent), networkManager(new QNetworkAccessManager(this)) {}
+Worker::Worker(QObject* parent) : QObject(parent), networkManager(NetworkTransport::createAccessManager(this))
+{
+    qRegisterMetaType<WorkerMetrics>();
+}
 
-// Request cooperative cancellation (abort in-flight network replies)
-void Worker::requestCancel()
+void Worker::publishMetrics(bool force)
+{
+    WorkerMetrics snapshot;
+    if (!m_metrics.snapshot(snapshot, force)) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        snapshot.requestsInFlight = static_cast<int>(m_activeReplies.size());
+    }
+    const qint64 predicted = m_predictRemaining ? m_predictRemaining(snapshot.elapsedMs) : -1;
+    snapshot.remainingMs = RunHistory::remainingMs(predicted, snapshot.elapsedMs, snapshot.fraction());
+    emit metricsUpdated(snapshot);
+    const int percent = snapshot.percent();
+    if (percent >= 0 && percent != m_lastPercent) {
+        m_lastPercent = percent;
+        emit progressUpdated(percent);
+    }
+}
+
+void Worker::trackDownload(QNetworkReply* reply, const std::function<void(qint64, qint64)>& onProgress)
+{
+    auto counted = std::make_shared<qint64>(0);
+    connect(reply, &QNetworkReply::downloadProgress, this, [=](qint64 received, qint64 total) {
+        m_metrics.counters().bytesDownloaded += received - *counted;
+        *counted = received;
+        if (onProgress) onProgress(received, total);
+        publishMetrics();
+        });
+}
+
+void Worker::setRequestLimits(int maxConcurrent, int timeoutSec)
+{
+    RequestScheduler::Settings settings = m_scheduler.settings();
+    if (maxConcurrent > 0) settings.maxWindow = maxConcurrent;
+    if (timeoutSec > 0) settings.attemptTimeoutMs = timeoutSec * 1000;
+    m_scheduler.setSettings(settings);
+}
+
+void Worker::warmUp(int modType)
 {
-    m_cancelRequested.store(true);
-    QMutexLocker locker(&m_mutex);
-    for (QNetworkReply* r : m_activeReplies) {
-        if (r) r->abort();
+    const ModDefinition* mod = ModManifest::instance().findByType(modType);
+    if (!mod) return;
+    QStringList urls;
+    for (const ModCategory& category : mod->categories) urls << category.webAppUrl;
+    NetworkTransport::warmUp(networkManager, urls);
+}
+
+void Worker::prefetchExports(int modType, const QString& selectionsJson)
+{
+    const ModDefinition* mod = ModManifest::instance().findByType(modType);
+    if (!mod || selectionsJson.trimmed().isEmpty()) return;
+    QMap<QString, ApiData> apiMappings = modApiMappings(*mod, m_compactExport);
+    if (!applySelections(selectionsJson, apiMappings)) return;
+
+    // Payloads of earlier selections are dropped; pending ones may already have a run waiting for them
+    for (auto it = m_prefetched.begin(); it != m_prefetched.end();) {
+        if (it.value()->pending) ++it;
+        else it = m_prefetched.erase(it);
+    }
+
+    // listings: spreadsheetId -> sheets, as listed before the exports are requested
+    auto requestExports = [=](const QHash<QString, QJsonArray>& listings) {
+        for (auto it = apiMappings.constBegin(); it != apiMappings.constEnd(); ++it) {
+            if (it->targetSheets.isEmpty()) continue;
+            const QUrl url = buildExportUrl(it.value());
+            const QString key = url.toString();
+            if (m_prefetched.contains(key)) continue;
+            auto entry = std::make_shared<PrefetchedExport>();
+            for (const QJsonValue& sv : listings.value(it->spreadsheetId)) {
+                const QJsonObject sheet = sv.toObject();
+                entry->revisions.insert(sheet.value("id").toVariant().toLongLong(), sheetRevision(sheet));
+            }
+            m_prefetched.insert(key, entry);
+
+            const QString category = it.key();
+            QNetworkReply* reply = networkManager->get(QNetworkRequest(url));
+            {
+                QMutexLocker locker(&m_mutex);
+                m_activeReplies.append(reply);
+            }
+            connect(reply, &QNetworkReply::finished, this, [=]() {
+                {
+                    QMutexLocker locker(&m_mutex);
+                    m_activeReplies.removeAll(reply);
+                }
+                entry->pending = false;
+                if (reply->error() == QNetworkReply::NoError) {
+                    entry->payload = reply->readAll();
+                    entry->fetchedAtMs = QDateTime::currentMSecsSinceEpoch();
+                    emit logMessage(QString("DEBUG: Prefetched the export of %1 (%2 bytes)").arg(category).arg(entry->payload.size()));
+                }
+                else {
+                    entry->failed = true;
+                    if (m_prefetched.value(key) == entry) m_prefetched.remove(key);
+                    emit logMessage(QString("DEBUG: Prefetch of %1 failed: %2").arg(category).arg(reply->errorString()));
+                }
+                reply->deleteLater();
+                const QList<std::function<void()>> waiters = entry->waiters;
+                entry->waiters.clear();
+                for (const auto& waiter : waiters) waiter();
+                });
+        }
+        };
+
+    if (!m_deltaExport) {
+        requestExports(QHash<QString, QJsonArray>());
+        return;
     }
+
+    // A delta run only takes a prefetched export if its sheets still have the revisions listed here
+    QMap<QString, QStringList> spreadsheetsByUrl;
+    for (auto it = apiMappings.constBegin(); it != apiMappings.constEnd(); ++it) {
+        if (!it->targetSheets.isEmpty()) spreadsheetsByUrl[it->webAppUrl] << it->spreadsheetId;
+    }
+    auto listings = std::make_shared<QHash<QString, QJsonArray>>();
+    auto pendingListings = std::make_shared<int>(static_cast<int>(spreadsheetsByUrl.size()));
+    for (auto it = spreadsheetsByUrl.constBegin(); it != spreadsheetsByUrl.constEnd(); ++it) {
+        QNetworkReply* reply = networkManager->get(QNetworkRequest(buildListSheetsUrl(it.key(), it.value())));
+        connect(reply, &QNetworkReply::finished, this, [=]() {
+            if (reply->error() == QNetworkReply::NoError) {
+                const QJsonArray spreadsheets = QJsonDocument::fromJson(reply->readAll()).object().value("spreadsheets").toArray();
+                for (const QJsonValue& v : spreadsheets) {
+                    listings->insert(v.toObject().value("spreadsheetId").toString(), v.toObject().value("sheets").toArray());
+                }
+            }
+            reply->deleteLater();
+            if (--(*pendingListings) == 0) requestExports(*listings);
+            });
+    }
+}
+
+// Request cooperative cancellation: CPU loops see the token at once, in-flight replies are aborted and pending
+// retries fire early on the worker thread
+void Worker::requestCancel()
+{
+    m_cancel.cancel();
+    QMetaObject::invokeMethod(this, [this]() {
+        QMutexLocker locker(&m_mutex);
+        const QList<QNetworkReply*> replies = m_activeReplies;
+        locker.unlock();
+        for (QNetworkReply* r : replies) {
+            if (r) r->abort();
+        }
+        for (QTimer* timer : m_retryTimers) timer->start(0);
+        }, Qt::QueuedConnection);
+}
+
+void Worker::logCancelled(const QString& stage)
+{
+    emit logMessage(QString("INFO: Cancelled during %1; stopped %2 ms after the request.").arg(stage).arg(m_cancel.sinceCancelMs()));
 }
 
 // Slot to start the creation process for a given mod type
 void Worker::doCreateTask(int modType, const QString& inputPath, const QString& outputPath, const QString& vanillaPath)
 {
-    m_cancelRequested.store(false);
+    m_cancel.reset();
     runCreateProcess(modType, inputPath, outputPath, vanillaPath);
 }
 
 // Slot to start the cleanup process for a given mod type
 void Worker::doCleanupTask(int modType, const QString& inputPath, const QString& outputPath, const QString& vanillaPath)
 {
-    m_cancelRequested.store(false);
+    m_cancel.reset();
     runCleanupProcess(modType, inputPath, outputPath, vanillaPath);
+    // A plan and a key index end with their cleanup, finished or not
+    m_changeSet.reset();
+    m_keyIndex.reset();
 }
 
 // Main logic for creating localisation files based on modType
 void Worker::runCreateProcess(int modType, const QString& inputPath, const QString& outputPath, const QString& vanillaPath)
 {
     QElapsedTimer totalTimerCreate; totalTimerCreate.start();
+    m_metrics.start();
+    m_lastPercent = -1;
+    m_predictRemaining = nullptr;
     emit progressUpdated(0);
     emit statusMessage("Starting localisation creation...");
 
-    // Define constants for the retry mechanism
-    const int MAX_RETRIES = 3; // Try a total of 4 times (1 initial + 3 retries)
-    const int BASE_RETRY_DELAY_MS = 1000; // Start with a 1-second delay
+    const ModDefinition* mod = ModManifest::instance().findByType(modType);
+    if (!mod) {
+        emit logMessage(QString("ERROR: No mod with modType %1 in the mod manifest (%2).").arg(modType).arg(ModManifest::instance().source()));
+        emit taskFinished(false, "Unknown mod type.");
+        return;
+    }
 
-    // Clear Output folder before starting
-    emit logMessage("INFO: Clearing contents of Output folder: " + outputPath);
-    QDir outputDir(outputPath);
-    if (!outputDir.exists()) {
-        if (!outputDir.mkpath(".")) {
-            emit logMessage("ERROR: Could not create Output folder at: " + outputPath);
-            emit taskFinished(false, "Failed to prepare output directory.");
-            return;
+    // Filled while the category files are written
+    m_coverage.reset();
+    m_keyConflicts.reset();
+    if (!m_reportDir.isEmpty()) {
+        m_coverage = std::make_shared<CoverageReport>(mod->languages);
+        m_keyConflicts = std::make_shared<KeyConflicts>();
+    }
+    const QString reportDir = m_reportDir.isEmpty() ? QString() : QDir(m_reportDir).filePath(mod->id);
+    // Keys added, removed and changed since the previous run, written next to the log
+    m_keyDiff.reset();
+    m_previousOutputDir.clear();
+    m_keyDiffSkipped.clear();
+    if (!m_keyDiffDir.isEmpty() && !m_planMode) m_keyDiff = std::make_shared<KeyDiffReport>();
+    // Sources of every key; the cleanup adds the files and saves it
+    m_keyIndex.reset();
+    m_previousKeyIndex.reset();
+    if (!m_planMode) {
+        m_keyIndex = std::make_shared<KeyIndex>();
+        // Sheets the delta export does not fetch keep their sources from the last index
+        const QString indexPath = KeyIndex::pathFor(m_sheetCacheDir, mod->id);
+        auto previous = std::make_shared<KeyIndex>();
+        if (previous->load(indexPath)) {
+            m_previousKeyIndex = previous;
+            m_previousKeyIndexTime = QFileInfo(indexPath).lastModified();
+        }
+    }
+    const QString keyDiffPath = QDir(m_keyDiffDir).filePath(QString("key_diff_%1_%2").arg(mod->id)
+        .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss")));
+
+    // Clear Output folder before starting; a plan compares with it instead and the cleanup writes the change set
+    m_changeSet.reset();
+    if (m_planMode) {
+        m_changeSet = std::make_shared<ChangeSet>(outputPath);
+        emit logMessage("INFO: Plan mode — " + outputPath + " is left untouched.");
+    }
+    else {
+        emit logMessage("INFO: Clearing contents of Output folder: " + outputPath);
+        QDir outputDir(outputPath);
+        if (!outputDir.exists()) {
+            if (!outputDir.mkpath(".")) {
+                emit logMessage("ERROR: Could not create Output folder at: " + outputPath);
+                emit taskFinished(false, "Failed to prepare output directory.");
+                return;
+            }
         }
+        if (m_deltaExport) {
+            // Generated category files stay; the delta export rewrites only those whose entries changed
+            clearOutputExceptCategoryFiles(outputPath, modFileNames(*mod));
+        }
+        else {
+            // The key diff reads the previous category files; a full export would delete them, so they are moved aside
+            if (m_keyDiff) {
+                m_previousOutputDir = QDir(QFileInfo(m_sheetCacheDir).path()).filePath("previous/" + mod->id);
+                QDir(m_previousOutputDir).removeRecursively();
+                for (const QString& target : moveCategoryFiles(outputPath, modFileNames(*mod), m_previousOutputDir)) {
+                    emit logMessage("WARNING: Could not move the previous " + QFileInfo(target).fileName() + " to " + m_previousOutputDir
+                        + "; it is left out of the key diff.");
+                    m_keyDiffSkipped.insert(target);
+                }
+            }
+            outputDir.removeRecursively();
+            outputDir.mkpath(".");
+        }
+        emit logMessage("INFO: " + outputPath + " folder contents cleared.");
     }
-    outputDir.removeRecursively();
-    outputDir.mkpath(".");
-    emit logMessage("INFO: " + outputPath + " folder contents cleared.");
 
-    // Progress calibration across phases
-    const int PREP_PROGRESS = 5;          // after setup
-    const int API_PROGRESS_RANGE = 90;    // main API work spans 5..95
+    // Progress: every category is worth CATEGORY_WORK units, half for its download (by bytes received) and half once written
+    const qint64 CATEGORY_WORK = 1000;
     const int FINALIZE_PROGRESS = 100;    // final step sets to 100
-    emit progressUpdated(PREP_PROGRESS);
 
     // Prepare file name mappings for each mod type
-    std::vector<std::pair<QString, QString>> filenames;
-    QString modName = "STNH";
-    emit logMessage("INFO: Selected STNH Localisation");
-    filenames = {
-        { "Main Localisation", "STH_main_l_<lang>.yml" },
-        { "Ships Localisation", "STH_ships_l_<lang>.yml" },
-        { "Modifiers Localisation", "STH_modifiers_l_<lang>.yml" },
-        { "Events Localisation", "STH_events_l_<lang>.yml" },
-        { "Tech Localisation", "STH_tech_l_<lang>.yml" },
-        { "Synced Localisation", "STH_synced_l_<lang>.yml" }
-    };
+    const std::vector<std::pair<QString, QString>> filenames = modFileNames(*mod);
+    emit logMessage("INFO: Selected " + mod->name + " Localisation");
 
-    // Map filenames to their corresponding API data (targetSheets intentionally left empty; must be provided by user selection)
-    QMap<QString, ApiData> apiMappings;
-    apiMappings["Main Localisation"] = {
-        "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec",
-        "1jQOrWJpAF_9TQVyrrOfxinyTTxvoDJg_E7BHUNEkoio",
-        QJsonArray()
-    };
-    apiMappings["Ships Localisation"] = {
-        "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec",
-        "19z068O5ARdrXLyswqTeDqcQdhAwA39kI8Gx_nhZPL3I",
-        QJsonArray()
-    };
-    apiMappings["Modifiers Localisation"] = {
-        "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec",
-        "1TZylnt8An15CLYlQmy1tjUYvHgMQoosh_x1jC35HOck",
-        QJsonArray()
-    };
-    apiMappings["Events Localisation"] = {
-        "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec",
-        "1YNdrUt0Ro1w6aiVZR0uSJnnulpzhh4thvy3K1-fJ_qA",
-        QJsonArray()
-    };
-    apiMappings["Tech Localisation"] = {
-        "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec",
-        "15QcA1M4dX455UYD2GEv3tDJ3P4z3jhK7p5qPMTDFS60",
-        QJsonArray()
-    };
-    apiMappings["Synced Localisation"] = {
-        "https://script.google.com/macros/s/AKfycbzAfQroJ3X4vCkn3NCwDy4WqRdgQs_lLpZ-QmOMsUQZ_lo_Lu8ddnbgoaiiGN6U3Nxk_w/exec",
-        "1MgcmiOr8OMqD6qo5EMwk3ymVenSqAS8MWdo33hKjIPk",
-        QJsonArray()
-    };
+    QMap<QString, ApiData> apiMappings = modApiMappings(*mod, m_compactExport);
 
     // Require user-provided selections; error out if none
     if (m_selectionsJson.trimmed().isEmpty()) {
@@ -144,25 +634,11 @@ void Worker::runCreateProcess(int modType, const QString& inputPath, const QStri
         return;
     }
 
-    QJsonDocument selDoc = QJsonDocument::fromJson(m_selectionsJson.toUtf8());
-    if (!selDoc.isObject()) {
+    if (!applySelections(m_selectionsJson, apiMappings)) {
         emit statusMessage("Invalid selections data. Please reselect sheets.");
         emit taskFinished(false, "Invalid selections JSON.");
         return;
     }
-    {
-        QJsonObject selObj = selDoc.object();
-        for (auto it = selObj.begin(); it != selObj.end(); ++it) {
-            if (!it.value().isArray()) continue;
-            const QString category = it.key();
-            if (apiMappings.contains(category)) {
-                QJsonArray ids = it.value().toArray();
-                if (!ids.isEmpty()) {
-                    apiMappings[category].targetSheets = ids;
-                }
-            }
-        }
-    }
     // Log selection summary
     {
         QStringList catSummaries;
@@ -194,8 +670,45 @@ void Worker::runCreateProcess(int modType, const QString& inputPath, const QStri
     bool* overallSuccess = new bool(true);
     QMap<QString, QString>* fileStatus = new QMap<QString, QString>();
     int* totalRetries = new int(0);
+    auto hedges = std::make_shared<HedgeStats>();
+    auto transfer = std::make_shared<TransferStats>();
+    auto makespan = std::make_shared<MakespanStats>();
     int* totalFilesSucceeded = new int(0);
     int* totalFilesFailed = new int(0);
+    auto plans = std::make_shared<QMap<QString, CategoryPlan>>();
+    auto categoryWork = std::make_shared<QHash<QString, qint64>>(); // category -> units credited so far
+    m_metrics.counters().workTotal = CATEGORY_WORK * static_cast<qint64>(filenames.size());
+    m_metrics.counters().itemsQueued = static_cast<int>(filenames.size());
+
+    // Time left from earlier runs: categories are fetched concurrently, so the run ends with the slowest one
+    const QString modId = mod->id;
+    m_history.load();
+    auto expectedFinish = std::make_shared<QHash<QString, qint64>>(); // pending category -> ms after the start, -1 if unknown
+    qint64 expectedTotal = 0;
+    for (const auto& filePair : filenames) {
+        const RunHistory::Sample sample = m_history.fetch(modId, filePair.first);
+        const qint64 finish = sample.runs > 0 ? qRound64(sample.ms) : -1;
+        expectedFinish->insert(filePair.first, finish);
+        expectedTotal = (finish < 0 || expectedTotal < 0) ? -1 : qMax(expectedTotal, finish);
+    }
+    if (expectedTotal >= 0) emit logMessage("INFO: Earlier runs suggest about " + WorkerMetrics::formatDuration(expectedTotal) + " for this step.");
+    m_predictRemaining = [expectedFinish](qint64 elapsedMs) -> qint64 {
+        qint64 finish = 0;
+        for (qint64 expected : *expectedFinish) {
+            if (expected < 0) return -1;
+            finish = qMax(finish, expected);
+        }
+        return qMax<qint64>(0, finish - elapsedMs);
+        };
+    publishMetrics(true);
+
+    // Raises a category's credited progress to units (never lowers it, so a retry does not move the bar back)
+    auto creditCategory = [this, categoryWork](const QString& category, qint64 units) {
+        qint64& credited = (*categoryWork)[category];
+        if (units <= credited) return;
+        m_metrics.counters().workDone += units - credited;
+        credited = units;
+        };
 
     auto updateStatusMessage = [this, fileStatus]() {
         QMap<QString, int> statusCounts;
@@ -212,18 +725,80 @@ void Worker::runCreateProcess(int modType, const QString& inputPath, const QStri
         emit processActive(processingCount > 0);
         };
 
-    auto finalizeRequest = [=]() {
+    auto finalizeRequest = [=](const QString& category) {
         (*activeRequests)--;
-        int completed = (int)filenames.size() - *activeRequests;
-        int scaled = PREP_PROGRESS + (completed * API_PROGRESS_RANGE) / (int)filenames.size();
-        if (scaled > 95) scaled = 95; // cap before finalization
-        emit progressUpdated(scaled);
+        creditCategory(category, CATEGORY_WORK);
+        expectedFinish->remove(category);
+        m_metrics.counters().itemsQueued = *activeRequests;
+        publishMetrics(*activeRequests == 0);
 
         if (*activeRequests == 0) {
             emit logMessage("INFO: All API requests have been processed.");
-            if (m_cancelRequested.load()) {
+            if (m_coverage && !m_cancel.isCancelled()) {
+                QString reportError;
+                if (m_coverage->write(reportDir, &reportError)) {
+                    for (const QString& line : m_coverage->summaryLines()) emit logMessage("INFO: Coverage " + line);
+                    emit logMessage("INFO: Coverage report written to " + reportDir);
+                }
+                else {
+                    emit logMessage("WARNING: " + reportError);
+                }
+            }
+            if (m_keyConflicts && !m_cancel.isCancelled()) {
+                // Against vanilla: the cleanup step that follows reuses the parsed files
+                if (!vanillaPath.isEmpty() && QDir(vanillaPath).exists()) {
+                    VanillaIndex& index = vanillaIndex(vanillaPath);
+                    index.scan(m_keyConflicts->languages(), &m_cancel);
+                    for (const QString& lang : m_keyConflicts->languages()) {
+                        if (const std::vector<VanillaIndex::File>* files = index.language(lang, &m_cancel)) m_keyConflicts->checkVanilla(lang, *files);
+                    }
+                }
+                QString reportError;
+                if (m_keyConflicts->write(reportDir, &reportError)) {
+                    emit logMessage(QString("%1: Keys defined twice: %2 conflicting, %3 identical; vanilla keys overridden: %4 (%5 with the same text). See %6/key_conflicts.csv")
+                        .arg(m_keyConflicts->count(KeyConflicts::Conflict) > 0 ? "WARNING" : "INFO")
+                        .arg(m_keyConflicts->count(KeyConflicts::Conflict)).arg(m_keyConflicts->count(KeyConflicts::Duplicate))
+                        .arg(m_keyConflicts->count(KeyConflicts::VanillaOverride) + m_keyConflicts->count(KeyConflicts::VanillaSame))
+                        .arg(m_keyConflicts->count(KeyConflicts::VanillaSame)).arg(reportDir));
+                }
+                else {
+                    emit logMessage("WARNING: " + reportError);
+                }
+            }
+            if (m_keyDiff && !m_cancel.isCancelled()) {
+                const KeyDiffReport::Totals totals = m_keyDiff->totals();
+                QString reportError;
+                if (m_keyDiff->write(keyDiffPath, &reportError)) {
+                    emit logMessage(QString("INFO: Keys since the previous run: %1 added, %2 removed, %3 changed, %4 unchanged. See %5.csv")
+                        .arg(totals.added).arg(totals.removed).arg(totals.changed).arg(totals.unchanged).arg(keyDiffPath));
+                }
+                else {
+                    emit logMessage("WARNING: " + reportError);
+                }
+            }
+            if (!m_previousOutputDir.isEmpty()) {
+                QDir(m_previousOutputDir).removeRecursively();
+                m_previousOutputDir.clear();
+            }
+            m_coverage.reset();
+            m_keyConflicts.reset();
+            m_keyDiff.reset();
+            m_previousKeyIndex.reset();
+            m_predictRemaining = nullptr;
+            // A plan's timings are not those of a real run
+            if (!m_cancel.isCancelled() && !m_changeSet) {
+                QString historyError;
+                if (!m_history.save(&historyError)) emit logMessage("WARNING: Run history not saved: " + historyError);
+            }
+            // The cleanup finishes a plan only after a successful create
+            if (m_cancel.isCancelled() || !*overallSuccess) {
+                m_changeSet.reset();
+                m_keyIndex.reset();
+            }
+            if (m_cancel.isCancelled()) {
+                logCancelled("the create step");
                 emit statusMessage("Cancelled by user.");
-                emit taskFinished(false, "Operation cancelled.");
+                emit taskFinished(false, "Operation cancelled.", true);
             }
             else if (*overallSuccess) {
                 emit statusMessage("Task finished successfully!");
@@ -235,8 +810,18 @@ void Worker::runCreateProcess(int modType, const QString& inputPath, const QStri
                 emit progressUpdated(FINALIZE_PROGRESS);
                 emit taskFinished(false, "Localisation creation finished with some errors.");
             }
-            emit logMessage(QString("SUMMARY: Create process duration: %1 ms; files ok: %2, failed: %3, retries: %4")
-                .arg(totalTimerCreate.elapsed()).arg(*totalFilesSucceeded).arg(*totalFilesFailed).arg(*totalRetries));
+            QString makespanNote;
+            if (makespan->requests > 0) {
+                makespanNote = makespan->expectedMs >= 0
+                    ? QString("; request makespan: %1 ms (expected %2 ms)").arg(makespan->actualMs).arg(makespan->expectedMs)
+                    : QString("; request makespan: %1 ms (no estimate yet)").arg(makespan->actualMs);
+            }
+            emit logMessage(QString("SUMMARY: Create process duration: %1 ms; files ok: %2, failed: %3, retries: %4%5%6%7")
+                .arg(totalTimerCreate.elapsed()).arg(*totalFilesSucceeded).arg(*totalFilesFailed).arg(*totalRetries)
+                .arg(m_hedgeBudget > 0 ? QString("; hedged requests: %1 sent, %2 won").arg(hedges->sent).arg(hedges->won) : QString())
+                .arg(transfer->decoded > 0 ? QString("; exports: %1 KB transferred, %2 KB decoded")
+                    .arg(transfer->transferred / 1024.0, 0, 'f', 1).arg(transfer->decoded / 1024.0, 0, 'f', 1) : QString())
+                .arg(makespanNote));
             delete activeRequests;
             delete overallSuccess;
             delete fileStatus;
@@ -246,264 +831,934 @@ void Worker::runCreateProcess(int modType, const QString& inputPath, const QStri
         }
         };
 
-    std::function<void(const std::pair<QString, QString>&, const ApiData&, int)> performApiRequest;
-    performApiRequest = [=, &performApiRequest](const std::pair<QString, QString>& filePair, const ApiData& apiData, int attemptNum) {
+    // Writes a category's files and books the outcome
+    // fetchedNow: the payload was requested by this run, so its timing goes into the history
+    auto processCategory = [=](const std::pair<QString, QString>& filePair, const QByteArray* payload, bool fetchedNow) {
         const QString& currentFileName = filePair.first;
-        QElapsedTimer* requestTimer = new QElapsedTimer();
-        requestTimer->start();
+        (*fileStatus)[currentFileName] = "Processing";
+        updateStatusMessage();
+        if (payload) {
+            emit logMessage(QString("INFO: %1 export payload: %2 KB (%3)").arg(currentFileName)
+                .arg(payload->size() / 1024.0, 0, 'f', 1)
+                .arg(mod->languageSet.isEmpty() ? QString("all languages") : QString("%1 languages").arg(mod->languageSet.size())));
+        }
+        if (writeCategoryFiles(*mod, currentFileName, filePair.second, outputPath, plans->value(currentFileName), payload)) {
+            // Only fetched categories say something about the next fetch
+            if (payload && fetchedNow) m_history.recordFetch(modId, currentFileName, totalTimerCreate.elapsed(), payload->size());
+            (*fileStatus)[currentFileName] = "Completed";
+            emit logMessage("INFO: Successfully processed " + currentFileName);
+            (*totalFilesSucceeded)++;
+        }
+        else {
+            (*fileStatus)[currentFileName] = "Failed";
+            *overallSuccess = false;
+            (*totalFilesFailed)++;
+        }
+        };
 
-        QJsonObject jsonSettings;
-        jsonSettings["exportType"] = "jsonFormat";
-        jsonSettings["spreadsheetId"] = apiData.spreadsheetId;
-        jsonSettings["exportSheets"] = "custom";
-        jsonSettings["targetSheets"] = apiData.targetSheets;
-        jsonSettings["minifyData"] = false;
-        jsonSettings["exportBoolsAsInts"] = false;
-        jsonSettings["ignoreEmptyCells"] = true;
-        jsonSettings["includeFirstColumn"] = false;
-        jsonSettings["nestedElements"] = false;
-        jsonSettings["unwrapSingleRows"] = false;
-        jsonSettings["collapseSingleRows"] = false;
-        jsonSettings["ignoreColumnsWithPrefix"] = true;
-        jsonSettings["ignorePrefix"] = "NOEX_";
-        jsonSettings["unwrapSheetsWithPrefix"] = false;
-        jsonSettings["unwrapPrefix"] = "US_";
-        jsonSettings["collapseSheetsWithPrefix"] = false;
-        jsonSettings["collapsePrefix"] = "CS_";
-        QJsonObject jsonSubSettings;
-        jsonSubSettings["forceString"] = false;
-        jsonSubSettings["exportCellArray"] = false;
-        jsonSubSettings["exportSheetArray"] = true;
-        jsonSubSettings["exportValueArray"] = false;
-        QJsonObject advancedSubSettings;
-        advancedSubSettings["exportContentsAsArray"] = false;
-        advancedSubSettings["exportCellObject"] = false;
-        advancedSubSettings["emptyValueFormat"] = "null";
-        advancedSubSettings["nullValueFormat"] = "null";
-        advancedSubSettings["separatorChar"] = ",";
-        advancedSubSettings["forceArray"] = false;
-        advancedSubSettings["forceArrayPrefix"] = "JA_";
-        advancedSubSettings["forceArrayNest"] = false;
-        advancedSubSettings["forceNestedArrayPrefix"] = "NA_";
-        jsonSubSettings["advanced"] = advancedSubSettings;
-        jsonSettings["json"] = jsonSubSettings;
+    // Held through shared ownership: retries fire from timers long after this function has returned
+    using RequestFn = std::function<void(const std::pair<QString, QString>&, const ApiData&, int)>;
+    auto performApiRequest = std::make_shared<RequestFn>();
+    std::weak_ptr<RequestFn> weakPerformApiRequest = performApiRequest;
+    *performApiRequest = [=](const std::pair<QString, QString>& filePair, const ApiData& apiData, int attemptNum) {
+        // In-flight replies and pending retries keep the function alive
+        std::shared_ptr<RequestFn> self = weakPerformApiRequest.lock();
+        const QString currentFileName = filePair.first;
+        // The scheduler starts the attempt once its concurrency window has room
+        m_scheduler.submit(modId + "/" + currentFileName, [=](const RequestScheduler::Ticket& ticket) {
+            if (m_cancel.isCancelled()) {
+                m_scheduler.finish(ticket, RequestScheduler::Rejected);
+                emit logMessage(QString("INFO: Cancellation active, not requesting %1.").arg(currentFileName));
+                (*fileStatus)[currentFileName] = "Failed";
+                *overallSuccess = false;
+                updateStatusMessage();
+                finalizeRequest(currentFileName);
+                return;
+            }
+            QElapsedTimer requestTimer;
+            requestTimer.start();
+            const QUrl url = buildExportUrl(apiData);
+            const qint64 expectedBytes = qRound64(m_history.fetch(modId, currentFileName).bytes);
+            // The replies of this attempt: the request and, once it runs past the category's p90, a hedge
+            auto attempt = std::make_shared<ExportAttempt>();
+            hedges->primaries++;
+
+            // Every reply of the attempt ends here; the first usable one settles the attempt and aborts the other
+            auto onReplyFinished = [=](QNetworkReply* reply) {
+                {
+                    QMutexLocker locker(&m_mutex);
+                    m_activeReplies.removeAll(reply);
+                }
+                reply->deleteLater();
+                attempt->replies.removeAll(reply);
+                if (reply == attempt->hedge) m_scheduler.releaseExtra();
+                if (attempt->settled) return; // the aborted loser of a hedged attempt
+                if (reply->error() != QNetworkReply::NoError && !attempt->replies.isEmpty()) return; // the other copy may still succeed
+                attempt->settled = true;
+                makespan->actualMs = makespan->clock.elapsed();
+                const QList<QNetworkReply*> losers = attempt->replies;
+                for (QNetworkReply* loser : losers) loser->abort();
+                if (reply == attempt->hedge && reply->error() == QNetworkReply::NoError) {
+                    hedges->won++;
+                    emit logMessage(QString("INFO: Hedged request for %1 finished first.").arg(currentFileName));
+                }
 
-        QJsonDocument jsonDoc(jsonSettings);
-        QByteArray encodedPayload = QUrl::toPercentEncoding(jsonDoc.toJson(QJsonDocument::Compact));
-        QUrlQuery urlQuery;
-        urlQuery.addQueryItem("settings", encodedPayload);
-        QUrl url(apiData.webAppUrl);
-        url.setQuery(urlQuery);
-        QNetworkRequest request(url);
-        QNetworkReply* reply = networkManager->get(request);
+                bool requestHandled = false;
+                const RequestScheduler::Outcome outcome = RequestScheduler::classify(reply, attempt->timedOut);
+                const int slotsBefore = static_cast<int>(m_scheduler.window());
+                m_scheduler.finish(ticket, outcome);
+                if (static_cast<int>(m_scheduler.window()) != slotsBefore) {
+                    emit logMessage(QString("DEBUG: Concurrent requests %1 -> %2 after %3")
+                        .arg(slotsBefore).arg(static_cast<int>(m_scheduler.window()))
+                        .arg(outcome == RequestScheduler::Completed ? "a slow reply for " + currentFileName : "a failed request for " + currentFileName));
+                }
+
+                if (outcome == RequestScheduler::Completed) {
+                    emit logMessage("INFO: Received response for: " + currentFileName);
+                    m_history.recordRequest(modId, currentFileName, requestTimer.elapsed());
+                    const QByteArray responseData = reply->readAll();
+                    const qint64 transferred = attempt->received.value(reply, responseData.size());
+                    transfer->transferred += transferred;
+                    transfer->decoded += responseData.size();
+                    emit logMessage(QString("DEBUG: %1 export: %2 KB transferred, %3 KB decoded")
+                        .arg(currentFileName).arg(transferred / 1024.0, 0, 'f', 1).arg(responseData.size() / 1024.0, 0, 'f', 1));
+                    processCategory(filePair, &responseData, true);
+                    requestHandled = true;
+                }
+                else {
+                    const RequestScheduler::Settings& limits = m_scheduler.settings();
+                    const QString reason = attempt->timedOut ? QString("no reply within %1 s").arg(limits.attemptTimeoutMs / 1000) : reply->errorString();
+                    emit logMessage(QString("ERROR: Network request failed for %1 (Attempt %2/%3): %4")
+                        .arg(currentFileName).arg(attemptNum + 1).arg(limits.maxRetries + 1).arg(reason));
+
+                    if (!m_cancel.isCancelled() && outcome != RequestScheduler::Rejected && attemptNum < limits.maxRetries) {
+                        const qint64 retryAfter = RequestScheduler::retryAfterMs(reply);
+                        const int delay = m_scheduler.retryDelayMs(attemptNum, retryAfter);
+                        emit logMessage(retryAfter >= 0 ? QString("INFO: Retrying in %1ms (Retry-After %2 s)...").arg(delay).arg(retryAfter / 1000)
+                            : QString("INFO: Retrying in %1ms...").arg(delay));
+                        m_metrics.counters().requestsWaiting++;
+                        // Tracked so a cancel can end the wait at once instead of after the backoff
+                        QTimer* retryTimer = new QTimer(this);
+                        retryTimer->setSingleShot(true);
+                        m_retryTimers.append(retryTimer);
+                        connect(retryTimer, &QTimer::timeout, this, [=]() {
+                            m_retryTimers.removeAll(retryTimer);
+                            retryTimer->deleteLater();
+                            m_metrics.counters().requestsWaiting--;
+                            if (!m_cancel.isCancelled()) (*totalRetries)++;
+                            // After a cancel the scheduler callback sees the token and finalizes the file as failed
+                            (*self)(filePair, apiData, attemptNum + 1);
+                            });
+                        retryTimer->start(delay);
+                    }
+                    else {
+                        if (m_cancel.isCancelled()) {
+                            emit logMessage(QString("INFO: Cancellation active, not retrying %1.").arg(currentFileName));
+                        }
+                        else if (outcome == RequestScheduler::Rejected) {
+                            emit logMessage(QString("WARNING: %1 was rejected by the server; not retrying. This file has failed.").arg(currentFileName));
+                        }
+                        else {
+                            emit logMessage(QString("WARNING: Maximum retries reached for %1. This file has failed.").arg(currentFileName));
+                        }
+                        (*fileStatus)[currentFileName] = "Failed";
+                        *overallSuccess = false;
+                        requestHandled = true;
+                    }
+                }
+
+                emit logMessage(QString("DEBUG: API request for '%1' took %2 ms").arg(currentFileName).arg(requestTimer.elapsed()));
+                updateStatusMessage();
+                if (requestHandled) {
+                    finalizeRequest(currentFileName);
+                }
+                };
+
+            auto startReply = [=]() {
+                QNetworkReply* reply = networkManager->get(QNetworkRequest(url));
+                {
+                    QMutexLocker locker(&m_mutex);
+                    m_activeReplies.append(reply);
+                }
+                attempt->replies.append(reply);
+                trackDownload(reply, [=](qint64 received, qint64 total) {
+                    attempt->received.insert(reply, received);
+                    if (total <= 0) total = expectedBytes; // streamed replies carry no length: expect the size of earlier payloads
+                    if (total > 0) creditCategory(currentFileName, (CATEGORY_WORK / 2) * qMin(received, total) / total);
+                    });
+                connect(reply, &QNetworkReply::finished, this, [=]() { onReplyFinished(reply); });
+                return reply;
+                };
+            startReply();
+
+            // Per-attempt deadline, for the hedge too
+            QTimer::singleShot(m_scheduler.settings().attemptTimeoutMs, this, [=]() {
+                if (attempt->settled) return;
+                attempt->timedOut = true;
+                const QList<QNetworkReply*> running = attempt->replies;
+                for (QNetworkReply* reply : running) reply->abort();
+                });
+
+            // Hedge: a straggler past the category's usual p90 gets a second copy, within the hedging budget
+            const qint64 hedgeAfterMs = m_hedgeBudget > 0 ? m_history.requestPercentileMs(modId, currentFileName, 0.9) : -1;
+            if (hedgeAfterMs >= 0 && hedgeAfterMs < m_scheduler.settings().attemptTimeoutMs) {
+                QTimer::singleShot(hedgeAfterMs, this, [=]() {
+                    if (attempt->settled || m_cancel.isCancelled()) return;
+                    const int allowed = std::max(1, static_cast<int>(hedges->primaries * m_hedgeBudget));
+                    if (hedges->sent >= allowed) return;
+                    // The hedge counts against the concurrency window; with no room it would only add to the congestion
+                    if (!m_scheduler.acquireExtra()) {
+                        emit logMessage(QString("DEBUG: Not hedging %1, no room in the request window.").arg(currentFileName));
+                        return;
+                    }
+                    hedges->sent++;
+                    emit logMessage(QString("INFO: %1 is slower than usual (%2 ms), sending a hedged request.").arg(currentFileName).arg(hedgeAfterMs));
+                    attempt->hedge = startReply();
+                    });
+            }
+            });
+        };
+
+    // Expected latency of a category's export request from earlier runs, scaled to the share of sheets a delta
+    // plan fetches; 0 if nothing is fetched, -1 without recorded latencies
+    auto expectedRequestMs = [=](const QString& category) -> qint64 {
+        const ApiData apiData = apiMappings.value(category);
+        if (apiData.targetSheets.isEmpty()) return 0;
+        const CategoryPlan plan = plans->value(category);
+        if (plan.delta && plan.fetchSheets.isEmpty()) return 0;
+        const qint64 ms = m_history.typicalRequestMs(modId, category);
+        if (ms < 0 || !plan.delta || plan.selected.isEmpty()) return ms;
+        return ms * plan.fetchSheets.size() / plan.selected.size();
+        };
+
+    // 2. QUEUE THE EXPORT REQUESTS WITH THE SCHEDULER (only changed sheets when the plan allows it)
+    auto launchRequests = [=]() {
+        // Longest first: with a capped window, a slow category queued last would set the makespan.
+        // Categories without history go first, they may well be the slow ones.
+        std::vector<std::pair<QString, QString>> order = filenames;
+        QHash<QString, qint64> costs;
+        for (const auto& filePair : order) costs.insert(filePair.first, expectedRequestMs(filePair.first));
+        std::stable_sort(order.begin(), order.end(), [&costs](const auto& a, const auto& b) {
+            const qint64 ca = costs.value(a.first);
+            const qint64 cb = costs.value(b.first);
+            if ((ca < 0) != (cb < 0)) return ca < 0;
+            return ca > cb;
+            });
+        std::vector<qint64> orderedCosts;
+        bool allKnown = true;
+        for (const auto& filePair : order) {
+            const qint64 cost = costs.value(filePair.first);
+            if (cost < 0) allKnown = false;
+            else if (cost > 0) orderedCosts.push_back(cost);
+        }
+        makespan->expectedMs = allKnown ? RequestScheduler::makespanMs(orderedCosts, static_cast<int>(m_scheduler.window())) : -1;
+        makespan->clock.start();
+        QStringList orderNote;
+        for (const auto& filePair : order) {
+            const qint64 cost = costs.value(filePair.first);
+            orderNote << QString("%1 (%2)").arg(filePair.first, cost < 0 ? QString("?") : QString::number(cost) + " ms");
+        }
+        emit logMessage("DEBUG: Request order, longest first: " + orderNote.join(", "));
+
+        for (const auto& filePair : order) {
+            const QString& currentFileName = filePair.first;
+
+            if (!apiMappings.contains(currentFileName)) {
+                emit logMessage("ERROR: No API mapping found for file: " + currentFileName);
+                (*fileStatus)[currentFileName] = "Failed";
+                *overallSuccess = false;
+                finalizeRequest(currentFileName);
+                continue;
+            }
+
+            if (m_cancel.isCancelled()) {
+                (*fileStatus)[currentFileName] = "Failed";
+                *overallSuccess = false;
+                finalizeRequest(currentFileName);
+                continue;
+            }
+
+            ApiData apiData = apiMappings.value(currentFileName);
+            if (!plans->contains(currentFileName)) {
+                CategoryPlan fullExport;
+                fullExport.spreadsheetId = apiData.spreadsheetId;
+                plans->insert(currentFileName, fullExport);
+            }
+            const CategoryPlan plan = plans->value(currentFileName);
+            if (plan.delta && plan.fetchSheets.isEmpty()) {
+                emit logMessage("INFO: No sheet changes for " + currentFileName + " — using cached sheet data.");
+                processCategory(filePair, nullptr, false);
+                finalizeRequest(currentFileName);
+                continue;
+            }
+            // A prefetch covers the whole selection, a superset of what a delta plan fetches
+            std::shared_ptr<PrefetchedExport> prefetched = m_prefetched.take(buildExportUrl(apiData).toString());
+            if (plan.delta) apiData.targetSheets = plan.fetchSheets;
+
+            auto fetch = [=]() {
+                makespan->requests++;
+                emit logMessage(QString("INFO: Starting API request for: %1 (%2 sheets)").arg(currentFileName).arg(apiData.targetSheets.size()));
+                (*fileStatus)[currentFileName] = "Fetching";
+                (*performApiRequest)(filePair, apiData, 0);
+                };
+            // Uses the prefetched payload if it is fresh and, for a delta plan, no fetched sheet changed since
+            auto usePrefetched = [=]() {
+                const qint64 ageMs = QDateTime::currentMSecsSinceEpoch() - prefetched->fetchedAtMs;
+                if (prefetched->failed || ageMs > m_prefetchMaxAgeSec * 1000LL) return false;
+                for (const QJsonValue& idValue : plan.fetchSheets) {
+                    const qint64 id = idValue.toVariant().toLongLong();
+                    if (prefetched->revisions.value(id).isEmpty() || prefetched->revisions.value(id) != plan.revisions.value(id)) {
+                        emit logMessage("INFO: Sheets of " + currentFileName + " changed after the prefetch — fetching again.");
+                        return false;
+                    }
+                }
+                emit logMessage(QString("INFO: Using the export of %1 prefetched %2 s ago.").arg(currentFileName).arg(ageMs / 1000));
+                processCategory(filePair, &prefetched->payload, false);
+                finalizeRequest(currentFileName);
+                return true;
+                };
+
+            if (prefetched && prefetched->pending) {
+                emit logMessage("INFO: Waiting for the prefetch of " + currentFileName + " already in flight.");
+                (*fileStatus)[currentFileName] = "Fetching";
+                prefetched->waiters.append([=]() {
+                    if (!usePrefetched()) fetch();
+                    updateStatusMessage();
+                    });
+                continue;
+            }
+            if (prefetched && usePrefetched()) continue;
+            fetch();
+        }
+        updateStatusMessage();
+        };
+
+    // A plan fetches every selected sheet: the delta export would refresh the sheet cache as it goes
+    if (!m_deltaExport || m_changeSet) {
+        launchRequests();
+        return;
+    }
+
+    // 1. ASK FOR SHEET REVISIONS (one listSheets call per web app) TO PLAN A DELTA EXPORT
+    QMap<QString, QStringList> spreadsheetsByUrl;
+    for (auto it = apiMappings.constBegin(); it != apiMappings.constEnd(); ++it) {
+        if (!it->targetSheets.isEmpty()) spreadsheetsByUrl[it->webAppUrl] << it->spreadsheetId;
+    }
+    int* pendingListings = new int(static_cast<int>(spreadsheetsByUrl.size()));
+    auto listings = std::make_shared<QHash<QString, QJsonArray>>(); // spreadsheetId -> sheets
+    auto planAndLaunch = [=]() {
+        SheetCache cache(m_sheetCacheDir);
+        for (auto it = apiMappings.constBegin(); it != apiMappings.constEnd(); ++it) {
+            if (it->targetSheets.isEmpty()) continue;
+            CategoryPlan plan;
+            plan.spreadsheetId = it->spreadsheetId;
+            auto listing = listings->constFind(it->spreadsheetId);
+            if (listing == listings->constEnd()) {
+                emit logMessage("WARNING: No sheet metadata for " + it.key() + " — exporting all selected sheets.");
+                plans->insert(it.key(), plan);
+                continue;
+            }
+            for (const QJsonValue& sv : listing.value()) {
+                const QJsonObject sheet = sv.toObject();
+                const qint64 id = sheet.value("id").toVariant().toLongLong();
+                plan.names.insert(id, sheet.value("name").toString());
+                plan.revisions.insert(id, sheetRevision(sheet));
+            }
+            plan.manifest = cache.loadManifest(plan.spreadsheetId);
+            // Cached sheets lack languages added to the manifest since, so a changed list refetches them all
+            const bool sameLanguages = plan.manifest.languages == it->languages;
+            if (!sameLanguages && !plan.manifest.revisions.isEmpty()) {
+                emit logMessage("INFO: Exported languages of " + it.key() + " changed — fetching all selected sheets.");
+            }
+            for (const QJsonValue& idValue : it->targetSheets) {
+                const qint64 id = idValue.toVariant().toLongLong();
+                if (!plan.names.contains(id)) {
+                    emit logMessage(QString("WARNING: Selected sheet %1 no longer exists in %2 — skipped.").arg(id).arg(it.key()));
+                    continue;
+                }
+                plan.selected << id;
+                const QString revision = plan.revisions.value(id);
+                if (!sameLanguages || revision.isEmpty() || plan.manifest.revisions.value(id) != revision || !cache.hasSheet(plan.spreadsheetId, id)) {
+                    plan.fetchSheets.append(idValue);
+                }
+            }
+            plan.delta = true;
+            emit logMessage(QString("INFO: %1 — %2 of %3 selected sheets changed since the last run.")
+                .arg(it.key()).arg(plan.fetchSheets.size()).arg(plan.selected.size()));
+            plans->insert(it.key(), plan);
+        }
+        launchRequests();
+        };
+
+    if (spreadsheetsByUrl.isEmpty()) {
+        delete pendingListings;
+        planAndLaunch();
+        return;
+    }
+    emit statusMessage("Checking sheet revisions...");
+    emit fetchActive(true);
+    for (auto it = spreadsheetsByUrl.constBegin(); it != spreadsheetsByUrl.constEnd(); ++it) {
+        QNetworkReply* reply = networkManager->get(QNetworkRequest(buildListSheetsUrl(it.key(), it.value())));
         {
             QMutexLocker locker(&m_mutex);
             m_activeReplies.append(reply);
         }
+        trackDownload(reply);
+        connect(reply, &QNetworkReply::finished, this, [=]() {
+            {
+                QMutexLocker locker(&m_mutex);
+                m_activeReplies.removeAll(reply);
+            }
+            if (reply->error() == QNetworkReply::NoError) {
+                const QJsonArray spreadsheets = QJsonDocument::fromJson(reply->readAll()).object().value("spreadsheets").toArray();
+                for (const QJsonValue& v : spreadsheets) {
+                    const QJsonObject sObj = v.toObject();
+                    listings->insert(sObj.value("spreadsheetId").toString(), sObj.value("sheets").toArray());
+                }
+            }
+            else {
+                // Not fatal: the affected categories fall back to a full export
+                emit logMessage("WARNING: Could not list sheet revisions: " + reply->errorString());
+            }
+            reply->deleteLater();
+            if (--(*pendingListings) == 0) {
+                delete pendingListings;
+                planAndLaunch();
+            }
+            });
+    }
+}
+
+// Books one sheet's keys with the key conflict report (languages that are never written are left out)
+void Worker::recordKeys(const ModDefinition& mod, const QString& category, const QString& sheet, const QString& filePattern,
+    const std::unordered_map<std::string, std::vector<std::string>>& entries)
+{
+    const uint32_t source = m_keyConflicts ? m_keyConflicts->addSource(category, sheet, filePattern) : 0;
+    const uint32_t indexSource = m_keyIndex ? m_keyIndex->addSource(category, sheet) : 0;
+    for (const auto& entry : entries) {
+        const QString lang = QString::fromStdString(entry.first);
+        if (!mod.writesLanguage(lang)) continue;
+        if (m_keyConflicts) m_keyConflicts->addEntries(source, lang, entry.second);
+        if (m_keyIndex) {
+            for (const std::string& line : entry.second) {
+                const std::string_view key = LocalisationKernels::entryKey(line);
+                if (!key.empty()) m_keyIndex->addSourceKey(indexSource, key);
+            }
+        }
+    }
+}
+
+// The vanilla index for vanillaPath, created again when the path changed
+VanillaIndex& Worker::vanillaIndex(const QString& vanillaPath)
+{
+    if (!m_vanillaIndex || m_vanillaIndex->vanillaPath() != vanillaPath) {
+        m_vanillaIndex = std::make_unique<VanillaIndex>(vanillaPath);
+    }
+    m_vanillaIndex->setFilter(m_vanillaFilter);
+    return *m_vanillaIndex;
+}
+
+void Worker::setVanillaFilter(const QStringList& include, const QStringList& exclude)
+{
+    m_vanillaFilter = VanillaIndex::Filter(include, exclude);
+}
+
+// Adds a category file about to be written (or removed, with no entries) to the key diff. Its previous version
+// is still in Output, unless a full export moved it aside.
+void Worker::diffCategoryFile(const QString& outputPath, const QString& fileTemplate, const QString& lang, const std::vector<std::string>& entries)
+{
+    if (!m_keyDiff) return;
+    const QString previousPath = categoryFilePath(m_previousOutputDir.isEmpty() ? outputPath : m_previousOutputDir, fileTemplate, lang);
+    // Its keys would all count as added
+    if (m_keyDiffSkipped.contains(previousPath)) return;
+    if (entries.empty() && !QFileInfo::exists(previousPath)) return;
+    QString error;
+    if (!m_keyDiff->compare(QString(fileTemplate).replace("<lang>", lang), lang, previousPath, entries, &error)) {
+        emit logMessage("WARNING: " + error);
+    }
+}
+
+// Writes one category's STH files. Without a plan (no sheet metadata) the payload is written as a whole, as before.
+// With a plan the fetched sheets refresh the sheet cache, every selected sheet's entries are merged from fresh and
+// cached data, and only languages whose merged entries changed are rewritten.
+bool Worker::writeCategoryFiles(const ModDefinition& mod, const QString& category, const QString& fileTemplate, const QString& outputPath,
+    const CategoryPlan& plan, const QByteArray* payload)
+{
+    SheetCache cache(m_sheetCacheDir);
+    // The key conflict report and the key index need to know which sheet every key came from
+    const bool attributeKeys = m_keyConflicts || m_keyIndex;
+    // The last key index holds the sources of the cached sheets if it was saved after the cache was written
+    // (a create whose cleanup did not finish leaves an older index behind)
+    const QDateTime cachedAt = cache.manifestTime(plan.spreadsheetId);
+    const KeyIndex* previousIndex = m_keyIndex && m_previousKeyIndex && cachedAt.isValid() && m_previousKeyIndexTime > cachedAt
+        ? m_previousKeyIndex.get() : nullptr;
+
+    if (!plan.delta) {
+        std::unordered_map<std::string, std::vector<std::string>> translations;
+        bool parsed = false;
+        if (payload && attributeKeys) {
+            // Split by sheet so every key is attributed to the sheet it came from
+            QHash<QString, SheetCache::LanguageEntries> bySheet;
+            parsed = parseExportSheets(*payload, mod, bySheet, m_cancel, &m_metrics.counters().rowsParsed);
+            for (auto it = bySheet.begin(); it != bySheet.end(); ++it) {
+                recordKeys(mod, category, it.key(), categoryFilePath(outputPath, fileTemplate, "<lang>"), it.value());
+                for (auto& entry : it.value()) {
+                    std::vector<std::string>& lines = translations[entry.first];
+                    lines.insert(lines.end(), std::make_move_iterator(entry.second.begin()), std::make_move_iterator(entry.second.end()));
+                }
+            }
+        }
+        else if (payload) {
+            parsed = parseExportPayload(*payload, mod, translations, m_cancel, &m_metrics.counters().rowsParsed);
+        }
+        // A cancelled parse has only part of the entries; Output keeps what it had
+        if (m_cancel.isCancelled()) return false;
+        if (!parsed) {
+            emit logMessage("ERROR: Unexpected JSON for " + category + ". Expected a JSON object.");
+            return false;
+        }
+        // A plan leaves the cached sheets as they are
+        if (!plan.spreadsheetId.isEmpty() && !m_changeSet) cache.invalidate(plan.spreadsheetId);
+
+        if (translations.empty()) {
+            emit logMessage("WARNING: No translations received for " + category);
+        }
+        // Every file is replaced atomically, so a cancel between languages leaves each one either old or new
+        bool success = true;
+        QDir outputDir(outputPath);
+        QSet<QString> written;
+        for (auto& entry : translations) {
+            if (m_cancel.isCancelled()) return false;
+            const QString langLower = QString::fromStdString(entry.first).toLower();
+            const QString fullOutputPath = categoryFilePath(outputPath, fileTemplate, langLower);
+            std::vector<std::string>& sortedLines = entry.second;
+            if (!LocalisationKernels::sortLines(sortedLines, m_cancel)) return false;
+            if (m_coverage) m_coverage->addEntries(category, langLower, sortedLines);
+            if (m_changeSet) {
+                // Kept for the cleanup, which reads the mod's keys back from these files
+                m_changeSet->setFile(fullOutputPath, LocalisationKernels::buildYmlFile(langLower, sortedLines), true, true);
+                emit logMessage(QString("INFO: Would write %1 entries to %2").arg(sortedLines.size()).arg(fullOutputPath));
+                continue;
+            }
+            diffCategoryFile(outputPath, fileTemplate, langLower, sortedLines);
+            outputDir.mkpath(langLower);
+            const int entriesWrittenThisLang = LocalisationKernels::writeYmlFile(fullOutputPath, langLower, sortedLines, true);
+            if (entriesWrittenThisLang < 0) {
+                emit logMessage("ERROR: Could not write to file " + fullOutputPath);
+                success = false;
+                continue;
+            }
+            written.insert(langLower);
+            m_metrics.counters().filesWritten++;
+            emit logMessage(QString("INFO: Wrote %1 entries to %2").arg(entriesWrittenThisLang).arg(fullOutputPath));
+        }
+        // Files kept from a delta run may belong to languages the payload no longer has
+        if (m_changeSet) return success;
+        for (const QString& lang : outputDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            if (written.contains(lang)) continue;
+            if (m_previousOutputDir.isEmpty()) diffCategoryFile(outputPath, fileTemplate, lang, {});
+            QFile::remove(categoryFilePath(outputPath, fileTemplate, lang));
+        }
+        // After a full export's clear they are only in the moved-aside copy
+        if (!m_previousOutputDir.isEmpty()) {
+            for (const QString& lang : QDir(m_previousOutputDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+                if (!written.contains(lang)) diffCategoryFile(outputPath, fileTemplate, lang, {});
+            }
+        }
+        return success;
+    }
+
+    SheetCache::Manifest manifest = plan.manifest;
+    const QString absOutputPath = QDir(outputPath).absolutePath();
+    const bool sameOutput = manifest.outputPath == absOutputPath;
+
+    // Nothing fetched, same selection, and every file written last time is still there: nothing to do.
+    // The reports need the entries, so they are read from the cache instead; the key index takes the
+    // category's sources from the last index, or the entries too if that has none.
+    if (!m_coverage && !m_keyConflicts && (!m_keyIndex || previousIndex) && !payload && sameOutput && manifest.selected == plan.selected) {
+        bool allPresent = true;
+        for (auto it = manifest.outputs.constBegin(); it != manifest.outputs.constEnd(); ++it) {
+            if (!QFileInfo::exists(categoryFilePath(outputPath, fileTemplate, it.key()))) { allPresent = false; break; }
+        }
+        if (allPresent && (!m_keyIndex || m_keyIndex->copySources(*previousIndex, category) > 0)) {
+            // The key diff counts the kept files' keys as unchanged
+            for (auto it = manifest.outputs.constBegin(); m_keyDiff && it != manifest.outputs.constEnd(); ++it) {
+                QString error;
+                if (!m_keyDiff->keepFile(QString(fileTemplate).replace("<lang>", it.key()), it.key(),
+                    categoryFilePath(outputPath, fileTemplate, it.key()), &error)) {
+                    emit logMessage("WARNING: " + error);
+                }
+            }
+            emit logMessage(QString("INFO: %1 is up to date — kept %2 files.").arg(category).arg(manifest.outputs.size()));
+            return true;
+        }
+    }
+
+    // Split the fetched payload by sheet and refresh the cached contributions
+    QHash<qint64, SheetCache::LanguageEntries> fresh;
+    if (payload) {
+        QHash<QString, SheetCache::LanguageEntries> bySheet;
+        const bool parsed = parseExportSheets(*payload, mod, bySheet, m_cancel, &m_metrics.counters().rowsParsed);
+        // Partly parsed sheets must not reach the cache
+        if (m_cancel.isCancelled()) return false;
+        if (!parsed) {
+            emit logMessage("ERROR: Unexpected JSON for " + category + ". Expected a JSON object.");
+            return false;
+        }
+        for (const QJsonValue& idValue : plan.fetchSheets) {
+            const qint64 id = idValue.toVariant().toLongLong();
+            // A sheet without rows is left out of the payload; it still contributes (nothing)
+            const SheetCache::LanguageEntries entries = bySheet.value(plan.names.value(id));
+            fresh.insert(id, entries);
+            if (cache.storeSheet(plan.spreadsheetId, id, entries)) {
+                manifest.revisions.insert(id, plan.revisions.value(id));
+                manifest.names.insert(id, plan.names.value(id));
+            }
+            else {
+                emit logMessage(QString("WARNING: Could not cache sheet '%1' of %2; it will be fetched again next run.").arg(plan.names.value(id)).arg(category));
+                manifest.revisions.remove(id);
+            }
+        }
+    }
+
+    // Merge the selected sheets' entries
+    SheetCache::LanguageEntries merged;
+    const QString filePattern = categoryFilePath(outputPath, fileTemplate, "<lang>");
+    for (qint64 id : plan.selected) {
+        if (m_cancel.isCancelled()) return false;
+        auto freshIt = fresh.constFind(id);
+        if (freshIt != fresh.constEnd()) {
+            if (attributeKeys) recordKeys(mod, category, plan.names.value(id), filePattern, freshIt.value());
+            for (const auto& entry : freshIt.value()) {
+                std::vector<std::string>& lines = merged[entry.first];
+                lines.insert(lines.end(), entry.second.begin(), entry.second.end());
+            }
+        }
+        else {
+            // An unchanged sheet's sources come from the last key index when only the index needs them
+            const bool indexed = m_keyIndex && !m_keyConflicts && previousIndex
+                && m_keyIndex->copySources(*previousIndex, category, plan.names.value(id)) > 0;
+            const bool attributeSheet = m_keyConflicts || (m_keyIndex && !indexed);
+            // Loaded apart when its keys have to be attributed to the sheet
+            SheetCache::LanguageEntries cached;
+            if (!cache.loadSheet(plan.spreadsheetId, id, attributeSheet ? cached : merged)) {
+                emit logMessage(QString("ERROR: Cached data of sheet '%1' in %2 is unreadable; the cache was reset, run again to refetch it.")
+                    .arg(plan.names.value(id)).arg(category));
+                cache.invalidate(plan.spreadsheetId);
+                return false;
+            }
+            if (attributeSheet) {
+                recordKeys(mod, category, plan.names.value(id), filePattern, cached);
+                for (auto& entry : cached) {
+                    std::vector<std::string>& lines = merged[entry.first];
+                    lines.insert(lines.end(), std::make_move_iterator(entry.second.begin()), std::make_move_iterator(entry.second.end()));
+                }
+            }
+        }
+    }
+    if (merged.empty()) {
+        emit logMessage("WARNING: No translations received for " + category);
+    }
+
+    // Rewrite only languages whose entries changed
+    bool success = true;
+    int filesWritten = 0;
+    int filesKept = 0;
+    QHash<QString, QByteArray> outputs;
+    QDir outputDir(outputPath);
+    for (auto& entry : merged) {
+        // Stopping here skips the manifest, so the next run rewrites whatever differs from its recorded hashes
+        if (m_cancel.isCancelled()) return false;
+        const QString langLower = QString::fromStdString(entry.first).toLower();
+        // Sheets cached before a language was dropped from the manifest may still have it
+        if (!mod.writesLanguage(langLower)) continue;
+        std::vector<std::string>& sortedLines = entry.second;
+        if (!LocalisationKernels::sortLines(sortedLines, m_cancel)) return false;
+        if (m_coverage) m_coverage->addEntries(category, langLower, sortedLines);
+        const QByteArray hash = SheetCache::entriesHash(sortedLines);
+        const QString fullOutputPath = categoryFilePath(outputPath, fileTemplate, langLower);
+        if (sameOutput && manifest.outputs.value(langLower) == hash && QFileInfo::exists(fullOutputPath)) {
+            outputs.insert(langLower, hash);
+            filesKept++;
+            if (m_keyDiff) m_keyDiff->keep(QString(fileTemplate).replace("<lang>", langLower), langLower, sortedLines);
+            continue;
+        }
+        diffCategoryFile(outputPath, fileTemplate, langLower, sortedLines);
+        outputDir.mkpath(langLower);
+        // Atomic: the file outlives this run, and a half-written one would match no recorded hash
+        const int entriesWrittenThisLang = LocalisationKernels::writeYmlFile(fullOutputPath, langLower, sortedLines, true);
+        if (entriesWrittenThisLang < 0) {
+            emit logMessage("ERROR: Could not write to file " + fullOutputPath);
+            success = false;
+            continue;
+        }
+        outputs.insert(langLower, hash);
+        filesWritten++;
+        m_metrics.counters().filesWritten++;
+        emit logMessage(QString("INFO: Wrote %1 entries to %2").arg(entriesWrittenThisLang).arg(fullOutputPath));
+    }
+    // Languages that lost all their entries
+    for (auto it = manifest.outputs.constBegin(); it != manifest.outputs.constEnd(); ++it) {
+        if (outputs.contains(it.key())) continue;
+        const QString stalePath = categoryFilePath(outputPath, fileTemplate, it.key());
+        if (sameOutput) diffCategoryFile(outputPath, fileTemplate, it.key(), {});
+        if (sameOutput && QFile::remove(stalePath)) emit logMessage("INFO: Removed " + stalePath + " (no entries left)");
+    }
+
+    manifest.outputPath = absOutputPath;
+    manifest.selected = plan.selected;
+    manifest.languages = mod.exportLanguages();
+    manifest.outputs = outputs;
+    if (!cache.saveManifest(plan.spreadsheetId, manifest)) {
+        emit logMessage("WARNING: Could not save the sheet cache manifest for " + category + "; the next run fetches all of its sheets.");
+    }
+    emit logMessage(QString("INFO: %1 — fetched %2 of %3 sheets, wrote %4 files, kept %5 unchanged.")
+        .arg(category).arg(fresh.size()).arg(plan.selected.size()).arg(filesWritten).arg(filesKept));
+    return success;
+}
+
+bool Worker::loadKeyRules(const ModDefinition& mod, KeyRuleSet& keyRules)
+{
+    keyRules = KeyRuleSet();
+    QString error;
+    if (!mod.removedVanillaKeys.empty()) {
+        QStringList keys;
+        for (const std::string& key : mod.removedVanillaKeys) keys << QString::fromStdString(key);
+        keys.sort();
+        keyRules.addRule("removedVanillaKeys", KeyRuleSet::Exact, keys, &error);
+    }
+    if (!mod.keyRulesPath.isEmpty() && !keyRules.loadFile(mod.keyRulesPath, &error)) {
+        emit logMessage("ERROR: " + error);
+        return false;
+    }
+    emit logMessage(QString("INFO: Key rules — %1 rules loaded%2").arg(keyRules.rules().size())
+        .arg(mod.keyRulesPath.isEmpty() ? QString() : " (" + mod.keyRulesPath + ")"));
+    return true;
+}
+
+void Worker::logKeyRuleMatches(const KeyRuleSet& keyRules)
+{
+    for (const KeyRuleSet::Rule& rule : keyRules.rules()) {
+        emit logMessage(QString("%1: Key rule '%2' (%3) removed %4 keys")
+            .arg(rule.matches > 0 ? "INFO" : "DEBUG").arg(rule.name).arg(KeyRuleSet::kindName(rule.kind)).arg(rule.matches));
+    }
+    if (!keyRules.isEmpty()) emit logMessage(QString("DEBUG: Key rule matcher built %1 DFA states").arg(keyRules.dfaStates()));
+}
+
+// Drops mod keys and keys matching the rules from one vanilla file and writes the cleaned copy when anything was removed.
+// Returns the number of removed keys, or -1 on an I/O error or a cancel (the copy is left as it was).
+// keysOut receives every key of the file when given.
+int Worker::cleanVanillaFile(const QString& vanillaInputPath, const QString& cleanedOutputPath,
+    const std::unordered_set<std::string>* modTags, KeyRuleSet& keyRules,
+    std::unordered_set<std::string>* keysOut)
+{
+    VanillaIndex::File file;
+    if (!VanillaIndex::parseFile(vanillaInputPath, file)) {
+        emit logMessage("ERROR: Could not open vanilla file: " + vanillaInputPath);
+        return -1;
+    }
+    if (keysOut) {
+        for (const std::string& key : file.keys) {
+            if (!key.empty()) keysOut->insert(key);
+        }
+    }
+    return cleanVanillaFile(file, cleanedOutputPath, modTags, keyRules);
+}
 
-        connect(reply, &QNetworkReply::finished, this, [=]() {
-            bool requestHandled = false;
+// Same, for a file already parsed into the vanilla index
+int Worker::cleanVanillaFile(const VanillaIndex::File& file, const QString& cleanedOutputPath,
+    const std::unordered_set<std::string>* modTags, KeyRuleSet& keyRules, std::vector<bool>* removedLines)
+{
+    if (file.size < 0) {
+        emit logMessage("ERROR: Could not open vanilla file: " + file.fileName);
+        return -1;
+    }
 
-            if (reply->error() == QNetworkReply::NoError) {
-                (*fileStatus)[currentFileName] = "Processing";
-                updateStatusMessage();
-                emit logMessage("INFO: Received response for: " + currentFileName);
-
-                QByteArray responseData = reply->readAll();
-                QJsonDocument responseDoc = QJsonDocument::fromJson(responseData);
-                std::unordered_map<std::string, std::vector<std::string>> translations;
-                bool successThisRequest = true;
-
-                if (responseDoc.isObject()) {
-                    QJsonObject rootObject = responseDoc.object();
-                    for (auto it = rootObject.begin(); it != rootObject.end(); ++it) {
-                        if (it.value().isArray()) {
-                            QJsonArray categoryArray = it.value().toArray();
-                            for (const QJsonValue& itemValue : categoryArray) {
-                                if (itemValue.isObject()) {
-                                    QJsonObject itemObject = itemValue.toObject();
-                                    for (auto locIt = itemObject.begin(); locIt != itemObject.end(); ++locIt) {
-                                        QString key = locIt.key();
-                                        QString value = locIt.value().toString();
-
-                                        value.replace(QRegularExpression(R"(\s+)"), " ");
-                                        value = value.trimmed();
-
-                                        QRegularExpression re(R"(\(([^)]+)\))");
-                                        QRegularExpressionMatch match = re.match(key);
-                                        if (match.hasMatch()) {
-                                            QString language = match.captured(1);
-                                            if (language.compare("Braz_Por", Qt::CaseInsensitive) == 0) language = "braz_por";
-                                            else language = language.toLower();
-                                            if (!value.contains(" localisation (", Qt::CaseInsensitive)) {
-                                                translations[language.toStdString()].push_back(value.toStdString());
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    if (translations.empty()) {
-                        emit logMessage("WARNING: No translations received for " + currentFileName);
-                    }
-                    for (const auto& entry : translations) {
-                        QString language = QString::fromStdString(entry.first);
-                        if (language.toLower() == "italian") continue;
-                        QString langLower = language.toLower();
-                        QDir currentOutputDir(outputPath);
-                        currentOutputDir.mkpath(langLower);
-                        QString outFileName = filePair.second;
-                        outFileName.replace("<lang>", langLower);
-                        QString fullOutputPath = currentOutputDir.filePath(langLower + "/" + outFileName);
-                        QFile outputFile(fullOutputPath);
-                        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                            emit logMessage("ERROR: Could not write to file " + fullOutputPath);
-                            successThisRequest = false;
-                            continue;
-                        }
-                        QTextStream out(&outputFile);
-                        out.setEncoding(QStringConverter::Utf8);
-                        out.setGenerateByteOrderMark(true);
-                        out << "l_" << langLower << ":\n";
-                        std::vector<std::string> sortedLines = entry.second;
-                        std::sort(sortedLines.begin(), sortedLines.end());
-                        int entriesWrittenThisLang = 0;
-                        for (const auto& line : sortedLines) {
-                            out << " " << QString::fromStdString(line) << "\n";
-                            entriesWrittenThisLang++;
-                        }
-                        outputFile.close();
-                        emit logMessage(QString("INFO: Wrote %1 entries to %2").arg(entriesWrittenThisLang).arg(fullOutputPath));
-                    }
-                }
-                else {
-                    emit logMessage("ERROR: Unexpected JSON for " + currentFileName + ". Expected a JSON object.");
-                    successThisRequest = false;
-                }
+    // Check if the tag is either a mod tag OR matched by a key rule (only keys the mod does not define count for the rules)
+    std::vector<bool> removed(file.lines.size(), false);
+    int removedInThisFile = 0;
+    for (size_t i = 0; i < file.keys.size(); ++i) {
+        if (m_cancel.isCancelledAt(static_cast<qsizetype>(i))) return -1;
+        const std::string& tag = file.keys[i];
+        if (tag.empty()) continue;
+        if ((modTags && modTags->count(tag) > 0) || keyRules.match(tag) >= 0) {
+            removed[i] = true;
+            removedInThisFile++;
+        }
+    }
+    if (removedLines) *removedLines = removed;
 
-                if (successThisRequest) {
-                    (*fileStatus)[currentFileName] = "Completed";
-                    emit logMessage("INFO: Successfully processed " + currentFileName);
-                    (*totalFilesSucceeded)++;
-                }
-                else {
-                    (*fileStatus)[currentFileName] = "Failed";
-                    *overallSuccess = false;
-                    (*totalFilesFailed)++;
-                }
-                requestHandled = true;
-            }
-            else {
-                emit logMessage(QString("ERROR: Network request failed for %1 (Attempt %2/%3): %4")
-                    .arg(currentFileName).arg(attemptNum + 1).arg(MAX_RETRIES + 1).arg(reply->errorString()));
+    if (removedInThisFile == 0) {
+        emit logMessage("INFO: No changes — skipped write for " + file.fileName);
+        return 0;
+    }
 
-                if (!m_cancelRequested.load() && attemptNum < MAX_RETRIES) {
-                    int delay = BASE_RETRY_DELAY_MS * static_cast<int>(std::pow(2, attemptNum));
-                    emit logMessage(QString("INFO: Retrying in %1ms...").arg(delay));
-                    QTimer::singleShot(delay, this, [=]() {
-                        (*totalRetries)++;
-                        performApiRequest(filePair, apiData, attemptNum + 1);
-                        });
-                }
-                else {
-                    if (m_cancelRequested.load()) {
-                        emit logMessage(QString("INFO: Cancellation active, not retrying %1.").arg(currentFileName));
-                    } else {
-                        emit logMessage(QString("WARNING: Maximum retries reached for %1. This file has failed.").arg(currentFileName));
-                    }
-                    (*fileStatus)[currentFileName] = "Failed";
-                    *overallSuccess = false;
-                    requestHandled = true;
-                }
-            }
+    // Bytes go from the read buffer to the output as they are; only empty strings are rewritten
+    QByteArray out;
+    out.reserve(file.data.size() + 3);
+    out.append("\xEF\xBB\xBF");
+    for (size_t i = 0; i < file.lines.size(); ++i) {
+        if (m_cancel.isCancelledAt(static_cast<qsizetype>(i))) return -1;
+        if (removed[i]) continue;
+        LocalisationKernels::appendCleanedLine(out, file.view(i));
+        out.append('\n');
+    }
 
-            {
-                QMutexLocker locker(&m_mutex);
-                m_activeReplies.removeAll(reply);
-            }
-            emit logMessage(QString("DEBUG: API request for '%1' took %2 ms").arg(currentFileName).arg(requestTimer->elapsed()));
-            delete requestTimer;
-            reply->deleteLater();
-            updateStatusMessage();
-            if (requestHandled) {
-                finalizeRequest();
-            }
-            });
-        };
+    if (m_changeSet) {
+        m_changeSet->setFile(cleanedOutputPath, out, true);
+        emit logMessage(QString("INFO: Would update %1 (removing %2 keys)").arg(cleanedOutputPath).arg(removedInThisFile));
+        return removedInThisFile;
+    }
 
-    // 1. LAUNCH ALL API REQUESTS CONCURRENTLY (Initial call)
-    for (const auto& filePair : filenames) {
-        const QString& currentFileName = filePair.first;
-        emit logMessage("INFO: Starting API request for: " + currentFileName);
+    // Replaced atomically: a cancel or crash mid-write never leaves a truncated copy
+    QSaveFile cleanedOutputFile(cleanedOutputPath);
+    if (!cleanedOutputFile.open(QIODevice::WriteOnly | QIODevice::Text) || cleanedOutputFile.write(out) != out.size()
+        || !cleanedOutputFile.commit()) {
+        emit logMessage("ERROR: Could not write cleaned file: " + cleanedOutputPath);
+        return -1;
+    }
+    emit logMessage(QString("INFO: UPDATED %1 (removed %2 keys)").arg(cleanedOutputPath).arg(removedInThisFile));
+    return removedInThisFile;
+}
 
-        if (!apiMappings.contains(currentFileName)) {
-            emit logMessage("ERROR: No API mapping found for file: " + currentFileName);
-            (*fileStatus)[currentFileName] = "Failed";
-            *overallSuccess = false;
-            finalizeRequest();
-            continue;
+// Replaces Output/<lang>/<subfolder> with the vanilla name_lists or random_names folder
+void Worker::copyNameListFolder(const QString& vanillaPath, const QString& outputPath, const QString& lang, const QString& subfolder)
+{
+    QDir sourceDir(vanillaPath + "/" + lang + "/" + subfolder);
+    if (!sourceDir.exists()) return;
+    QDir destDir(outputPath + "/" + lang + "/" + subfolder);
+    if (m_changeSet) {
+        const QStringList files = sourceDir.entryList(QDir::Files);
+        for (const QString& oldFile : destDir.entryList(QDir::Files | QDir::NoDotAndDotDot)) {
+            if (!files.contains(oldFile)) m_changeSet->removeFile(destDir.filePath(oldFile));
         }
-
-        if (m_cancelRequested.load()) {
-            (*fileStatus)[currentFileName] = "Failed";
-            *overallSuccess = false;
-            finalizeRequest();
-            continue;
+        for (const QString& file : files) {
+            if (m_cancel.isCancelled()) return;
+            m_changeSet->copyFile(destDir.filePath(file), sourceDir.filePath(file));
+            m_metrics.counters().workDone += QFileInfo(sourceDir.filePath(file)).size();
+            publishMetrics();
+        }
+        return;
+    }
+    if (!destDir.exists()) destDir.mkpath(".");
+    else {
+        QStringList oldFiles = destDir.entryList(QDir::Files | QDir::NoDotAndDotDot);
+        for (const QString& oldFile : oldFiles) {
+            QFile::remove(destDir.filePath(oldFile));
         }
-        (*fileStatus)[currentFileName] = "Fetching";
-        const ApiData& apiData = apiMappings.value(currentFileName);
+    }
 
-        performApiRequest(filePair, apiData, 0);
+    QStringList files = sourceDir.entryList(QDir::Files);
+    for (const auto& file : files) {
+        if (m_cancel.isCancelled()) return;
+        if (!QFile::copy(sourceDir.filePath(file), destDir.filePath(file))) {
+            emit logMessage("WARNING: Failed to copy " + sourceDir.filePath(file) + " to " + destDir.filePath(file) + " (May already exist or permissions issue).");
+        }
+        else {
+            m_metrics.counters().filesWritten++;
+        }
+        m_metrics.counters().workDone += QFileInfo(sourceDir.filePath(file)).size();
+        publishMetrics();
     }
-    updateStatusMessage();
+    emit logMessage("INFO:Copied " + subfolder + " for " + lang + " to Output.");
 }
 
 // Main logic for cleaning up and updating localisation files based on modType
 void Worker::runCleanupProcess(int modType, const QString& inputPath, const QString& outputPath, const QString& vanillaPath)
 {
     QElapsedTimer totalTimerCleanup; totalTimerCleanup.start();
+    m_metrics.start();
+    m_lastPercent = -1;
+    m_predictRemaining = nullptr;
     emit progressUpdated(0);
     emit statusMessage("Starting localization cleanup and update");
     emit logMessage("INFO: Running cleanup process (writing cleaned vanilla to Output)...");
     // Log of cleanup config will be printed after languages are defined
 
-    // The keys to be removed from vanilla files, hardcoded
-    std::unordered_set<std::string> keysToRemove = {
-        "DIFFICULTY_ADMIRAL",
-        "DIFFICULTY_CADET",
-        "DIFFICULTY_CAPTAIN",
-        "DIFFICULTY_CIVILIAN",
-        "DIFFICULTY_COMMODORE",
-        "DIFFICULTY_ENSIGN",
-        "DIFFICULTY_GRAND_ADMIRAL"
-    };
-
-    // List of supported languages (Italian is skipped)
-    std::vector<QString> languages = {
-        "braz_por", "english", "french", "german", "polish", "russian",
-        // "italian",
-        "spanish"
-    };
+    const ModDefinition* mod = ModManifest::instance().findByType(modType);
+    if (!mod) {
+        emit logMessage(QString("ERROR: No mod with modType %1 in the mod manifest (%2).").arg(modType).arg(ModManifest::instance().source()));
+        emit taskFinished(false, "Unknown mod type.");
+        return;
+    }
+    const std::vector<QString> languages = cleanupLanguages(*mod, vanillaPath);
+    KeyRuleSet keyRules;
+    if (!loadKeyRules(*mod, keyRules)) {
+        emit taskFinished(false, "Invalid key rules.");
+        return;
+    }
 
     emit logMessage("INFO: Cleanup config — vanilla=" + vanillaPath + ", output=" + outputPath + ", langs=" + QString::number(static_cast<int>(languages.size())));
 
+    // A plan started by the create step goes on here; a cleanup on its own is planned against Output as it is
+    if (!m_planMode) m_changeSet.reset();
+    const bool plannedCreate = m_changeSet != nullptr;
+    if (m_planMode && !m_changeSet) m_changeSet = std::make_shared<ChangeSet>(outputPath);
+
     // Define the file templates based on modType - used only for First Pass (loading mod tags)
     QMap<QString, QStringList> modFilesTemplates;
-    QString modName = "STNH";
-    emit logMessage("INFO: Selected STNH Cleanup");
-    modFilesTemplates.insert(outputPath + "/<lang>/STH_main_l_<lang>.yml", QStringList());
-    modFilesTemplates.insert(outputPath + "/<lang>/STH_ships_l_<lang>.yml", QStringList());
-    modFilesTemplates.insert(outputPath + "/<lang>/STH_modifiers_l_<lang>.yml", QStringList());
-    modFilesTemplates.insert(outputPath + "/<lang>/STH_tech_l_<lang>.yml", QStringList());
-    modFilesTemplates.insert(outputPath + "/<lang>/STH_events_l_<lang>.yml", QStringList());
-    modFilesTemplates.insert(outputPath + "/<lang>/STH_synced_l_<lang>.yml", QStringList());
+    emit logMessage("INFO: Selected " + mod->name + " Cleanup");
+    for (const ModCategory& category : mod->categories) {
+        modFilesTemplates.insert(outputPath + "/<lang>/" + category.fileTemplate, QStringList());
+    }
 
     emit logMessage("DEBUG: modFilesTemplates size after initialization: " + QString::number(modFilesTemplates.size()) + " for modType " + QString::number(modType));
 
-    std::regex keyExp("^ +(.+?):[0-9]? +\"([^\\\"]*)\"");
-    std::regex emptystringExp("^( +.+?:[0-9]? +)\\\"\\\"$");
-    std::smatch matches;
+    // The parsed vanilla tree is kept between tasks: later mods of a batch (and later runs) only re-read changed files
+    vanillaIndex(vanillaPath);
+    const qint64 parsedBefore = m_vanillaIndex->filesParsed();
+    const qint64 reusedBefore = m_vanillaIndex->filesReused();
+    // Languages are walked and read on the pool from here on, while the cleanup reads mod keys and then
+    // cleans the files already read
+    QStringList scanLanguages;
+    for (const auto& lang : languages) scanLanguages << lang;
+    m_vanillaIndex->scan(scanLanguages, &m_cancel);
+
+    // Progress is measured in bytes: mod files read for their keys, vanilla files cleaned, name lists and static files copied.
+    // Only sizes are looked up here (the vanilla ones come from the walks the scan has already started); the files are read once, below.
+    QHash<QString, qint64> vanillaBytesByLang;
+    {
+        WorkerMetrics& counters = m_metrics.counters();
+        for (const auto& lang : languages) {
+            for (const QString& outputPathTemplate : modFilesTemplates.keys()) {
+                counters.workTotal += QFileInfo(QString(outputPathTemplate).replace("<lang>", lang.toLower())).size();
+            }
+            VanillaIndex::Listing listing;
+            if (m_vanillaIndex->listing(lang, listing, &m_cancel)) {
+                counters.workTotal += listing.bytes;
+                counters.itemsQueued += static_cast<int>(listing.files);
+                vanillaBytesByLang[lang] += listing.bytes;
+            }
+            for (const QString& subfolder : { QString("name_lists"), QString("random_names") }) {
+                for (const QFileInfo& info : QDir(vanillaPath + "/" + lang + "/" + subfolder).entryInfoList(QDir::Files)) counters.workTotal += info.size();
+            }
+        }
+        QDir staticDir(mod->staticPath);
+        for (const QString& langFolder : staticDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            for (const QFileInfo& info : QDir(staticDir.filePath(langFolder)).entryInfoList(QDir::Files | QDir::NoDotAndDotDot)) counters.workTotal += info.size();
+        }
+    }
+
+    // Time left from earlier runs: the languages still to clean, each scaled to its current vanilla size
+    struct CleanupForecast {
+        QHash<QString, qint64> pending;   // language -> expected ms, -1 if unknown
+        QString current;                  // language being cleaned
+        QElapsedTimer clock;              // started when the current language began
+    };
+    auto forecast = std::make_shared<CleanupForecast>();
+    m_history.load();
+    for (auto it = vanillaBytesByLang.constBegin(); it != vanillaBytesByLang.constEnd(); ++it) {
+        forecast->pending.insert(it.key(), m_history.predictCleanupMs(it.key(), it.value()));
+    }
+    m_predictRemaining = [forecast](qint64) -> qint64 {
+        qint64 remaining = 0;
+        for (auto it = forecast->pending.constBegin(); it != forecast->pending.constEnd(); ++it) {
+            if (it.value() < 0) return -1;
+            remaining += it.key() == forecast->current ? qMax<qint64>(0, it.value() - forecast->clock.elapsed()) : it.value();
+        }
+        return remaining;
+        };
+    publishMetrics(true);
 
     std::unordered_map<QString, std::unordered_set<std::string>> usedTags;
 
@@ -511,14 +1766,11 @@ void Worker::runCleanupProcess(int modType, const QString& inputPath, const QStr
     emit logMessage("INFO: Loading existing keys from output files for cleanup...");
 
     // First pass: Load existing localization tags from the mod's output files
-    // Calculate progress for this section
-    int currentProgress = 0;
-    int progressPerLanguage = (modFilesTemplates.keys().size() > 0) ? (20 / static_cast<int>(languages.size())) : 0; // Allocate 20% for this phase
-
     for (const auto& lang : languages) {
-        if (m_cancelRequested.load()) {
-            emit statusMessage("Cancelling…");
-            emit taskFinished(false, "Operation cancelled.");
+        if (m_cancel.isCancelled()) {
+            logCancelled("cleanup");
+            emit statusMessage("Cancelled by user.");
+            emit taskFinished(false, "Operation cancelled.", true);
             return;
         }
         QString langLower = lang.toLower();
@@ -527,219 +1779,225 @@ void Worker::runCleanupProcess(int modType, const QString& inputPath, const QStr
             QString outputPathWithLang = outputPathTemplate;
             outputPathWithLang.replace("<lang>", langLower);
 
-            QFile outputFile(outputPathWithLang);
-            if (!outputFile.exists()) {
+            // Read and split as raw UTF-8, like the vanilla files; a planned create has the files in memory only
+            VanillaIndex::File modFile;
+            QByteArray planned;
+            if (plannedCreate) {
+                if (!m_changeSet->plannedContent(outputPathWithLang, planned)) {
+                    emit logMessage("INFO: Mod output file does not exist for loading tags: " + outputPathWithLang);
+                    continue;
+                }
+                VanillaIndex::parseData(planned, modFile);
+            }
+            else if (!QFileInfo::exists(outputPathWithLang)) {
                 emit logMessage("INFO: Mod output file does not exist for loading tags: " + outputPathWithLang);
                 continue;
             }
-
-            if (!outputFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            else if (!VanillaIndex::parseFile(outputPathWithLang, modFile)) {
                 emit logMessage("ERROR: Could not open mod output file for reading tags: " + outputPathWithLang);
                 continue;
             }
-
-            QTextStream in(&outputFile);
-            while (!in.atEnd()) {
-                QString line = in.readLine();
-                std::string stdLine = line.toStdString();
-                if (std::regex_search(stdLine, matches, keyExp)) {
-                    std::string tag = matches[1].str();
-                    usedTags[lang].insert(tag);
-                    tagsLoadedForLang++;
-                }
+            m_metrics.counters().workDone += modFile.data.size();
+            publishMetrics();
+            if (m_keyIndex) m_keyIndex->addFile(QFileInfo(outputPathWithLang).absoluteFilePath(), lang, KeyIndex::ModFile, modFile);
+            std::unordered_set<std::string>& tags = usedTags[lang];
+            for (std::string& tag : modFile.keys) {
+                if (tag.empty()) continue;
+                tags.insert(std::move(tag));
+                tagsLoadedForLang++;
             }
-            outputFile.close();
             emit logMessage("INFO: Loaded " + QString::number(tagsLoadedForLang) + " tags from " + outputPathWithLang + " for " + lang + ".");
             tagsLoadedForLang = 0;
         }
         emit logMessage("INFO: Total unique tags loaded for " + lang + ": " + QString::number(usedTags[lang].size()));
-        currentProgress += progressPerLanguage;
-        emit progressUpdated(qMin(currentProgress, 20)); // Cap at 20% for this phase
     }
     emit logMessage("SUMMARY: Loaded tags for " + QString::number(usedTags.size()) + " languages in total from mod output.");
-    emit progressUpdated(20); // Ensure it's at 20% after the first pass
 
     // Second pass: Process ALL vanilla files and write cleaned versions to the Output folder
     bool success = true;
     long long totalKeysRemoved = 0;
-    int progressPerVanillaFile = (static_cast<int>(languages.size()) * modFilesTemplates.keys().size() > 0) ? (70 / (static_cast<int>(languages.size()) * modFilesTemplates.keys().size())) : 0; // Allocate 70% for this phase (20-90)
     int filesProcessed = 0;
 
     for (const auto& lang : languages) {
         QElapsedTimer langTimer; langTimer.start();
-        if (lang.toLower() == "italian") {
-            emit logMessage("INFO: Skipping Italian language for cleanup.");
-            continue;
-        }
 
-        QDir vanillaLangDir(vanillaPath + "/" + lang);
-        if (!vanillaLangDir.exists()) {
-            emit logMessage("WARNING: Vanilla language directory does not exist: " + vanillaLangDir.path());
+        forecast->current = lang;
+        forecast->clock.start();
+
+        VanillaIndex::Listing listing;
+        const bool listed = m_vanillaIndex->listing(lang, listing, &m_cancel);
+        if (m_cancel.isCancelled()) {
+            m_vanillaIndex->language(lang);
+            logCancelled("cleanup");
+            emit statusMessage("Cancelled by user.");
+            emit taskFinished(false, "Operation cancelled.", true);
+            return;
+        }
+        if (!listed) {
+            m_vanillaIndex->language(lang);
+            emit logMessage("WARNING: Vanilla language directory does not exist: " + vanillaPath + "/" + lang);
+            forecast->pending.remove(lang);
             continue;
         }
 
         QDir outputLangDir(outputPath + "/" + lang);
-        if (!outputLangDir.exists()) {
+        if (!outputLangDir.exists() && !m_changeSet) {
             outputLangDir.mkpath(".");
         }
 
-
-        QStringList vanillaFiles = vanillaLangDir.entryList(QStringList() << "*.yml", QDir::Files, QDir::Name);
-
         int filesProcessedForLang = 0;
         long long keysRemovedForLang = 0;
-        for (const QString& vanillaFileName : vanillaFiles) {
-            if (m_cancelRequested.load()) {
-                emit statusMessage("Cancelling…");
-                emit taskFinished(false, "Operation cancelled.");
+        // Files are cleaned as the pool reads them, in path order
+        for (qsizetype fileIndex = 0; fileIndex < listing.files; ++fileIndex) {
+            const VanillaIndex::File* readFile = m_vanillaIndex->file(lang, fileIndex, &m_cancel);
+            if (!readFile || m_cancel.isCancelled()) {
+                // Hands what was read to the index, so the next run reuses it
+                m_vanillaIndex->language(lang);
+                logCancelled("cleanup");
+                emit statusMessage("Cancelled by user.");
+                emit taskFinished(false, "Operation cancelled.", true);
                 return;
             }
-            if (vanillaFileName.startsWith("name_lists_") || vanillaFileName.startsWith("random_names_")) {
-                continue;
-            }
-
-            QString vanillaInputPath = vanillaLangDir.filePath(vanillaFileName);
-            QFile vanillaFile(vanillaInputPath);
-            if (!vanillaFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                emit logMessage("ERROR: Could not open vanilla file: " + vanillaInputPath);
-                success = false;
-                continue;
-            }
-
-            QTextStream inVanilla(&vanillaFile);
-            QStringList fileData;
-            bool fileChanged = false;
-            int removedInThisFile = 0;
 
-            while (!inVanilla.atEnd()) {
-                QString line = inVanilla.readLine();
-                std::string stdLine = line.toStdString();
-
-                if (std::regex_search(stdLine, matches, keyExp)) {
-                    std::string tag = matches[1].str();
-                    // Check if the tag is either a mod tag OR a hardcoded key to remove
-                    if ((usedTags.find(lang) != usedTags.end() && usedTags[lang].find(tag) != usedTags[lang].end()) || keysToRemove.count(tag) > 0) {
-                        fileChanged = true;
-                        removedInThisFile++;
-                    }
-                    else {
-                        fileData.append(line);
-                    }
-                }
-                else {
-                    fileData.append(line);
+            const VanillaIndex::File& vanillaFile = *readFile;
+            if (m_validateUtf8) {
+                qsizetype badOffset = 0;
+                const char* body = vanillaFile.data.constData() + vanillaFile.bodyOffset;
+                if (!LocalisationKernels::isValidUtf8(body, vanillaFile.data.size() - vanillaFile.bodyOffset, &badOffset)) {
+                    emit logMessage(QString("WARNING: %1/%2 is not valid UTF-8 (first bad byte at offset %3); it is copied byte for byte.")
+                        .arg(lang).arg(vanillaFile.fileName).arg(badOffset + vanillaFile.bodyOffset));
                 }
             }
-            vanillaFile.close();
-
-            if (fileChanged) {
-                QString cleanedOutputPath = outputLangDir.filePath(vanillaFileName);
-                QFile cleanedOutputFile(cleanedOutputPath);
-                if (!cleanedOutputFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
-                    emit logMessage("ERROR: Could not write cleaned file: " + cleanedOutputPath);
-                    success = false;
-                    continue;
-                }
-
-                QTextStream outCleaned(&cleanedOutputFile);
-                outCleaned.setEncoding(QStringConverter::Utf8);
-                outCleaned.setGenerateByteOrderMark(true);
-
-                for (const QString& line : fileData) {
-                    std::string processedLine = std::regex_replace(line.toStdString(), emptystringExp, "$1\"\\n\"");
-                    outCleaned << QString::fromStdString(processedLine) << "\n";
-                }
-                cleanedOutputFile.close();
-                emit logMessage(QString("INFO: UPDATED %1 (removed %2 keys)").arg(cleanedOutputPath).arg(removedInThisFile));
-                keysRemovedForLang += removedInThisFile;
-                totalKeysRemoved += removedInThisFile;
+            auto tagsIt = usedTags.find(lang);
+            const std::unordered_set<std::string>* modTags = tagsIt != usedTags.end() ? &tagsIt->second : nullptr;
+            // Files from subfolders keep their relative path under Output/<lang>
+            const QString cleanedPath = outputLangDir.filePath(vanillaFile.fileName);
+            if (vanillaFile.fileName.contains('/') && !m_changeSet) QFileInfo(cleanedPath).absoluteDir().mkpath(".");
+            std::vector<bool> removedLines;
+            const int removedInThisFile = cleanVanillaFile(vanillaFile, cleanedPath, modTags, keyRules, m_keyIndex ? &removedLines : nullptr);
+            if (m_keyIndex && removedInThisFile >= 0) {
+                m_keyIndex->addFile(QFileInfo(vanillaPath + "/" + lang + "/" + vanillaFile.fileName).absoluteFilePath(), lang,
+                    KeyIndex::VanillaFile, vanillaFile, &removedLines);
             }
-            else {
-                emit logMessage("INFO: No changes — skipped write for " + vanillaFileName);
+            WorkerMetrics& counters = m_metrics.counters();
+            counters.vanillaBytes += vanillaFile.data.size();
+            counters.workDone += vanillaFile.data.size();
+            counters.itemsQueued--;
+            if (removedInThisFile > 0) counters.filesWritten++;
+            publishMetrics();
+            if (removedInThisFile < 0) {
+                success = false;
+                continue;
             }
+            keysRemovedForLang += removedInThisFile;
+            totalKeysRemoved += removedInThisFile;
             filesProcessed++;
             filesProcessedForLang++;
-            emit progressUpdated(20 + qMin(filesProcessed * progressPerVanillaFile, 70)); // Progress from 20% to 90%
         }
+        m_vanillaIndex->language(lang);
         emit logMessage(QString("INFO: Cleanup summary for %1 — processed: %2 files, removed: %3 keys")
             .arg(lang).arg(filesProcessedForLang).arg(keysRemovedForLang));
         emit logMessage(QString("DEBUG: Cleanup for language '%1' took %2 ms").arg(lang).arg(langTimer.elapsed()));
+        m_history.recordCleanup(lang, langTimer.elapsed(), vanillaBytesByLang.value(lang));
+        forecast->pending.remove(lang);
     }
-    emit progressUpdated(90); // Ensure it's at 90% before copying name lists
+    logKeyRuleMatches(keyRules);
+    emit logMessage(QString("INFO: Vanilla index — parsed %1 files, reused %2 from earlier tasks")
+        .arg(m_vanillaIndex->filesParsed() - parsedBefore).arg(m_vanillaIndex->filesReused() - reusedBefore));
 
     emit statusMessage("Copying name lists");
     emit logMessage("Copying name_lists and random_names to Output folder...");
     // Copy name_lists and random_names folders for each language
     for (const auto& lang : languages) {
-        if (m_cancelRequested.load()) {
-            emit statusMessage("Cancelling…");
-            emit taskFinished(false, "Operation cancelled.");
+        if (m_cancel.isCancelled()) {
+            logCancelled("cleanup");
+            emit statusMessage("Cancelled by user.");
+            emit taskFinished(false, "Operation cancelled.", true);
             return;
         }
         QStringList subfoldersToCopy = { "name_lists", "random_names" };
         for (const auto& subfolder : subfoldersToCopy) {
-            QDir sourceDir(vanillaPath + "/" + lang + "/" + subfolder);
-            if (sourceDir.exists()) {
-                QDir destDir(outputPath + "/" + lang + "/" + subfolder);
-                if (!destDir.exists()) destDir.mkpath(".");
-                else {
-                    QStringList oldFiles = destDir.entryList(QDir::Files | QDir::NoDotAndDotDot);
-                    for (const QString& oldFile : oldFiles) {
-                        QFile::remove(destDir.filePath(oldFile));
-                    }
-                }
-
-                QStringList files = sourceDir.entryList(QDir::Files);
-                for (const auto& file : files) {
-                    if (!QFile::copy(sourceDir.filePath(file), destDir.filePath(file))) {
-                        emit logMessage("WARNING: Failed to copy " + sourceDir.filePath(file) + " to " + destDir.filePath(file) + " (May already exist or permissions issue).");
-                    }
-                }
-                emit logMessage("INFO:Copied " + subfolder + " for " + lang + " to Output.");
-            }
+            copyNameListFolder(vanillaPath, outputPath, lang, subfolder);
         }
     }
 
     // Copy static localisation files if present
     emit statusMessage("Copying static localisation files");
-    emit logMessage("INFO: Copying files from 'static_localisation' into language subfolders in Output...");
-    QDir staticLocalisationBaseDir("static_localisation");
+    emit logMessage("INFO: Copying files from '" + mod->staticPath + "' into language subfolders in Output...");
+    QDir staticLocalisationBaseDir(mod->staticPath);
     QStringList staticLangFolders;
     if (staticLocalisationBaseDir.exists()) {
         staticLangFolders = staticLocalisationBaseDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
         for (const QString& langFolder : staticLangFolders) {
-            if (m_cancelRequested.load()) {
-                emit statusMessage("Cancelling…");
-                emit taskFinished(false, "Operation cancelled.");
+            if (m_cancel.isCancelled()) {
+                logCancelled("cleanup");
+                emit statusMessage("Cancelled by user.");
+                emit taskFinished(false, "Operation cancelled.", true);
                 return;
             }
             QString sourceLangPath = staticLocalisationBaseDir.filePath(langFolder);
             QDir sourceDir(sourceLangPath);
             if (!sourceDir.exists()) continue;
             QDir destDir(outputPath + "/" + langFolder);
-            if (!destDir.exists()) destDir.mkpath(".");
+            if (!destDir.exists() && !m_changeSet) destDir.mkpath(".");
             QStringList filesToCopy = sourceDir.entryList(QDir::Files | QDir::NoDotAndDotDot);
             for (const QString& file : filesToCopy) {
-                if (m_cancelRequested.load()) {
-                    emit statusMessage("Cancelling…");
-                    emit taskFinished(false, "Operation cancelled.");
+                if (m_cancel.isCancelled()) {
+                    logCancelled("cleanup");
+                    emit statusMessage("Cancelled by user.");
+                    emit taskFinished(false, "Operation cancelled.", true);
                     return;
                 }
                 QString sourceFilePath = sourceDir.filePath(file);
                 QString destFilePath = destDir.filePath(file);
-                if (!QFile::copy(sourceFilePath, destFilePath)) {
+                if (m_changeSet) {
+                    m_changeSet->copyFile(destFilePath, sourceFilePath);
+                }
+                else if (!QFile::copy(sourceFilePath, destFilePath)) {
                     emit logMessage("WARNING: Failed to copy " + sourceFilePath + " to " + destFilePath + " (Permissions issue).");
                     success = false;
                 } else {
                     emit logMessage("Copied " + file + " to " + destDir.path() + ".");
+                    m_metrics.counters().filesWritten++;
                 }
+                m_metrics.counters().workDone += QFileInfo(sourceFilePath).size();
+                publishMetrics();
             }
         }
     } else {
-        emit logMessage("INFO: 'static_localisation' folder is not found. Skipping copy.");
+        emit logMessage("INFO: '" + mod->staticPath + "' folder is not found. Skipping copy.");
     }
 
+    m_predictRemaining = nullptr;
+    publishMetrics(true);
     emit progressUpdated(100);
+    if (m_changeSet) {
+        // A real create run clears Output first, so files it would not produce count as removed
+        if (plannedCreate) m_changeSet->finish();
+        const QString planDir = QDir(m_reportDir.isEmpty() ? QString("reports") : m_reportDir).filePath(mod->id);
+        QString planError;
+        if (!m_changeSet->write(planDir, &planError)) {
+            emit logMessage("ERROR: " + planError);
+            success = false;
+        }
+        emit logMessage(QString("SUMMARY: Plan — %1. See %2/change_set.json").arg(m_changeSet->summary()).arg(planDir));
+    }
+    else {
+        QString historyError;
+        if (!m_history.save(&historyError)) emit logMessage("WARNING: Run history not saved: " + historyError);
+    }
+    // Only a cleanup after a create knows where the keys came from
+    if (m_keyIndex) {
+        const QString indexPath = KeyIndex::pathFor(m_sheetCacheDir, mod->id);
+        QString indexError;
+        if (m_keyIndex->save(indexPath, &indexError)) {
+            emit logMessage(QString("INFO: Key index: %1 keys saved to %2").arg(m_keyIndex->keyCount()).arg(indexPath));
+        }
+        else {
+            emit logMessage("WARNING: Key index not saved: " + indexError);
+        }
+        m_keyIndex.reset();
+    }
 
     emit logMessage(QString("SUMMARY: Cleanup process duration: %1 ms; files: %2; keys removed: %3")
         .arg(totalTimerCleanup.elapsed()).arg(filesProcessed).arg(totalKeysRemoved));
@@ -749,4 +2007,416 @@ void Worker::runCleanupProcess(int modType, const QString& inputPath, const QStr
     else {
         emit taskFinished(false, "Cleanup and update task finished with some errors.");
     }
-}
\ No newline at end of file
+}
+
+// One watch mode cycle; the fetch callbacks share it until the last reply is in
+struct Worker::IncrementalCycle {
+    QElapsedTimer timer;
+    QString outputPath;
+    QString vanillaPath;
+    QStringList changedFiles;
+    bool full = false;              // first cycle after a reset: rebuild everything
+    bool sheetsRefreshed = false;   // payloads reflect the current selections
+    bool success = true;
+    int pendingReplies = 0;
+    const ModDefinition* mod = nullptr;
+    QMap<QString, ApiData> apiMappings;
+    QHash<QString, QByteArray> payloads; // category -> export payload
+    QSet<QString> fetchFailed;
+};
+
+// Watch mode entry point: fetches the selected sheets if asked, then rebuilds only what changed
+void Worker::doIncrementalTask(int modType, const QString& outputPath, const QString& vanillaPath, const QStringList& changedFiles, bool refreshSheets)
+{
+    m_cancel.reset();
+    const ModDefinition* mod = ModManifest::instance().findByType(modType);
+    if (!mod) {
+        emit logMessage(QString("ERROR: Watch: no mod with modType %1 in the mod manifest.").arg(modType));
+        emit incrementalFinished(false, "Unknown mod type.");
+        return;
+    }
+    auto cycle = std::make_shared<IncrementalCycle>();
+    cycle->mod = mod;
+    cycle->timer.start();
+    cycle->outputPath = outputPath;
+    cycle->vanillaPath = vanillaPath;
+    cycle->changedFiles = changedFiles;
+
+    // A reset or different paths invalidate everything kept from earlier cycles
+    if (!m_watch.primed || m_watch.outputPath != outputPath || m_watch.vanillaPath != vanillaPath) {
+        m_watch = WatchState();
+        m_watch.outputPath = outputPath;
+        m_watch.vanillaPath = vanillaPath;
+        cycle->full = true;
+        refreshSheets = true;
+        emit logMessage("INFO: Watch: full rebuild to prime the in-memory state, clearing " + outputPath);
+        QDir outputDir(outputPath);
+        outputDir.removeRecursively();
+        if (!outputDir.mkpath(".")) {
+            emit logMessage("ERROR: Could not create Output folder at: " + outputPath);
+            emit incrementalFinished(false, "Failed to prepare output directory.");
+            return;
+        }
+        // Rule file edits take effect on the next full cycle
+        if (!loadKeyRules(*mod, m_watch.keyRules)) {
+            emit incrementalFinished(false, "Invalid key rules.");
+            return;
+        }
+    }
+
+    if (!refreshSheets) {
+        finishIncrementalCycle(cycle);
+        return;
+    }
+
+    cycle->apiMappings = modApiMappings(*mod, m_compactExport);
+    if (!applySelections(m_selectionsJson, cycle->apiMappings)) {
+        emit logMessage("ERROR: Watch: invalid selections JSON, sheets were not checked.");
+        cycle->success = false;
+        finishIncrementalCycle(cycle);
+        return;
+    }
+    cycle->sheetsRefreshed = true;
+
+    emit statusMessage("Checking sheets for changes...");
+    emit fetchActive(true);
+    for (auto it = cycle->apiMappings.begin(); it != cycle->apiMappings.end(); ++it) {
+        if (it->targetSheets.isEmpty()) continue;
+        const QString category = it.key();
+        cycle->pendingReplies++;
+        QNetworkReply* reply = networkManager->get(QNetworkRequest(buildExportUrl(it.value())));
+        {
+            QMutexLocker locker(&m_mutex);
+            m_activeReplies.append(reply);
+        }
+        connect(reply, &QNetworkReply::finished, this, [this, cycle, category, reply]() {
+            {
+                QMutexLocker locker(&m_mutex);
+                m_activeReplies.removeAll(reply);
+            }
+            if (reply->error() == QNetworkReply::NoError) {
+                cycle->payloads.insert(category, reply->readAll());
+            }
+            else {
+                // Keep the previous entries; the next poll tries again
+                emit logMessage(QString("WARNING: Watch: fetch failed for %1: %2").arg(category).arg(reply->errorString()));
+                cycle->fetchFailed.insert(category);
+            }
+            reply->deleteLater();
+            if (--cycle->pendingReplies == 0) {
+                emit fetchActive(false);
+                finishIncrementalCycle(cycle);
+            }
+        });
+    }
+    if (cycle->pendingReplies == 0) {
+        emit fetchActive(false);
+        finishIncrementalCycle(cycle);
+    }
+}
+
+void Worker::finishIncrementalCycle(const std::shared_ptr<IncrementalCycle>& cycle)
+{
+    if (m_cancel.isCancelled()) {
+        // Nothing has been applied yet, so the kept state still matches Output
+        logCancelled("the refresh");
+        emit statusMessage("Cancelled by user.");
+        emit incrementalFinished(false, "Operation cancelled.");
+        return;
+    }
+    emit processActive(true);
+
+    // lang -> keys that entered or left the mod key set this cycle
+    std::unordered_map<QString, std::unordered_set<std::string>> changedTags;
+    QStringList changedCategories;
+    int sthWritten = 0;
+    int sthRemoved = 0;
+
+    if (cycle->sheetsRefreshed) {
+        for (const auto& filePair : modFileNames(*cycle->mod)) {
+            const QString& category = filePair.first;
+            if (cycle->fetchFailed.contains(category)) {
+                cycle->success = false;
+                continue;
+            }
+
+            std::unordered_map<std::string, std::vector<std::string>> translations;
+            if (!cycle->apiMappings.value(category).targetSheets.isEmpty()) {
+                const QByteArray payload = cycle->payloads.value(category);
+                const QByteArray payloadHash = QCryptographicHash::hash(payload, QCryptographicHash::Sha1);
+                if (m_watch.payloadHashes.value(category) == payloadHash) continue; // unchanged since the last cycle
+                const bool parsed = parseExportPayload(payload, *cycle->mod, translations, m_cancel);
+                if (m_cancel.isCancelled()) {
+                    // Only part of the payload was parsed and earlier categories may be applied; the hash stays
+                    // unrecorded so the payload is retried, and the next cycle rebuilds fully
+                    m_watch.primed = false;
+                    logCancelled("the refresh");
+                    emit processActive(false);
+                    emit statusMessage("Cancelled by user.");
+                    emit incrementalFinished(false, "Operation cancelled.");
+                    return;
+                }
+                if (!parsed) {
+                    emit logMessage("ERROR: Unexpected JSON for " + category + ". Expected a JSON object.");
+                    cycle->success = false;
+                    continue;
+                }
+                m_watch.payloadHashes.insert(category, payloadHash);
+            }
+            else {
+                // Deselected: everything the category contributed goes away
+                if (!m_watch.payloadHashes.contains(category) && !m_watch.categoryKeys.contains(category)) continue;
+                m_watch.payloadHashes.remove(category);
+            }
+            changedCategories << category;
+
+            // Rewrite only languages whose entries changed
+            std::unordered_map<std::string, std::unordered_set<std::string>> newKeys;
+            QSet<QString> languagesSeen;
+            for (auto& entry : translations) {
+                const QString langLower = QString::fromStdString(entry.first).toLower();
+                languagesSeen.insert(langLower);
+
+                std::vector<std::string>& lines = entry.second;
+                if (!LocalisationKernels::sortLines(lines, m_cancel)) {
+                    // Part of this category is applied; force a full rebuild next time
+                    m_watch.primed = false;
+                    logCancelled("the refresh");
+                    emit processActive(false);
+                    emit statusMessage("Cancelled by user.");
+                    emit incrementalFinished(false, "Operation cancelled.");
+                    return;
+                }
+                std::unordered_set<std::string>& keys = newKeys[langLower.toStdString()];
+                QCryptographicHash entriesHash(QCryptographicHash::Sha1);
+                for (const std::string& line : lines) {
+                    entriesHash.addData(QByteArrayView(line.data(), static_cast<qsizetype>(line.size())));
+                    entriesHash.addData("\n");
+                    std::string key;
+                    if (LocalisationKernels::parseKeyLine(" " + line, key)) keys.insert(key);
+                }
+                const QString hashKey = category + "|" + langLower;
+                const QByteArray digest = entriesHash.result();
+                if (m_watch.entryHashes.value(hashKey) == digest) continue;
+
+                QDir currentOutputDir(cycle->outputPath);
+                currentOutputDir.mkpath(langLower);
+                QString outFileName = filePair.second;
+                outFileName.replace("<lang>", langLower);
+                const QString fullOutputPath = currentOutputDir.filePath(langLower + "/" + outFileName);
+                const int entriesWritten = LocalisationKernels::writeYmlFile(fullOutputPath, langLower, lines, true);
+                if (entriesWritten < 0) {
+                    emit logMessage("ERROR: Could not write to file " + fullOutputPath);
+                    m_watch.entryHashes.remove(hashKey);
+                    cycle->success = false;
+                    continue;
+                }
+                m_watch.entryHashes.insert(hashKey, digest);
+                sthWritten++;
+                emit logMessage(QString("INFO: Wrote %1 entries to %2").arg(entriesWritten).arg(fullOutputPath));
+            }
+
+            // Languages the category no longer provides
+            for (auto it = m_watch.entryHashes.begin(); it != m_watch.entryHashes.end();) {
+                const QString langLower = it.key().mid(category.size() + 1);
+                if (it.key().startsWith(category + "|") && !languagesSeen.contains(langLower)) {
+                    QString outFileName = filePair.second;
+                    outFileName.replace("<lang>", langLower);
+                    QFile::remove(cycle->outputPath + "/" + langLower + "/" + outFileName);
+                    emit logMessage("INFO: Removed " + outFileName + " (no entries left)");
+                    sthRemoved++;
+                    it = m_watch.entryHashes.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+
+            // Reference-count keys across categories; only keys entering or leaving the set touch vanilla files
+            auto oldKeys = m_watch.categoryKeys.take(category);
+            std::unordered_set<std::string> languages;
+            for (const auto& entry : oldKeys) languages.insert(entry.first);
+            for (const auto& entry : newKeys) languages.insert(entry.first);
+            static const std::unordered_set<std::string> noKeys;
+            for (const std::string& language : languages) {
+                const QString lang = QString::fromStdString(language);
+                auto oldIt = oldKeys.find(language);
+                auto newIt = newKeys.find(language);
+                const std::unordered_set<std::string>& before = oldIt != oldKeys.end() ? oldIt->second : noKeys;
+                const std::unordered_set<std::string>& after = newIt != newKeys.end() ? newIt->second : noKeys;
+                std::unordered_map<std::string, int>& refs = m_watch.tagRefs[lang];
+                for (const std::string& key : after) {
+                    if (before.count(key)) continue;
+                    if (++refs[key] == 1) {
+                        m_watch.usedTags[lang].insert(key);
+                        changedTags[lang].insert(key);
+                    }
+                }
+                for (const std::string& key : before) {
+                    if (after.count(key)) continue;
+                    auto refIt = refs.find(key);
+                    if (refIt != refs.end() && --refIt->second == 0) {
+                        refs.erase(refIt);
+                        m_watch.usedTags[lang].erase(key);
+                        changedTags[lang].insert(key);
+                    }
+                }
+            }
+            if (!newKeys.empty()) m_watch.categoryKeys[category] = std::move(newKeys);
+        }
+    }
+
+    // Work out which vanilla files, name list folders and static files need attention
+    // Same languages as runCleanupProcess, so a watch rebuild writes the Output a full run would
+    const std::vector<QString> languages = cleanupLanguages(*cycle->mod, cycle->vanillaPath);
+    const QString vanillaRoot = QDir::cleanPath(QFileInfo(cycle->vanillaPath).absoluteFilePath());
+    const QString staticRoot = QDir::cleanPath(QFileInfo(cycle->mod->staticPath).absoluteFilePath());
+    auto isCleanupLanguage = [&languages](const QString& lang) {
+        return std::find(languages.begin(), languages.end(), lang) != languages.end();
+    };
+    QSet<QString> vanillaToProcess;  // "lang/file.yml" or "lang/sub/file.yml"
+    QSet<QString> nameListsToCopy;   // "lang/name_lists"
+    QSet<QString> staticToCopy;      // "lang/file"
+
+    if (cycle->full) {
+        for (const QString& lang : languages) {
+            QDir vanillaLangDir(vanillaRoot + "/" + lang);
+            if (!vanillaLangDir.exists()) {
+                emit logMessage("WARNING: Vanilla language directory does not exist: " + vanillaLangDir.path());
+                continue;
+            }
+            for (const QString& relativePath : VanillaIndex::listFiles(vanillaLangDir.path(), m_vanillaFilter, &m_cancel)) {
+                vanillaToProcess.insert(lang + "/" + relativePath);
+            }
+            nameListsToCopy.insert(lang + "/name_lists");
+            nameListsToCopy.insert(lang + "/random_names");
+        }
+        QDir staticBaseDir(staticRoot);
+        for (const QString& langFolder : staticBaseDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            for (const QString& file : QDir(staticBaseDir.filePath(langFolder)).entryList(QDir::Files | QDir::NoDotAndDotDot)) {
+                staticToCopy.insert(langFolder + "/" + file);
+            }
+        }
+    }
+    else {
+        for (const QString& changed : cycle->changedFiles) {
+            const QString path = QDir::cleanPath(QFileInfo(changed).absoluteFilePath());
+            if (path.startsWith(vanillaRoot + "/")) {
+                const QStringList parts = path.mid(vanillaRoot.size() + 1).split('/');
+                if (parts.size() == 3 && isCleanupLanguage(parts[0]) && (parts[1] == "name_lists" || parts[1] == "random_names")) {
+                    nameListsToCopy.insert(parts[0] + "/" + parts[1]);
+                }
+                else if (parts.size() >= 2 && isCleanupLanguage(parts[0]) && m_vanillaFilter.accepts(parts.mid(1).join('/'))) {
+                    vanillaToProcess.insert(parts.join('/'));
+                }
+            }
+            else if (path.startsWith(staticRoot + "/")) {
+                const QStringList parts = path.mid(staticRoot.size() + 1).split('/');
+                if (parts.size() == 2) staticToCopy.insert(parts.join('/'));
+            }
+        }
+        // Vanilla files holding a key that entered or left the mod set need a new cleaned copy
+        if (!changedTags.empty()) {
+            for (auto it = m_watch.vanillaKeys.constBegin(); it != m_watch.vanillaKeys.constEnd(); ++it) {
+                auto changedIt = changedTags.find(it.key().section('/', 0, 0));
+                if (changedIt == changedTags.end()) continue;
+                for (const std::string& tag : changedIt->second) {
+                    if (it.value().count(tag)) {
+                        vanillaToProcess.insert(it.key());
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Clean the affected vanilla files against the current mod keys
+    QStringList vanillaOrder = vanillaToProcess.values();
+    vanillaOrder.sort();
+    int vanillaWritten = 0;
+    int vanillaDropped = 0;
+    long long keysRemoved = 0;
+    if (!vanillaOrder.isEmpty()) emit statusMessage(QString("Updating %1 vanilla files...").arg(vanillaOrder.size()));
+    for (const QString& relPath : vanillaOrder) {
+        if (m_cancel.isCancelled()) {
+            // Force a full rebuild next time; Output may now be ahead of the kept state
+            m_watch.primed = false;
+            logCancelled("the vanilla update");
+            emit processActive(false);
+            emit statusMessage("Cancelled by user.");
+            emit incrementalFinished(false, "Operation cancelled.");
+            return;
+        }
+        const QString lang = relPath.section('/', 0, 0);
+        const QString inputFile = vanillaRoot + "/" + relPath;
+        const QString cleanedFile = cycle->outputPath + "/" + relPath;
+        if (!QFileInfo::exists(inputFile)) {
+            // Removed from vanilla: forget it and its cleaned copy
+            m_watch.vanillaKeys.remove(relPath);
+            if (m_watch.cleanedFiles.remove(relPath)) {
+                QFile::remove(cleanedFile);
+                vanillaDropped++;
+            }
+            continue;
+        }
+
+        QFileInfo(cleanedFile).absoluteDir().mkpath(".");
+        auto tagsIt = m_watch.usedTags.find(lang);
+        const std::unordered_set<std::string>* modTags = tagsIt != m_watch.usedTags.end() ? &tagsIt->second : nullptr;
+        std::unordered_set<std::string> keys;
+        const int removed = cleanVanillaFile(inputFile, cleanedFile, modTags, m_watch.keyRules, &keys);
+        if (removed < 0) {
+            cycle->success = false;
+            continue;
+        }
+        m_watch.vanillaKeys[relPath] = std::move(keys);
+        if (removed > 0) {
+            m_watch.cleanedFiles.insert(relPath);
+            vanillaWritten++;
+            keysRemoved += removed;
+        }
+        else if (m_watch.cleanedFiles.remove(relPath)) {
+            // Nothing to override any more; the game falls back to the vanilla file
+            QFile::remove(cleanedFile);
+            emit logMessage("INFO: Removed cleaned copy " + cleanedFile + " (no mod keys left in it)");
+            vanillaDropped++;
+        }
+    }
+    if (cycle->full) logKeyRuleMatches(m_watch.keyRules);
+
+    for (const QString& folder : nameListsToCopy) {
+        copyNameListFolder(cycle->vanillaPath, cycle->outputPath, folder.section('/', 0, 0), folder.section('/', 1));
+    }
+
+    // Static files never replace a cleaned vanilla copy of the same name, as in the cleanup task
+    int staticCopied = 0;
+    for (const QString& relPath : staticToCopy) {
+        if (m_watch.cleanedFiles.contains(relPath)) continue;
+        const QString sourceFilePath = staticRoot + "/" + relPath;
+        const QString destFilePath = cycle->outputPath + "/" + relPath;
+        QFile::remove(destFilePath);
+        if (!QFileInfo::exists(sourceFilePath)) continue;
+        QDir(cycle->outputPath).mkpath(relPath.section('/', 0, 0));
+        if (!QFile::copy(sourceFilePath, destFilePath)) {
+            emit logMessage("WARNING: Failed to copy " + sourceFilePath + " to " + destFilePath + " (Permissions issue).");
+            cycle->success = false;
+        }
+        else {
+            staticCopied++;
+        }
+    }
+
+    m_watch.primed = true;
+    emit processActive(false);
+    const QString summary = QString("%1 cycle in %2 ms — changed categories: %3; STH files written: %4, removed: %5; "
+        "vanilla files rewritten: %6 (%7 keys removed), dropped: %8; name list folders: %9; static files: %10")
+        .arg(cycle->full ? "Full" : "Incremental")
+        .arg(cycle->timer.elapsed())
+        .arg(changedCategories.isEmpty() ? QString("none") : changedCategories.join(", "))
+        .arg(sthWritten).arg(sthRemoved)
+        .arg(vanillaWritten).arg(keysRemoved).arg(vanillaDropped)
+        .arg(nameListsToCopy.size()).arg(staticCopied);
+    emit logMessage("SUMMARY: Watch " + summary);
+    emit statusMessage(cycle->success ? "Watch cycle finished" : "Watch cycle finished with errors");
+    emit incrementalFinished(cycle->success, summary);
+}
@@ -10,7 +10,31 @@ class QNetworkReply;
 #include <QWaitCondition>
 #include <QNetworkAccessManager>
 #include <QMutexLocker>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
 #include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "CancellationToken.h"
+#include "KeyRuleSet.h"
+#include "RequestScheduler.h"
+#include "RunHistory.h"
+#include "VanillaIndex.h"
+#include "WorkerMetrics.h"
+
+class ChangeSet;
+class CoverageReport;
+class KeyConflicts;
+class KeyDiffReport;
+class KeyIndex;
+struct ModDefinition;
 
 // Worker class handles background localisation creation and cleanup tasks in a separate thread.
 class Worker : public QObject
@@ -27,12 +51,51 @@ public slots:
     // Starts the cleanup and update process for the selected mod type.
     void doCleanupTask(int modType, const QString& inputPath, const QString& outputPath, const QString& vanillaPath);
 
-    // Request cooperative cancellation (abort in-flight network replies)
+    // Request cooperative cancellation (abort in-flight network replies). Thread-safe: call it directly, a queued
+    // call would wait behind the running task.
     void requestCancel();
 
     // Provide selections JSON (category -> [sheetIds])
     void setSelectionsJson(const QString& selectionsJson) { m_selectionsJson = selectionsJson; }
 
+    // Per-sheet delta export: only sheets whose revision changed are fetched, the rest come from the sheet cache
+    void setDeltaExport(bool enabled) { m_deltaExport = enabled; }
+    void setSheetCacheDirectory(const QString& dir) { m_sheetCacheDir = dir; }
+    // Create runs write the coverage and key conflict reports to <dir>/<mod id>; an empty dir turns them off
+    void setReportDirectory(const QString& dir) { m_reportDir = dir; }
+    // Create runs write key_diff_<mod id>_<time>.csv/.json (keys added, removed and changed since the previous run)
+    // to dir; an empty dir turns it off
+    void setKeyDiffDirectory(const QString& dir) { m_keyDiffDir = dir; }
+
+    // Export requests: at most maxConcurrent at once (the scheduler adapts below that), each attempt aborted after timeoutSec
+    void setRequestLimits(int maxConcurrent, int timeoutSec);
+    // Hedging: an export running past its category's p90 latency gets a duplicate request, the first reply wins.
+    // budgetPercent caps hedges at that share of the attempts (at least one per run); 0 turns hedging off.
+    void setHedgeBudget(int budgetPercent) { m_hedgeBudget = qBound(0, budgetPercent, 100) / 100.0; }
+    // Compact export: column names once per sheet, then value arrays; off asks for the row-object JSON
+    void setCompactExport(bool enabled) { m_compactExport = enabled; }
+
+    // Opens the connections to the mod's Apps Script hosts so the first run skips the handshakes
+    void warmUp(int modType);
+    // Fetches the exports of the given selections in the background; a create run started while one is still
+    // fresh (see setPrefetchMaxAge) uses it instead of requesting the same export again
+    void prefetchExports(int modType, const QString& selectionsJson);
+    void setPrefetchMaxAge(int seconds) { m_prefetchMaxAgeSec = seconds; }
+
+    // Cleanup: check every vanilla file for invalid UTF-8 and log the ones that fail (off by default)
+    void setValidateUtf8(bool enabled) { m_validateUtf8 = enabled; }
+    // Cleanup: globs choosing the vanilla files to clean, searched recursively (see VanillaIndex::Filter)
+    void setVanillaFilter(const QStringList& include, const QStringList& exclude);
+    // Plan mode: create and cleanup compare what they would write with Output and write a change set to the
+    // report directory instead; Output, the sheet cache and the run history are left as they are
+    void setPlanMode(bool enabled) { m_planMode = enabled; }
+
+    // Watch mode: rebuilds only what changed since the previous cycle; the first cycle after a reset is a full rebuild.
+    // changedFiles are paths below the vanilla or static_localisation trees, refreshSheets re-fetches the selected sheets.
+    void doIncrementalTask(int modType, const QString& outputPath, const QString& vanillaPath, const QStringList& changedFiles, bool refreshSheets);
+    // Drops the in-memory watch state so the next incremental cycle starts with a full rebuild
+    void resetWatchState() { m_watch = WatchState(); }
+
 signals:
     // Emitted to log a message (for file or UI logging).
     void logMessage(const QString& message);
@@ -40,25 +103,125 @@ signals:
     void statusMessage(const QString& message);
     // Emitted to update the progress bar in the UI.
     void progressUpdated(int value);
-    // Emitted when a task finishes, indicating success or failure and a message.
-    void taskFinished(bool success, const QString& message);
+    // Emitted when a task finishes, indicating success or failure and a message; cancelled when the token stopped it.
+    void taskFinished(bool success, const QString& message, bool cancelled = false);
 
     // Phase activity signals
     void fetchActive(bool active);
     void processActive(bool active);
 
+    // Throughput counters, queue depths and progress units of the running task, a few times per second
+    void metricsUpdated(const WorkerMetrics& metrics);
+
+    // Emitted when an incremental cycle finishes (separate from taskFinished so no cleanup step is chained)
+    void incrementalFinished(bool success, const QString& summary);
+
 private:
     // Internal method to perform the localisation creation logic.
     void runCreateProcess(int modType, const QString& inputPath, const QString& outputPath, const QString& vanillaPath);
     // Internal method to perform the cleanup and update logic.
     void runCleanupProcess(int modType, const QString& inputPath, const QString& outputPath, const QString& vanillaPath);
 
+    // Drops mod keys and keys matching the rules from one vanilla file; returns removed keys or -1 on I/O errors
+    int cleanVanillaFile(const QString& vanillaInputPath, const QString& cleanedOutputPath,
+        const std::unordered_set<std::string>* modTags, KeyRuleSet& keyRules,
+        std::unordered_set<std::string>* keysOut);
+    // removedLines, if given, receives which of the file's lines were dropped
+    int cleanVanillaFile(const VanillaIndex::File& file, const QString& cleanedOutputPath,
+        const std::unordered_set<std::string>* modTags, KeyRuleSet& keyRules, std::vector<bool>* removedLines = nullptr);
+    // The mod's removedVanillaKeys and the rules of its key rule file; false (logged) if the file is broken
+    bool loadKeyRules(const ModDefinition& mod, KeyRuleSet& keyRules);
+    // Logs how many keys every rule removed
+    void logKeyRuleMatches(const KeyRuleSet& keyRules);
+    // Sends a metrics snapshot (and the progress derived from it) when one is due
+    void publishMetrics(bool force = false);
+    // Counts a reply's downloaded bytes; onProgress gets (received, total) as they come in
+    void trackDownload(QNetworkReply* reply, const std::function<void(qint64, qint64)>& onProgress = nullptr);
+
+    // Logs how long after the cancel request the task stopped
+    void logCancelled(const QString& stage);
+
+    // Replaces Output/<lang>/<subfolder> with the vanilla name_lists or random_names folder
+    void copyNameListFolder(const QString& vanillaPath, const QString& outputPath, const QString& lang, const QString& subfolder);
+
+    // Which sheets of a category the create task fetches and which come from the sheet cache
+    struct CategoryPlan;
+    // Writes one category's STH files from a fetched payload (null when nothing had to be fetched); false on errors
+    bool writeCategoryFiles(const ModDefinition& mod, const QString& category, const QString& fileTemplate, const QString& outputPath,
+        const CategoryPlan& plan, const QByteArray* payload);
+    // Compares a category file about to be written (or removed, with no entries) with its previous version for the key diff
+    void diffCategoryFile(const QString& outputPath, const QString& fileTemplate, const QString& lang, const std::vector<std::string>& entries);
+
+    // Adds one sheet's entries (language -> entries) of the languages the mod writes to the key conflict report and the key index
+    void recordKeys(const ModDefinition& mod, const QString& category, const QString& sheet, const QString& filePattern,
+        const std::unordered_map<std::string, std::vector<std::string>>& entries);
+    // The vanilla index for vanillaPath, shared by the conflict check and the cleanup
+    VanillaIndex& vanillaIndex(const QString& vanillaPath);
+
+    // An export fetched ahead of a run
+    struct PrefetchedExport {
+        QByteArray payload;
+        QHash<qint64, QString> revisions;   // sheet revisions listed just before the export was requested (delta runs compare them)
+        qint64 fetchedAtMs = 0;             // epoch ms when the payload arrived
+        bool pending = true;
+        bool failed = false;
+        QList<std::function<void()>> waiters; // runs waiting for the pending export
+    };
+
+    // One incremental cycle, shared by its fetch callbacks
+    struct IncrementalCycle;
+    // Applies fetched payloads and changed files once every fetch of the cycle is in
+    void finishIncrementalCycle(const std::shared_ptr<IncrementalCycle>& cycle);
+
+    // In-memory state kept between watch mode cycles
+    struct WatchState {
+        bool primed = false;
+        QString outputPath;
+        QString vanillaPath;
+        QHash<QString, QByteArray> payloadHashes;   // category -> hash of its last export payload
+        QHash<QString, QByteArray> entryHashes;     // "category|lang" -> hash of the entries written for it
+        QHash<QString, std::unordered_map<std::string, std::unordered_set<std::string>>> categoryKeys; // category -> lang -> keys
+        std::unordered_map<QString, std::unordered_map<std::string, int>> tagRefs; // lang -> key -> categories providing it
+        std::unordered_map<QString, std::unordered_set<std::string>> usedTags;    // lang -> mod keys
+        QHash<QString, std::unordered_set<std::string>> vanillaKeys;             // "lang/file.yml" -> keys in the vanilla file
+        QSet<QString> cleanedFiles;                                              // "lang/file.yml" with a cleaned copy in Output
+        KeyRuleSet keyRules;                                                     // vanilla keys always dropped, loaded by the full cycle
+    };
+
     bool m_outputFolderClearConfirmed; // Flag to confirm output folder was cleared (not used in current logic).
     QMutex m_mutex;                    // Mutex for thread safety (reserved for future use).
     QWaitCondition m_condition;        // Wait condition for thread synchronization (reserved for future use).
     QNetworkAccessManager* networkManager;
 
     QString m_selectionsJson;          // Cached selections JSON from UI
-    std::atomic<bool> m_cancelRequested { false };
+    CancellationToken m_cancel;            // cancellation of the running task, polled by its loops
     QList<QNetworkReply*> m_activeReplies; // track in-flight requests for immediate abort
+    QList<QTimer*> m_retryTimers;          // backoff waits of failed requests, fired early on cancel (worker thread only)
+    WatchState m_watch;                    // watch mode state reused between incremental cycles
+    bool m_deltaExport = true;             // fetch only sheets whose revision changed since the last create run
+    QString m_sheetCacheDir = "cache/sheets";
+    MetricsTracker m_metrics;              // counters of the running task
+    int m_lastPercent = -1;                // last progress sent from the metrics
+    RequestScheduler m_scheduler;          // concurrency window and retry delays of export requests, kept between runs
+    double m_hedgeBudget = 0.0;            // hedged requests per attempt at most, 0 = no hedging
+    bool m_compactExport = true;           // request the columnar export layout
+    QHash<QString, std::shared_ptr<PrefetchedExport>> m_prefetched; // export URL -> prefetched payload
+    int m_prefetchMaxAgeSec = 120;
+    RunHistory m_history;                  // durations of earlier runs, for the time-left estimate
+    std::function<qint64(qint64)> m_predictRemaining; // elapsed ms -> time left from the history, -1 if unknown
+    bool m_validateUtf8 = false;
+    QString m_reportDir = "reports";
+    std::shared_ptr<CoverageReport> m_coverage;   // coverage of the running create task, null when reports are off
+    std::shared_ptr<KeyConflicts> m_keyConflicts; // keys defined twice in the running create task, null when reports are off
+    QString m_keyDiffDir;
+    std::shared_ptr<KeyDiffReport> m_keyDiff;     // key diff of the running create task, null when it is off
+    QString m_previousOutputDir;                  // previous category files moved aside by a full export, empty if none
+    QSet<QString> m_keyDiffSkipped;               // previous category files that could not be moved aside
+    std::unique_ptr<VanillaIndex> m_vanillaIndex; // parsed vanilla tree shared by every mod and run of this worker
+    VanillaIndex::Filter m_vanillaFilter;          // vanilla files the cleanup works on
+    bool m_planMode = false;
+    std::shared_ptr<KeyIndex> m_keyIndex;         // key index built from a create task's sheets and its cleanup's files
+    std::shared_ptr<KeyIndex> m_previousKeyIndex; // the last saved key index during a create task, null if there is none
+    QDateTime m_previousKeyIndexTime;
+    std::shared_ptr<ChangeSet> m_changeSet;       // change set of the running plan, from its create step to the end of its cleanup
 };
\ No newline at end of file